@@ -22,6 +22,15 @@
 #include "channel_array_item.h" //struct ChannelArrayItem
 #include "zvm.h" // struct ZVMChannel;
 #include "fcntl.h" //struct flock
+#include "io_stats.h" //struct IoStats
+
+/*Channel data read in advance, by read-ahead or prefetch*/
+struct ChannelCache{
+    char*   buf;
+    int32_t bufsize;               /*allocated size*/
+    int32_t datasize;              /*size of cached data*/
+    int64_t pos;                   /*channel position of first cached byte*/
+};
 
 /*Channel info we need to keep at runtime(For opened channels)
  *suitable data is: opened flags, mode, i/o positions*/
@@ -35,6 +44,9 @@ struct ZrtChannelRt{
     int     mode;                  /*channel type, taken from mapping nvram section*/
     int     emu;                   /*equal to 1 if it's emulated channel (not provided by zerovm)*/
     struct flock fcntl_flock;      /*lock flag for support fcntl locking function*/
+    struct IoStats stats;          /*read/write statistics of channel*/
+    int     readahead;             /*read-ahead size for sequential reads, 0 if disabled*/
+    struct ChannelCache cache;     /*data cached by read-ahead or fadvise*/
 };
 
 
@@ -38,6 +38,7 @@
 	    /*alloc item*/						\
 	    item = malloc(sizeof(struct ChannelArrayItem));		\
 	    item->channel = &(channels_array_p)[i];			\
+	    memset(&item->channel_runtime, '\0', sizeof(struct ZrtChannelRt)); \
 	    item->channel_runtime.flags = -1;				\
 	    if ( (check) == EMU_CHANNELS ){				\
 		item->channel_runtime.emu = 1;				\
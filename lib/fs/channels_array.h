@@ -38,7 +38,7 @@ struct ChannelsArrayPublicInterface{
 };
 
 
-/*@return result pointer can be casted to struct BitArray*/
+/*@return result pointer can be casted to struct ChannelsArray*/
 struct ChannelsArrayPublicInterface* 
 channels_array_construct(const struct ZVMChannel* zvm_channels, 
 			 int zvm_channels_count,
@@ -26,6 +26,7 @@
 #include <sys/types.h>
 #include <sys/time.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include "string.h"
 #include <stdio.h>
 #include <stdlib.h>
@@ -46,6 +47,11 @@
 #include "channels_mount.h"
 #include "channels_mount_magic_numbers.h"
 #include "channels_array.h"
+#include "utils.h"
+#include "random_generator.h"
+#include "io_stats.h"
+#include "meminfo.h"
+#include "channels_reserved.h"
 
 enum PosAccess{ EPosSeek=0, EPosRead, EPosWrite };
 enum PosWhence{ EPosGet=0, EPosSetAbsolute, EPosSetRelative };
@@ -70,6 +76,12 @@ enum PosWhence{ EPosGet=0, EPosSetAbsolute, EPosSetRelative };
 #define CHANNEL_SIZE(channel_item) (channel_item) ?			\
 						  MAX( (channel_item)->channel_runtime.maxsize, (channel_item)->channel->size ) : (channel_item)->channel->size;
 
+/*channel type allows positional access for given access direction*/
+#define CHANNEL_IS_RANDOM_ACCESS(item_p, access)			\
+    ( (access) == EPosRead ?						\
+      ((item_p)->channel->type == RGetSPut || (item_p)->channel->type == RGetRPut) : \
+      ((item_p)->channel->type == SGetRPut || (item_p)->channel->type == RGetRPut) )
+
 #define CHANNEL_ASSERT_IF_FAIL( channels_array, handle )  assert( CHANNEL_ITEM((channels_array), handle) != NULL )
 
 
@@ -162,6 +174,11 @@ mount_specific_construct( struct MountSpecificPublicInterface* specific_implem_i
     return (struct MountSpecificPublicInterface*)this;
 }
 
+/*text report of emulated read-only device*/
+struct ReportSnapshot{
+    char* data;
+    int   len;
+};
 
 struct ChannelMounts{
     struct MountsPublicInterface public;
@@ -169,6 +186,10 @@ struct ChannelMounts{
     struct HandleAllocator* handle_allocator;
     struct ChannelsArrayPublicInterface* channels_array;
     struct MountSpecificPublicInterface* mount_specific_interface;
+    struct RandomGenerator random_generator; /*used by emulated random devices*/
+    struct IoStats stats;       /*read/write statistics of all channels*/
+    struct ReportSnapshot stat_snapshot;    /*report served by DEV_ZRTSTAT*/
+    struct ReportSnapshot meminfo_snapshot; /*report served by DEV_MEMINFO*/
 };
 
 
@@ -246,6 +267,11 @@ static int open_channel( struct ChannelMounts* this, const char *name, int flags
 
     /*modify channel runtime info*/
     item->channel_runtime.flags = flags;
+    /*statistics reports are read from beginning after every open*/
+    if ( item->channel_runtime.emu && 
+	 (!strcmp(DEV_ZRTSTAT, CHANNEL_NAME(item)) || !strcmp(DEV_MEMINFO, CHANNEL_NAME(item))) ){
+	item->channel_runtime.sequential_access_pos = 0;
+    }
 
 #ifdef DEBUG
     debug_mes_zrt_channel_runtime(item, handle);
@@ -545,6 +571,104 @@ int iterate_dir_contents( struct ChannelMounts* this, int dir_handle, int index,
     return -1;/*specified index not matched, probabbly it's out of bounds*/
 }
 
+/*make sure cache buffer can hold size bytes
+ *@return 0 if ok, -1 if no memory*/
+static int channel_cache_reserve(struct ChannelCache* cache, int32_t size){
+    if ( cache->bufsize < size ){
+	char* buf = realloc(cache->buf, size);
+	if ( buf == NULL ) return -1;
+	cache->buf = buf;
+	cache->bufsize = size;
+    }
+    return 0;
+}
+
+static void channel_cache_free(struct ChannelCache* cache){
+    free(cache->buf);
+    memset(cache, '\0', sizeof(struct ChannelCache));
+}
+
+/*Read channel data starting from cached data. If read-ahead enabled
+ *then small reads are done by read-ahead sized requests and the rest
+ *of data is kept in cache. Sequential channel returns only cached
+ *data if it's available, to do not block on reading.
+ *@return readed bytes or negative errno returned by zvm_pread*/
+static int32_t channel_cached_read(struct ChannelArrayItem* item, int fd, 
+				   char *buf, size_t nbyte, int64_t pos){
+    struct ChannelCache* cache = &item->channel_runtime.cache;
+    int32_t readed=0, res;
+    if ( cache->datasize > 0 && pos >= cache->pos && pos < cache->pos + cache->datasize ){
+	readed = MIN((int64_t)nbyte, cache->pos + cache->datasize - pos);
+	memcpy(buf, cache->buf + (pos - cache->pos), readed);
+	if ( readed == nbyte || !CHANNEL_IS_RANDOM_ACCESS(item, EPosRead) )
+	    return readed;
+	pos += readed;
+    }
+    /*fill cache by single big read*/
+    if ( item->channel_runtime.readahead > nbyte-readed &&
+	 channel_cache_reserve(cache, item->channel_runtime.readahead) == 0 ){
+	cache->datasize = 0;
+	res = zvm_pread(fd, cache->buf, item->channel_runtime.readahead, pos);
+	if ( res < 0 ) return readed > 0 ? readed : res;
+	cache->pos = pos;
+	cache->datasize = res;
+	res = MIN(res, (int32_t)(nbyte-readed));
+	memcpy(buf+readed, cache->buf, res);
+	return readed+res;
+    }
+    res = zvm_pread(fd, buf+readed, nbyte-readed, pos);
+    if ( res < 0 ) return readed > 0 ? readed : res;
+    return readed+res;
+}
+
+/*Read range of random access channel into cache, it's advisory so
+ *failure is only logged and cache stays empty*/
+static void channel_prefetch(struct ChannelArrayItem* item, int fd, off_t offset, off_t len){
+    struct ChannelCache* cache = &item->channel_runtime.cache;
+    if ( len == 0 ) len = item->channel->size - offset; /*up to the end*/
+    len = MIN(len, CHANNEL_PREFETCH_MAX_SIZE);
+    if ( len <= 0 ) return;
+    cache->datasize = 0;
+    if ( channel_cache_reserve(cache, len) == -1 ){
+	ZRT_LOG(L_ERROR, "no memory to prefetch %lld bytes of channel=%s", 
+		(int64_t)len, CHANNEL_NAME(item));
+	return;
+    }
+    int32_t res = zvm_pread(fd, cache->buf, len, offset);
+    if ( res < 0 ){
+	ZRT_LOG(L_ERROR, "prefetch channel=%s error=%d", CHANNEL_NAME(item), res);
+	return;
+    }
+    cache->pos = offset;
+    cache->datasize = res;
+    ZRT_LOG(L_INFO, "prefetched %d bytes of channel=%s at offset=%lld", 
+	    res, CHANNEL_NAME(item), (int64_t)offset);
+}
+
+/*Serve statistics report, it is regenerated every time when reading
+ *from beginning, so reader gets consistent snapshot
+ *@param report snprintf like function formatting report*/
+static int emu_read_report_snapshot(struct ChannelMounts* this, int fd, 
+				    struct ReportSnapshot* snapshot, int (*report)(char*, int),
+				    void *buf, size_t nbyte){
+    int64_t pos = channel_pos(this, fd, EPosGet, EPosRead, 0);
+    if ( pos == 0 || snapshot->data == NULL ){
+	int len = report(NULL, 0);
+	char* data = realloc(snapshot->data, len+1);
+	if ( data == NULL ){
+	    SET_ERRNO(ENOMEM);
+	    return -1;
+	}
+	snapshot->data = data;
+	snapshot->len = report(snapshot->data, len+1);
+	snapshot->len = MIN(snapshot->len, len);
+    }
+    if ( pos >= snapshot->len ) return 0;
+    nbyte = MIN((int64_t)nbyte, snapshot->len-pos);
+    memcpy(buf, snapshot->data+pos, nbyte);
+    return nbyte;
+}
+
 /*If it's emulated channel and channel not provided by zerovm, then emulate it*/
 static int emu_handle_read(struct ChannelMounts* this, int fd, void *buf, size_t nbyte, int* handled){
     struct ChannelArrayItem* item = this->channels_array->get(this->channels_array, fd);
@@ -561,16 +685,22 @@ static int emu_handle_read(struct ChannelMounts* this, int fd, void *buf, size_t
 	}
 	else if ( !strcmp("/dev/random", item->channel->name) ||
 		  !strcmp("/dev/urandom", item->channel->name) ){
-	    int i, r=0;
-	    srand(time(NULL));
-	    for ( i=0; i < nbyte; i++ ){
-		if ( i % 4 == 0 ) 
-		    r = rand();
-		((char*)buf)[i] = ((char*)&r)[i%4];
-	    }
+	    struct RandomGeneratorPublicInterface* random_generator = 
+		&this->random_generator.public;
+	    random_generator->fill(random_generator, buf, nbyte);
 	    *handled=1;
 	    return nbyte;
 	}
+	else if ( !strcmp(DEV_ZRTSTAT, item->channel->name) ){
+	    *handled=1;
+	    return emu_read_report_snapshot(this, fd, &this->stat_snapshot, io_stats_report,
+					    buf, nbyte);
+	}
+	else if ( !strcmp(DEV_MEMINFO, item->channel->name) ){
+	    *handled=1;
+	    return emu_read_report_snapshot(this, fd, &this->meminfo_snapshot, meminfo_report,
+					    buf, nbyte);
+	}
     }
     *handled=0;
     return -1; /*not handled*/
@@ -595,6 +725,12 @@ static int emu_handle_write(struct ChannelMounts* this, int fd, const void *buf,
 	    *handled=1;
 	    return nbyte;
 	}
+	else if ( !strcmp(DEV_ZRTSTAT, item->channel->name) ||
+		  !strcmp(DEV_MEMINFO, item->channel->name) ){
+	    SET_ERRNO(EINVAL);
+	    *handled=1;
+	    return -1;
+	}
     }
     *handled=0;
     return -1; /*not handled*/
@@ -659,7 +795,7 @@ static int channels_mount(struct ChannelMounts* this, const char* path, void *mo
     return -1;
 }
 
-static ssize_t channels_read(struct ChannelMounts* this, int fd, void *buf, size_t nbyte){
+static ssize_t channels_read_nostat(struct ChannelMounts* this, int fd, void *buf, size_t nbyte){
     errno = 0;
     int32_t readed = 0;
     struct ChannelArrayItem* item = CHANNEL_ITEM(this->channels_array, fd);
@@ -693,7 +829,7 @@ static ssize_t channels_read(struct ChannelMounts* this, int fd, void *buf, size
     /*try to read from emulated channel, else read via zvm_pread call */
     int handled=0;
     if ( (readed=emu_handle_read(this, fd, buf, nbyte, &handled)) == -1 && !handled )
-	readed = zvm_pread(fd, buf, nbyte, pos );
+	readed = channel_cached_read(item, fd, buf, nbyte, pos );
     if(readed > 0) channel_pos(this, fd, EPosSetRelative, EPosRead, readed);
 
     ZRT_LOG(L_EXTRA, "channel fd=%d, bytes readed=%d", fd, readed );
@@ -707,7 +843,7 @@ static ssize_t channels_read(struct ChannelMounts* this, int fd, void *buf, size
     return readed;
 }
 
-static ssize_t channels_write(struct ChannelMounts* this,int fd, const void *buf, size_t nbyte){
+static ssize_t channels_write_nostat(struct ChannelMounts* this,int fd, const void *buf, size_t nbyte){
     int32_t wrote = 0;
     struct ChannelArrayItem* item = CHANNEL_ITEM(this->channels_array, fd);
 
@@ -744,6 +880,9 @@ static ssize_t channels_write(struct ChannelMounts* this,int fd, const void *buf
     if ( (wrote=emu_handle_write(this, fd, buf, nbyte, &handled)) == -1 && !handled )
 	wrote = zvm_pwrite(fd, buf, nbyte, pos );
     if(wrote > 0) channel_pos(this, fd, EPosSetRelative, EPosWrite, wrote);
+    /*data cached for random reading could be overwritten*/
+    if(wrote > 0 && CHANNEL_IS_RANDOM_ACCESS(item, EPosRead)) 
+	item->channel_runtime.cache.datasize = 0;
     ZRT_LOG(L_EXTRA, "channel fd=%d, bytes wrote=%d", fd, wrote);
 
     if ( wrote < 0 ){
@@ -764,6 +903,30 @@ static ssize_t channels_write(struct ChannelMounts* this,int fd, const void *buf
     return wrote;
 }
 
+/*account call result in channel and mount statistics*/
+static void channels_update_stats(struct ChannelMounts* this, int fd, int op, 
+				  size_t nbyte, ssize_t result, uint64_t start_ticks){
+    struct ChannelArrayItem* item = CHANNEL_ITEM(this->channels_array, fd);
+    if ( item != NULL ){
+	IO_STATS_UPDATE(&item->channel_runtime.stats, op, nbyte, result, start_ticks);
+    }
+    IO_STATS_UPDATE(&this->stats, op, nbyte, result, start_ticks);
+}
+
+static ssize_t channels_read(struct ChannelMounts* this, int fd, void *buf, size_t nbyte){
+    uint64_t start_ticks = cpu_ticks();
+    ssize_t readed = channels_read_nostat(this, fd, buf, nbyte);
+    channels_update_stats(this, fd, EIoStatsRead, nbyte, readed, start_ticks);
+    return readed;
+}
+
+static ssize_t channels_write(struct ChannelMounts* this,int fd, const void *buf, size_t nbyte){
+    uint64_t start_ticks = cpu_ticks();
+    ssize_t wrote = channels_write_nostat(this, fd, buf, nbyte);
+    channels_update_stats(this, fd, EIoStatsWrite, nbyte, wrote, start_ticks);
+    return wrote;
+}
+
 static int channels_fchmod(struct ChannelMounts* this,int fd, mode_t mode){
     SET_ERRNO(EPERM);
     return -1;
@@ -861,6 +1024,19 @@ static int channels_close(struct ChannelMounts* this,int fd){
 
     /*if valid fd and file was opened previously then perform file close*/
     if ( CHANNEL_IS_OPENED( item ) != 0  )	{
+	struct ChannelCache* cache = &item->channel_runtime.cache;
+	int64_t consumed = channel_pos(this, fd, EPosGet, EPosRead, 0) - cache->pos;
+	if ( !CHANNEL_IS_RANDOM_ACCESS(item, EPosRead) && 
+	     consumed >= 0 && consumed < cache->datasize ){
+	    /*read position is reset, but unconsumed data of sequential
+	      channel can't be read again, so keep it at new position*/
+	    cache->datasize -= consumed;
+	    memmove(cache->buf, cache->buf+consumed, cache->datasize);
+	    cache->pos = 0;
+	}
+	else
+	    channel_cache_free(cache);
+	item->channel_runtime.readahead = 0;
 	item->channel_runtime.random_access_pos 
 	    = item->channel_runtime.sequential_access_pos  = 0;
 #define SAVE_SYNTHETIC_SIZE
@@ -1052,6 +1228,178 @@ static int channels_fchown(struct ChannelMounts* this,int f, uid_t u, gid_t g){
     return -1;
 }
 
+/*@return count of iovecs starting from first one that fit together into
+ *staging buffer, 0 if first iovec is big enough to be handled directly*/
+static int channels_iov_staged_count(const struct iovec *iov, int iovcnt, size_t* staged_len){
+    int i;
+    *staged_len = 0;
+    for ( i=0; i < iovcnt && *staged_len + iov[i].iov_len <= CHANNEL_IOV_STAGING_SIZE; i++ ){
+	*staged_len += iov[i].iov_len;
+    }
+    /*single iovec needs no staging*/
+    return i > 1 ? i : 0;
+}
+
+/*Vectored read gathers runs of small iovecs into one zvm_pread into
+ *bounded staging buffer and then scatters data over user buffers,
+ *instead of zvm call per iovec; big iovecs are read directly*/
+static ssize_t channels_readv(struct ChannelMounts* this, int fd, const struct iovec *iov, int iovcnt){
+    ssize_t len = iovec_length(iov, iovcnt);
+    if ( len == -1 ) return -1; /*errno already set*/
+
+    /*nothing to gather, read directly into user buffer*/
+    if ( iovcnt == 1 || len == 0 )
+	return channels_read(this, fd, iovcnt > 0 ? iov[0].iov_base : NULL, len);
+
+    /*if no memory for staging buffer, read by iovec*/
+    char* staging = malloc(CHANNEL_IOV_STAGING_SIZE);
+    ssize_t readed, total=0;
+    size_t wanted;
+    int i, staged;
+    for ( i=0; i < iovcnt; i += staged ? staged : 1 ){
+	staged = staging != NULL ? channels_iov_staged_count(iov+i, iovcnt-i, &wanted) : 0;
+	if ( staged ){
+	    readed = channels_read(this, fd, staging, wanted);
+	    if ( readed > 0 ) iovec_scatter(iov+i, staged, staging, readed);
+	}
+	else{
+	    wanted = iov[i].iov_len;
+	    readed = channels_read(this, fd, iov[i].iov_base, wanted);
+	}
+	if ( readed < 0 ){
+	    if ( total == 0 ) total = -1; /*errno already set*/
+	    break;
+	}
+	total += readed;
+	if ( (size_t)readed < wanted ) break; /*EOF or short read*/
+    }
+    free(staging);
+    return total;
+}
+
+/*Vectored write gathers runs of small iovecs into bounded staging
+ *buffer to do one zvm_pwrite, instead of zvm call per iovec; big
+ *iovecs are written directly*/
+static ssize_t channels_writev(struct ChannelMounts* this, int fd, const struct iovec *iov, int iovcnt){
+    ssize_t len = iovec_length(iov, iovcnt);
+    if ( len == -1 ) return -1; /*errno already set*/
+
+    /*nothing to gather, write directly from user buffer*/
+    if ( iovcnt == 1 || len == 0 )
+	return channels_write(this, fd, iovcnt > 0 ? iov[0].iov_base : NULL, len);
+
+    /*if no memory for staging buffer, write by iovec*/
+    char* staging = malloc(CHANNEL_IOV_STAGING_SIZE);
+    ssize_t wrote, total=0;
+    size_t wanted;
+    int i, staged;
+    for ( i=0; i < iovcnt; i += staged ? staged : 1 ){
+	staged = staging != NULL ? channels_iov_staged_count(iov+i, iovcnt-i, &wanted) : 0;
+	if ( staged ){
+	    iovec_gather(staging, iov+i, staged);
+	    wrote = channels_write(this, fd, staging, wanted);
+	}
+	else{
+	    wanted = iov[i].iov_len;
+	    wrote = channels_write(this, fd, iov[i].iov_base, wanted);
+	}
+	if ( wrote < 0 ){
+	    if ( total == 0 ) total = -1; /*errno already set*/
+	    break;
+	}
+	total += wrote;
+	if ( (size_t)wrote < wanted ) break; /*short write*/
+    }
+    free(staging);
+    return total;
+}
+
+/*positional read/write are supported only by channels having random
+ *access for requested direction, channel position will be restored*/
+static ssize_t channels_positional_rw(struct ChannelMounts* this, int fd, 
+				      const struct iovec *iov, int iovcnt, off_t offset, 
+				      int8_t access){
+    struct ChannelArrayItem* item = CHANNEL_ITEM(this->channels_array, fd);
+    if ( CHANNEL_IS_OPENED(item) == 0 ){
+	SET_ERRNO( EBADF );
+	return -1;
+    }
+    if ( !CHANNEL_IS_RANDOM_ACCESS(item, access) ){
+	ZRT_LOG(L_ERROR, "channel=%s not supported positional access", CHANNEL_NAME(item));
+	SET_ERRNO( ESPIPE );
+	return -1;
+    }
+    if ( offset < 0 ){
+	SET_ERRNO( EINVAL );
+	return -1;
+    }
+
+    ssize_t ret;
+    int64_t saved_maxsize = item->channel_runtime.maxsize;
+    int64_t saved_pos = channel_pos(this, fd, EPosGet, access, 0);
+    channel_pos(this, fd, EPosSetAbsolute, access, offset);
+    if ( access == EPosRead )
+	ret = channels_readv(this, fd, iov, iovcnt);
+    else{
+	ret = channels_writev(this, fd, iov, iovcnt);
+	/*write in the middle of channel should not reduce synthetic size*/
+	item->channel_runtime.maxsize = MAX(saved_maxsize, item->channel_runtime.maxsize);
+    }
+    channel_pos(this, fd, EPosSetAbsolute, access, saved_pos);
+    return ret;
+}
+
+static ssize_t channels_preadv(struct ChannelMounts* this, int fd, const struct iovec *iov, int iovcnt,
+			       off_t offset){
+    return channels_positional_rw(this, fd, iov, iovcnt, offset, EPosRead);
+}
+
+static ssize_t channels_pwritev(struct ChannelMounts* this, int fd, const struct iovec *iov, int iovcnt,
+				off_t offset){
+    return channels_positional_rw(this, fd, iov, iovcnt, offset, EPosWrite);
+}
+
+static int channels_fadvise(struct ChannelMounts* this, int fd, off_t offset, off_t len, int advice){
+    struct ChannelArrayItem* item = CHANNEL_ITEM(this->channels_array, fd);
+    if ( CHANNEL_IS_OPENED(item) == 0 ){
+	SET_ERRNO( EBADF );
+	return -1;
+    }
+    /*emulated channels are not cached*/
+    if ( item->channel_runtime.emu ) return 0;
+
+    ZRT_LOG(L_INFO, "channel=%s advice=%d", CHANNEL_NAME(item), advice);
+    switch( advice ){
+    case POSIX_FADV_SEQUENTIAL:
+	item->channel_runtime.readahead = CHANNEL_READAHEAD_SIZE;
+	break;
+    case POSIX_FADV_NORMAL:
+    case POSIX_FADV_RANDOM:
+	item->channel_runtime.readahead = 0;
+	break;
+    case POSIX_FADV_WILLNEED:
+	/*only random access channel can be read at given offset*/
+	if ( CHANNEL_IS_RANDOM_ACCESS(item, EPosRead) ) 
+	    channel_prefetch(item, fd, offset, len);
+	break;
+    case POSIX_FADV_DONTNEED:
+	/*sequential channel data can't be read again, keep it*/
+	if ( CHANNEL_IS_RANDOM_ACCESS(item, EPosRead) ) 
+	    channel_cache_free(&item->channel_runtime.cache);
+	break;
+    default:
+	break;
+    }
+    return 0;
+}
+
+/*channels data is not stored by zrt, so no direct access*/
+static int channels_direct_buffer(struct ChannelMounts* this, int fd, off_t offset, size_t *count,
+				  int for_write, void **ptr){
+    SET_ERRNO(ENOSYS);
+    return -1;
+}
+
 struct MountSpecificPublicInterface* channels_implem(struct ChannelMounts* this){
     return this->mount_specific_interface;
 }
@@ -1086,6 +1434,12 @@ static struct MountsPublicInterface KChannels_mount = {
     (void*)channels_dup,
     (void*)channels_dup2,
     (void*)channels_link,
+    (void*)channels_readv,
+    (void*)channels_writev,
+    (void*)channels_preadv,
+    (void*)channels_pwritev,
+    (void*)channels_direct_buffer,
+    (void*)channels_fadvise,
     EChannelsMountId,
     (void*)channels_implem  /*mount_specific_interface*/
 };
@@ -1111,10 +1465,21 @@ void mode_updater_set_channel_mode(struct ChannelsModeUpdaterPublicInterface* th
 
 
 
+/*used by random nvram section for deterministic seeding of random devices*/
+void mode_updater_set_random_seed(struct ChannelsModeUpdaterPublicInterface* this, 
+				  uint64_t seed){
+    struct ChannelsModeUpdater* this_ = (struct ChannelsModeUpdater*)this;
+    struct ChannelMounts* mounts = (struct ChannelMounts*)this_->channels_mount;
+    struct RandomGeneratorPublicInterface* random_generator = 
+	&mounts->random_generator.public;
+    random_generator->seed(random_generator, seed);
+}
+
 struct ChannelsModeUpdaterPublicInterface*
 channel_mode_updater_construct(struct MountsPublicInterface* channels_mount){
     struct ChannelsModeUpdater* this = malloc(sizeof(struct ChannelsModeUpdater));
     this->public.set_channel_mode = mode_updater_set_channel_mode;
+    this->public.set_random_seed = mode_updater_set_random_seed;
     this->channels_mount = channels_mount;
 
     return (struct ChannelsModeUpdaterPublicInterface*)this;
@@ -1139,6 +1504,24 @@ channels_filesystem_construct( struct ChannelsModeUpdaterPublicInterface** mode_
 	CONSTRUCT_L(MOUNT_SPECIFIC)( &KMountSpecificImplem,
 				     this->channels_array);
     this->manifest_dirs.dircount=0;
+    /*seed can be overriden later by nvram to get reproducible output*/
+    CONSTRUCT_L(RANDOM_GENERATOR)( random_session_seed(), &this->random_generator );
+    this->stat_snapshot.data = NULL;
+    this->stat_snapshot.len = 0;
+    this->meminfo_snapshot.data = NULL;
+    this->meminfo_snapshot.len = 0;
+    /*register mount statistics and statistics of every channel, if
+      it's failed then statistics are only not reported*/
+    int k, res;
+    res = io_stats_register("channels", EIoStatsMount, &this->stats);
+    for ( k=0; k < this->channels_array->count(this->channels_array); k++ ){
+	struct ChannelArrayItem* item = CHANNEL_ITEM(this->channels_array, k);
+	res |= io_stats_register(CHANNEL_NAME(item), EIoStatsChannel, 
+				 &item->channel_runtime.stats);
+    }
+    if ( res != 0 ){
+	ZRT_LOG(L_ERROR, "channels aren't added into io stats report, errno=%d", errno);
+    }
 
     *mode_updater = CONSTRUCT_L(CHANNEL_MODE_UPDATER)((struct MountsPublicInterface*)this);
     
@@ -20,6 +20,7 @@
 #define CHANNELS_MOUNT_H_
 
 #include <fcntl.h>
+#include <stdint.h>
 #include "mounts_interface.h" //struct MountsPublicInterface
 
 #include "zrt_defines.h" //CONSTRUCT_L
@@ -39,6 +40,9 @@ struct ChannelsModeUpdaterPublicInterface{
     /*used by mapping nvram section for setting custom channel type*/
     void (*set_channel_mode)(struct ChannelsModeUpdaterPublicInterface* this_, 
 			     const char* channel_name, uint mode);
+    /*used by random nvram section for seeding emulated random devices*/
+    void (*set_random_seed)(struct ChannelsModeUpdaterPublicInterface* this_, 
+			    uint64_t seed);
 };
 
 /*@param mode_updater Create object and set provided pointer*/
@@ -32,3 +32,11 @@
 #define DEV_OWNER_UID             1000
 /* group ID of owner, it's value unused in further */
 #define DEV_OWNER_GID             1000
+
+/* read-ahead size for sequential channels advised by POSIX_FADV_SEQUENTIAL */
+#define CHANNEL_READAHEAD_SIZE    0x40000
+/* maximum size of random access channel range cached by POSIX_FADV_WILLNEED */
+#define CHANNEL_PREFETCH_MAX_SIZE 0x400000
+/* size of buffer gathering small iovecs of readv/writev into single
+ * channel call, bigger iovecs are read/written directly */
+#define CHANNEL_IOV_STAGING_SIZE  0x10000
@@ -25,5 +25,7 @@
 #define DEV_STDERR "/dev/stderr"
 #define DEV_NVRAM  "/dev/nvram"
 #define DEV_DEBUG  "/dev/debug"
+#define DEV_ZRTSTAT "/dev/zrtstat" /*emulated, read-only I/O statistics*/
+#define DEV_MEMINFO "/dev/meminfo" /*emulated, read-only memory usage*/
 
 #endif //__CHANNELS_RESERVED_H__
@@ -0,0 +1,107 @@
+/*
+ *
+ * Copyright (c) 2013, LiteStack, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#include "zrtlog.h"
+#include "zrt_helper_macros.h"
+#include "dyn_array.h"
+#include "io_stats.h"
+
+#define IO_STATS_LINE_MAX 256
+#define IO_STATS_HEADER "#kind name op calls bytes short errors ticks\n"
+
+struct IoStatsEntry{
+    const char*     name;
+    int             kind;
+    struct IoStats* stats;
+};
+
+static struct DynArray s_io_stats_entries;
+static int             s_io_stats_entries_inited;
+
+static const char* s_io_stats_op_names[EIoStatsOpCount] = { "read", "write" };
+static const char* s_io_stats_kind_names[] = { "mount", "channel" };
+
+int io_stats_register(const char* name, int kind, struct IoStats* stats){
+    struct IoStatsEntry* entry;
+    /*statistics are updated even if they are not reported*/
+    memset(stats, '\0', sizeof(struct IoStats));
+    if ( !s_io_stats_entries_inited ){
+	if ( !DynArrayCtor( &s_io_stats_entries, 16 ) ){
+	    SET_ERRNO(ENOMEM);
+	    return -1;
+	}
+	s_io_stats_entries_inited = 1;
+    }
+    if ( (entry = malloc(sizeof(struct IoStatsEntry))) == NULL ){
+	SET_ERRNO(ENOMEM);
+	return -1;
+    }
+    entry->name = name;
+    entry->kind = kind;
+    entry->stats = stats;
+    if ( !DynArraySet( &s_io_stats_entries, s_io_stats_entries.num_entries, entry ) ){
+	free(entry);
+	SET_ERRNO(ENOMEM);
+	return -1;
+    }
+    return 0;
+}
+
+/*@return formatted length of all lines related to entry*/
+static int io_stats_format_entry(char* buf, int size, const struct IoStatsEntry* entry){
+    int op, len=0, res;
+    const struct IoStatsItem* item;
+    for ( op=0; op < EIoStatsOpCount; op++ ){
+	item = &entry->stats->op[op];
+	/*unused channels are not reported*/
+	if ( entry->kind == EIoStatsChannel && item->calls == 0 ) continue;
+	res = snprintf(buf+len, size > len ? size-len : 0,
+		       "%s %s %s %llu %llu %llu %llu %llu\n",
+		       s_io_stats_kind_names[entry->kind], entry->name, s_io_stats_op_names[op],
+		       (unsigned long long)item->calls, (unsigned long long)item->bytes,
+		       (unsigned long long)item->short_calls, (unsigned long long)item->errors,
+		       (unsigned long long)item->ticks );
+	if ( res > 0 ) len += res;
+    }
+    return len;
+}
+
+int io_stats_report(char* buf, int size){
+    int i, len;
+    len = snprintf(buf, size, IO_STATS_HEADER);
+    for ( i=0; s_io_stats_entries_inited && i < s_io_stats_entries.num_entries; i++ ){
+	len += io_stats_format_entry(buf+MIN(len, size), size > len ? size-len : 0,
+				     DynArrayGet(&s_io_stats_entries, i));
+    }
+    return len;
+}
+
+void io_stats_log_report(){
+    char line[IO_STATS_LINE_MAX*EIoStatsOpCount];
+    int i;
+    ZRT_LOG(L_BASE, "%s", "I/O statistics " IO_STATS_HEADER);
+    for ( i=0; s_io_stats_entries_inited && i < s_io_stats_entries.num_entries; i++ ){
+	if ( io_stats_format_entry(line, sizeof(line), DynArrayGet(&s_io_stats_entries, i)) > 0 ){
+	    ZRT_LOG(L_BASE, "%s", line);
+	}
+    }
+}
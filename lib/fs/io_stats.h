@@ -0,0 +1,76 @@
+/*
+ *
+ * Copyright (c) 2013, LiteStack, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef __IO_STATS_H__
+#define __IO_STATS_H__
+
+#include <stdint.h>
+
+#include "ticks.h" /*cpu_ticks*/
+
+/*I/O statistics collected per channel and per mount. Time is measured
+ *in cpu ticks, because zrt time functions are synthetic and calling
+ *them would change time visible to user*/
+
+enum { EIoStatsRead=0, EIoStatsWrite, EIoStatsOpCount };
+enum { EIoStatsMount=0, EIoStatsChannel };
+
+struct IoStatsItem{
+    uint64_t calls;
+    uint64_t bytes;
+    uint64_t short_calls; /*result is less than requested*/
+    uint64_t errors;
+    uint64_t ticks;       /*cumulative time spent*/
+};
+
+struct IoStats{
+    struct IoStatsItem op[EIoStatsOpCount];
+};
+
+/*update statistics by result of single read/write call
+ *@param stats_p can be NULL, then nothing happens*/
+#define IO_STATS_UPDATE(stats_p, opindex, requested, result, start_ticks){ \
+	if ( (stats_p) != NULL ){					\
+	    struct IoStatsItem* item_123 = &(stats_p)->op[opindex];	\
+	    ++item_123->calls;						\
+	    item_123->ticks += cpu_ticks() - (start_ticks);	\
+	    if ( (result) < 0 )						\
+		++item_123->errors;					\
+	    else{							\
+		item_123->bytes += (result);				\
+		if ( (size_t)(result) < (size_t)(requested) )		\
+		    ++item_123->short_calls;				\
+	    }								\
+	}								\
+    }
+
+/*Add statistics object to be reported, name should not be freed
+ *while stats in use. Objects of kind EIoStatsMount are reported
+ *always, channels only if it was used. stats are zeroed in any case
+ *@return 0 if added, -1 and errno ENOMEM if no memory*/
+int io_stats_register(const char* name, int kind, struct IoStats* stats);
+
+/*format statistics report of all registered objects as text
+ *@return length of whole report, if it's bigger than size then
+ *report was truncated, like snprintf does*/
+int io_stats_report(char* buf, int size);
+
+/*write report into debug log*/
+void io_stats_log_report();
+
+#endif //__IO_STATS_H__
@@ -7,6 +7,7 @@
 
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <stdio.h>
 #include <fcntl.h>
 #include <stdarg.h>
@@ -26,6 +27,9 @@ extern "C" {
 #include "fcntl_implem.h"
 #include "channels_mount.h"
 #include "enum_strings.h"
+#include "utils.h"
+#include "io_stats.h"
+#include "meminfo.h"
 }
 
 #define NODE_OBJECT_BYINODE(memount_p, inode) memount_p->ToMemNode(inode)
@@ -70,8 +74,11 @@ struct InMemoryMounts{
     struct HandleAllocator* handle_allocator;
     MemMount*               mem_mount_cpp;
     struct MountSpecificPublicInterface* mount_specific_interface;
+    struct IoStats          stats; /*read/write statistics*/
 };
 
+#define IO_STATS_BY_MOUNT(mounts_interface_p) (&((struct InMemoryMounts*)mounts_interface_p)->stats)
+
 
 static const char* name_from_path( std::string path ){
     /*retrieve directory name, and compare name length with max available*/
@@ -249,25 +256,28 @@ static int mem_chmod(struct MountsPublicInterface* this_, const char* path, uint
     return MEMOUNT_BY_MOUNT(this_)->Chmod( st.st_ino, mode);
 }
 
-static int mem_stat(struct MountsPublicInterface* this_, const char* path, struct stat *buf){
-    lazy_mount(this_, path);
-    struct stat st;
-    GET_STAT_BYPATH_OR_RAISE_ERROR( MEMOUNT_BY_MOUNT(this_), path, &st);
-    int ret = MEMOUNT_BY_MOUNT(this_)->Stat( st.st_ino, buf);
-
-    /*fixes for hardlinks pseudo support, different hardlinks must have same inode,
-     *but internally all nodes have separeted inodes*/
+/*fixes for hardlinks pseudo support, different hardlinks must have same inode,
+ *but internally all nodes have separeted inodes*/
+static int mem_stat_patch_hardinode(struct MountsPublicInterface* this_, ino_t inode, 
+				    struct stat *buf){
+    int ret = MEMOUNT_BY_MOUNT(this_)->Stat( inode, buf);
     if ( ret == 0 ){
-	MemNode* node = NODE_OBJECT_BYINODE( MEMOUNT_BY_MOUNT(this_), st.st_ino);
+	MemNode* node = NODE_OBJECT_BYINODE( MEMOUNT_BY_MOUNT(this_), inode);
 	assert(node!=NULL);
 	/*patch inode if it has hardlinks*/
 	if ( node->hardinode() > 0 )
 	    buf->st_ino = (ino_t)node->hardinode();
     }
-
     return ret;
 }
 
+static int mem_stat(struct MountsPublicInterface* this_, const char* path, struct stat *buf){
+    lazy_mount(this_, path);
+    struct stat st;
+    GET_STAT_BYPATH_OR_RAISE_ERROR( MEMOUNT_BY_MOUNT(this_), path, &st);
+    return mem_stat_patch_hardinode(this_, st.st_ino, buf);
+}
+
 static int mem_mkdir(struct MountsPublicInterface* this_, const char* path, uint32_t mode){
     lazy_mount(this_, path);
     int ret = MEMOUNT_BY_MOUNT(this_)->GetNode( path, NULL);
@@ -304,7 +314,7 @@ static int mem_mount(struct MountsPublicInterface* this_, const char* path, void
     return -1;
 }
 
-static ssize_t mem_read(struct MountsPublicInterface* this_, int fd, void *buf, size_t nbyte){
+static ssize_t mem_read_nostat(struct MountsPublicInterface* this_, int fd, void *buf, size_t nbyte){
     ino_t inode;
     GET_INODE_BY_HANDLE_OR_RAISE_ERROR( HALLOCATOR_BY_MOUNT(this_), fd, &inode);
 
@@ -322,7 +332,7 @@ static ssize_t mem_read(struct MountsPublicInterface* this_, int fd, void *buf,
     return readed;
 }
 
-static ssize_t mem_write(struct MountsPublicInterface* this_, int fd, const void *buf, size_t nbyte){
+static ssize_t mem_write_nostat(struct MountsPublicInterface* this_, int fd, const void *buf, size_t nbyte){
     ino_t inode;
     GET_INODE_BY_HANDLE_OR_RAISE_ERROR( HALLOCATOR_BY_MOUNT(this_), fd, &inode);
 
@@ -338,6 +348,20 @@ static ssize_t mem_write(struct MountsPublicInterface* this_, int fd, const void
     return wrote;
 }
 
+static ssize_t mem_read(struct MountsPublicInterface* this_, int fd, void *buf, size_t nbyte){
+    uint64_t start_ticks = cpu_ticks();
+    ssize_t readed = mem_read_nostat(this_, fd, buf, nbyte);
+    IO_STATS_UPDATE(IO_STATS_BY_MOUNT(this_), EIoStatsRead, nbyte, readed, start_ticks);
+    return readed;
+}
+
+static ssize_t mem_write(struct MountsPublicInterface* this_, int fd, const void *buf, size_t nbyte){
+    uint64_t start_ticks = cpu_ticks();
+    ssize_t wrote = mem_write_nostat(this_, fd, buf, nbyte);
+    IO_STATS_UPDATE(IO_STATS_BY_MOUNT(this_), EIoStatsWrite, nbyte, wrote, start_ticks);
+    return wrote;
+}
+
 static int mem_fchown(struct MountsPublicInterface* this_, int fd, uid_t owner, gid_t group){
     ino_t inode;
     GET_INODE_BY_HANDLE_OR_RAISE_ERROR( HALLOCATOR_BY_MOUNT(this_), fd, &inode);
@@ -354,7 +378,8 @@ static int mem_fchmod(struct MountsPublicInterface* this_, int fd, uint32_t mode
 static int mem_fstat(struct MountsPublicInterface* this_, int fd, struct stat *buf){
     ino_t inode;
     GET_INODE_BY_HANDLE_OR_RAISE_ERROR( HALLOCATOR_BY_MOUNT(this_), fd, &inode);
-    return MEMOUNT_BY_MOUNT(this_)->Stat( inode, buf);
+    /*file opened via any hardlink must have the same inode as stat gives*/
+    return mem_stat_patch_hardinode(this_, inode, buf);
 }
 
 static int mem_getdents(struct MountsPublicInterface* this_, int fd, void *buf, unsigned int count){
@@ -610,6 +635,135 @@ static int mem_link(struct MountsPublicInterface* this_, const char* oldpath, co
     return 0;
 }
 
+/*read file data starting from offset into iovec buffers, stop at EOF
+ *@return readed bytes or -1 if error*/
+static ssize_t mem_readv_at(struct MountsPublicInterface* this_, ino_t inode, off_t offset,
+			    const struct iovec *iov, int iovcnt){
+    uint64_t start_ticks = cpu_ticks();
+    ssize_t len = iovec_length(iov, iovcnt);
+    if ( len == -1 ) return -1; /*errno already set*/
+    ssize_t readed, total=0;
+    for ( int i=0; i < iovcnt; i++ ){
+	readed = MEMOUNT_BY_MOUNT(this_)->Read( inode, offset+total, iov[i].iov_base, iov[i].iov_len );
+	if ( readed < 0 ){ total = -1; break; }
+	total += readed;
+	if ( readed < (ssize_t)iov[i].iov_len ) break; /*EOF reached*/
+    }
+    IO_STATS_UPDATE(IO_STATS_BY_MOUNT(this_), EIoStatsRead, len, total, start_ticks);
+    return total;
+}
+
+/*write iovec buffers into file starting from offset
+ *@return wrote bytes, or -1 if error occured before any data written*/
+static ssize_t mem_writev_at(struct MountsPublicInterface* this_, ino_t inode, off_t offset,
+			     const struct iovec *iov, int iovcnt){
+    uint64_t start_ticks = cpu_ticks();
+    ssize_t len = iovec_length(iov, iovcnt);
+    if ( len == -1 ) return -1; /*errno already set*/
+    ssize_t wrote, total=0;
+    for ( int i=0; i < iovcnt; i++ ){
+	if ( iov[i].iov_len == 0 ) continue;
+	wrote = MEMOUNT_BY_MOUNT(this_)->Write( inode, offset+total, 
+						iov[i].iov_base, iov[i].iov_len );
+	if ( wrote < 0 ){
+	    /*errno already set by MemMount*/
+	    if ( total == 0 ) total = -1;
+	    break;
+	}
+	total += wrote;
+    }
+    IO_STATS_UPDATE(IO_STATS_BY_MOUNT(this_), EIoStatsWrite, len, total, start_ticks);
+    return total;
+}
+
+static ssize_t mem_readv(struct MountsPublicInterface* this_, int fd, const struct iovec *iov, int iovcnt){
+    ino_t inode;
+    GET_INODE_BY_HANDLE_OR_RAISE_ERROR( HALLOCATOR_BY_MOUNT(this_), fd, &inode);
+
+    off_t offset;
+    int ret = HALLOCATOR_BY_MOUNT(this_)->get_offset( fd, &offset );
+    assert( ret == 0 );
+    ssize_t readed = mem_readv_at(this_, inode, offset, iov, iovcnt);
+    if ( readed >= 0 ){
+	offset += readed;
+	/*update offset*/
+	ret = HALLOCATOR_BY_MOUNT(this_)->set_offset( fd, offset );
+	assert( ret == 0 );
+    }
+    return readed;
+}
+
+static ssize_t mem_writev(struct MountsPublicInterface* this_, int fd, const struct iovec *iov, int iovcnt){
+    ino_t inode;
+    GET_INODE_BY_HANDLE_OR_RAISE_ERROR( HALLOCATOR_BY_MOUNT(this_), fd, &inode);
+
+    off_t offset;
+    int ret = HALLOCATOR_BY_MOUNT(this_)->get_offset( fd, &offset );
+    assert( ret == 0 );
+    ssize_t wrote = mem_writev_at(this_, inode, offset, iov, iovcnt);
+    if ( wrote != -1 ){
+	offset += wrote;
+	ret = HALLOCATOR_BY_MOUNT(this_)->set_offset( fd, offset );
+	assert( ret == 0 );
+    }
+    return wrote;
+}
+
+static ssize_t mem_preadv(struct MountsPublicInterface* this_, int fd, const struct iovec *iov, int iovcnt,
+			  off_t offset){
+    ino_t inode;
+    GET_INODE_BY_HANDLE_OR_RAISE_ERROR( HALLOCATOR_BY_MOUNT(this_), fd, &inode);
+    if ( offset < 0 ){
+	SET_ERRNO(EINVAL);
+	return -1;
+    }
+    return mem_readv_at(this_, inode, offset, iov, iovcnt);
+}
+
+static ssize_t mem_pwritev(struct MountsPublicInterface* this_, int fd, const struct iovec *iov, int iovcnt,
+			   off_t offset){
+    ino_t inode;
+    GET_INODE_BY_HANDLE_OR_RAISE_ERROR( HALLOCATOR_BY_MOUNT(this_), fd, &inode);
+    if ( offset < 0 ){
+	SET_ERRNO(EINVAL);
+	return -1;
+    }
+    return mem_writev_at(this_, inode, offset, iov, iovcnt);
+}
+
+static int mem_direct_buffer(struct MountsPublicInterface* this_, int fd, off_t offset, size_t *count,
+			     int for_write, void **ptr){
+    ino_t inode;
+    GET_INODE_BY_HANDLE_OR_RAISE_ERROR( HALLOCATOR_BY_MOUNT(this_), fd, &inode);
+    if ( offset < 0 ){
+	SET_ERRNO(EINVAL);
+	return -1;
+    }
+    uint64_t start_ticks = cpu_ticks();
+    size_t requested = *count;
+    int ret = MEMOUNT_BY_MOUNT(this_)->DataPointer( inode, offset, count, for_write, (char**)ptr );
+    IO_STATS_UPDATE(IO_STATS_BY_MOUNT(this_), for_write ? EIoStatsWrite : EIoStatsRead, 
+		    requested, ret == 0 ? (ssize_t)*count : -1, start_ticks);
+    return ret;
+}
+
+static int mem_fadvise(struct MountsPublicInterface* this_, int fd, off_t offset, off_t len, int advice){
+    ino_t inode;
+    GET_INODE_BY_HANDLE_OR_RAISE_ERROR( HALLOCATOR_BY_MOUNT(this_), fd, &inode);
+    /*file data is always in memory, so only release memory reserved
+      by file growth; data itself can't be dropped as it's only copy*/
+    if ( advice == POSIX_FADV_DONTNEED ){
+	MemNode* node = NODE_OBJECT_BYINODE( MEMOUNT_BY_MOUNT(this_), inode );
+	if ( node != NULL && !node->is_dir() && 
+	     node->len() > 0 && node->capacity() > (int)node->len() ){
+	    ZRT_LOG(L_INFO, "release %d bytes of inode=%d", 
+		    node->capacity() - (int)node->len(), (int)inode);
+	    node->ReallocData(node->len());
+	}
+    }
+    return 0;
+}
+
 struct MountSpecificPublicInterface* mem_implem(struct MountsPublicInterface* this_){
     return ((struct InMemoryMounts*)this_)->mount_specific_interface;
 }
@@ -642,10 +796,25 @@ static struct MountsPublicInterface KInMemoryMountWraper = {
     mem_dup,
     mem_dup2,
     mem_link,
+    mem_readv,
+    mem_writev,
+    mem_preadv,
+    mem_pwritev,
+    mem_direct_buffer,
+    mem_fadvise,
     EMemMountId,
     mem_implem  /*mount_specific_interface*/
 };
 
+/*memfs data usage for meminfo report, obj is not used because
+ *usage is common for all MemData objects*/
+static void memfs_meminfo_usage(void* obj, struct MemInfoFsUsage* usage){
+    usage->data_bytes = MemData::usage_.len;
+    usage->capacity_bytes = MemData::usage_.capacity;
+    usage->peak_capacity_bytes = MemData::usage_.peak_capacity;
+    usage->files = MemData::usage_.count;
+}
+
 struct MountsPublicInterface* 
 inmemory_filesystem_construct( struct HandleAllocator* handle_allocator ){
     /*use malloc and not new, because it's external c object*/
@@ -658,6 +827,13 @@ inmemory_filesystem_construct( struct HandleAllocator* handle_allocator ){
     this_->mount_specific_interface = CONSTRUCT_L(MOUNT_SPECIFIC)( &KMountSpecificImplem,
 								   this_);
     this_->mem_mount_cpp = new MemMount;
+    /*memfs works anyway, it's only not reported*/
+    if ( io_stats_register("memfs", EIoStatsMount, &this_->stats) != 0 ){
+	ZRT_LOG(L_ERROR, "memfs isn't added into io stats report, errno=%d", errno);
+    }
+    if ( meminfo_register_fs("Memfs", memfs_meminfo_usage, this_) != 0 ){
+	ZRT_LOG(L_ERROR, "memfs isn't added into meminfo report, errno=%d", errno);
+    }
     return (struct MountsPublicInterface*)this_;
 }
 
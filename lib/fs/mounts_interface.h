@@ -24,6 +24,7 @@
 #include <unistd.h> //ssize_t
 
 struct stat;
+struct iovec;
 
 typedef enum { EChannelsMountId=0, EMemMountId=1, EMountsCount } MountId;
 
@@ -85,6 +86,24 @@ struct MountsPublicInterface{
     int (*dup2)(struct MountsPublicInterface* this_,int oldfd, int newfd);
     int (*link)(struct MountsPublicInterface* this_,const char *oldpath, const char *newpath);
 
+    // Vectored I/O: readv/writev use and update current file position;
+    // preadv/pwritev are using offset param and leave file position unchanged.
+    ssize_t (*readv)(struct MountsPublicInterface* this_,int fd, const struct iovec *iov, int iovcnt);
+    ssize_t (*writev)(struct MountsPublicInterface* this_,int fd, const struct iovec *iov, int iovcnt);
+    ssize_t (*preadv)(struct MountsPublicInterface* this_,int fd, const struct iovec *iov, int iovcnt,
+		      off_t offset);
+    ssize_t (*pwritev)(struct MountsPublicInterface* this_,int fd, const struct iovec *iov, int iovcnt,
+		       off_t offset);
+    // Direct access to file data kept by mount, lets copy data between files
+    // without intermediate buffer. For reading *count is reduced to bytes
+    // available at offset, for writing file is grown to fit *count bytes.
+    // Mounts not storing file data return -1 and set errno=ENOSYS.
+    int (*direct_buffer)(struct MountsPublicInterface* this_,int fd, off_t offset, size_t *count,
+			 int for_write, void **ptr);
+    // Access pattern advice for file range, see posix_fadvise. It's only a
+    // hint, mount can ignore it.
+    int (*fadvise)(struct MountsPublicInterface* this_,int fd, off_t offset, off_t len, int advice);
+
     /* const  */MountId mount_id;
     struct MountSpecificPublicInterface* (*implem)(struct MountsPublicInterface* this_);
 };
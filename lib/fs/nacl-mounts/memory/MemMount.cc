@@ -561,25 +561,47 @@ ssize_t MemMount::Read(ino_t slot, off_t offset, void *buf, size_t count) {
 
 ssize_t MemMount::Write(ino_t slot, off_t offset, const void *buf,
 			size_t count) {
+    char *data;
+    if ( DataPointer(slot, offset, &count, true, &data) == -1 ){
+	return -1;
+    }
+    // Write out the block.
+    memcpy(data, buf, count);
+    return count;
+}
+
+int MemMount::DataPointer(ino_t slot, off_t offset, size_t *count, 
+			  bool for_write, char **ptr) {
     MemNode *node = slots_.At(slot);
     if (node == NULL) {
         errno = ENOENT;
         return -1;
     }
 
-    /*check if file was not opened for writing*/
+    /*check if file was opened for requested access*/
     int flags= node->flags() & O_ACCMODE;
-    if ( flags!=O_WRONLY && flags!=O_RDWR ){
-	ZRT_LOG(L_ERROR, "file open flags=(%d/%d)%s not allow write", 
-		node->flags(), flags, STR_FILE_OPEN_FLAGS(flags));
+    if ( for_write ? (flags!=O_WRONLY && flags!=O_RDWR) : 
+	 (flags!=O_RDONLY && flags!=O_RDWR) ){
+	ZRT_LOG(L_ERROR, "file open flags=(%d/%d)%s not allow %s", 
+		node->flags(), flags, STR_FILE_OPEN_FLAGS(flags), for_write?"write":"read");
 	SET_ERRNO( EINVAL );
 	return -1;
     }
 
+    if ( !for_write ){
+	// Limit to the end of the file.
+	if ( offset >= static_cast<off_t>(node->len()) )
+	    *count = 0;
+	else if ( *count > node->len() - offset )
+	    *count = node->len() - offset;
+	*ptr = node->data() + offset;
+	return 0;
+    }
+
     size_t len = node->capacity();
     // Grow the file if needed.
-    if (offset + static_cast<off_t>(count) > static_cast<off_t>(len)) {
-        len = offset + count;
+    if (offset + static_cast<off_t>(*count) > static_cast<off_t>(len)) {
+        len = offset + *count;
         size_t next = (node->capacity() + 1) * 2;
         if (next > len) {
             len = next;
@@ -590,13 +612,10 @@ ssize_t MemMount::Write(ino_t slot, off_t offset, const void *buf,
     if (offset > static_cast<off_t>(node->len())) {
         memset(node->data()+node->len(), 0, offset-node->len());
     }
-
-    // Write out the block.
-    memcpy(node->data() + offset, buf, count);
-    offset += count;
-    if (offset > static_cast<off_t>(node->len())) {
-        node->set_len(offset);
+    if (offset + static_cast<off_t>(*count) > static_cast<off_t>(node->len())) {
+        node->set_len(offset + *count);
     }
-    return count;
+    *ptr = node->data() + offset;
+    return 0;
 }
 
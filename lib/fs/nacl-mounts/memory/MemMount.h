@@ -93,6 +93,12 @@ class MemMount {
   ssize_t Read(ino_t node, off_t offset, void *buf, size_t count);
   ssize_t Write(ino_t node, off_t offset, const void *buf, size_t count);
 
+  // DataPointer() gives direct access to node data at offset, to move data
+  // without intermediate copy. For reading count is reduced to bytes
+  // available; for writing node is grown and zero padded to hold count bytes
+  // at offset. 0 is returned on success, -1 is returned on failure.
+  int DataPointer(ino_t node, off_t offset, size_t *count, bool for_write, char **ptr);
+
   // Return the node at path.  If the path is invalid, NULL is returned.
   MemNode *GetMemNode(std::string path);
 
@@ -15,8 +15,13 @@ extern "C" {
 }
 #include "MemNode.h"
 
+struct MemDataUsage MemData::usage_;
+
 MemData::~MemData(){
     free(data_);
+    usage_.len -= len_;
+    usage_.capacity -= capacity_;
+    --usage_.count;
     children_.clear();
 }
 
@@ -29,6 +34,7 @@ MemData::MemData() {
     nlink_ = 1; /*new file/dir has 1 hardlink at creature time*/
     want_unlink_ = 0;
     hardinode_ = 0;
+    ++usage_.count;
 }
 
 
@@ -44,12 +44,23 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.*/
 
 class MemMount;
 
+/*Memory usage summed over all node data objects*/
+struct MemDataUsage {
+    size_t len;           //sum of files length
+    size_t capacity;      //sum of allocated data buffers
+    size_t peak_capacity; //max capacity value reached
+    int    count;         //node data objects, hardlinks are counted once
+};
+
 /*Node data that can be shared between hardlinks*/
 class MemData {
  public:
     MemData();
     ~MemData();
 
+    //usage is updated by data buffer changes of any node
+    static struct MemDataUsage usage_;
+
     char *data_;
     size_t len_;
     bool is_dir_;
@@ -160,13 +171,21 @@ class MemNode {
     int capacity(void) { return nodedata_->capacity_; }
 
     // set the capacity of this node to capacity bytes
-    void set_capacity(int capacity) { nodedata_->capacity_ = capacity; }
+    void set_capacity(size_t capacity) { 
+	MemData::usage_.capacity += capacity - nodedata_->capacity_;
+	if ( MemData::usage_.capacity > MemData::usage_.peak_capacity )
+	    MemData::usage_.peak_capacity = MemData::usage_.capacity;
+	nodedata_->capacity_ = capacity; 
+    }
 
     // data() returns a pointer to the data of this node
     char *data(void) { return nodedata_->data_; }
 
     // set_data() sets the length of this node to len
-    void set_len(size_t len) { nodedata_->len_ = len; }
+    void set_len(size_t len) { 
+	MemData::usage_.len += len - nodedata_->len_;
+	nodedata_->len_ = len; 
+    }
 
     // len() returns the length of this node
     size_t len(void) { return nodedata_->len_; }
@@ -18,7 +18,9 @@
 
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <string.h>
+#include <stdlib.h>
 #include <stdio.h>
 #include <stdarg.h>
 #include <unistd.h>
@@ -33,6 +35,9 @@
 #include "mounts_interface.h"
 #include "fcntl_implem.h"
 
+/*maximum amount of data moved by single internal transfer of copy range*/
+#define COPY_RANGE_CHUNK_SIZE (1024*1024)
+
 static struct MountsManager* s_mounts_manager;
 
 #define CONVERT_PATH_TO_MOUNT(full_path)			\
@@ -366,6 +371,204 @@ static int transparent_link(struct MountsPublicInterface *this,
     }
 }
 
+static ssize_t transparent_readv(struct MountsPublicInterface *this,
+				 int fd, const struct iovec *iov, int iovcnt){
+    struct MountsPublicInterface* mount = s_mounts_manager->mount_byhandle(fd);
+    if ( mount )
+        return mount->readv( mount, fd, iov, iovcnt);
+    else{
+        SET_ERRNO(EBADF);
+        return -1;
+    }
+}
+
+static ssize_t transparent_writev(struct MountsPublicInterface *this,
+				  int fd, const struct iovec *iov, int iovcnt){
+    struct MountsPublicInterface* mount = s_mounts_manager->mount_byhandle(fd);
+    if ( mount )
+        return mount->writev( mount, fd, iov, iovcnt);
+    else{
+        SET_ERRNO(EBADF);
+        return -1;
+    }
+}
+
+static ssize_t transparent_preadv(struct MountsPublicInterface *this,
+				  int fd, const struct iovec *iov, int iovcnt, off_t offset){
+    struct MountsPublicInterface* mount = s_mounts_manager->mount_byhandle(fd);
+    if ( mount )
+        return mount->preadv( mount, fd, iov, iovcnt, offset);
+    else{
+        SET_ERRNO(EBADF);
+        return -1;
+    }
+}
+
+static ssize_t transparent_pwritev(struct MountsPublicInterface *this,
+				   int fd, const struct iovec *iov, int iovcnt, off_t offset){
+    struct MountsPublicInterface* mount = s_mounts_manager->mount_byhandle(fd);
+    if ( mount )
+        return mount->pwritev( mount, fd, iov, iovcnt, offset);
+    else{
+        SET_ERRNO(EBADF);
+        return -1;
+    }
+}
+
+static int transparent_direct_buffer(struct MountsPublicInterface *this, int fd, off_t offset, 
+				     size_t *count, int for_write, void **ptr){
+    struct MountsPublicInterface* mount = s_mounts_manager->mount_byhandle(fd);
+    if ( mount )
+        return mount->direct_buffer( mount, fd, offset, count, for_write, ptr);
+    else{
+        SET_ERRNO(EBADF);
+        return -1;
+    }
+}
+
+static int transparent_fadvise(struct MountsPublicInterface *this, int fd, off_t offset, 
+			       off_t len, int advice){
+    struct MountsPublicInterface* mount = s_mounts_manager->mount_byhandle(fd);
+    if ( mount == NULL ){
+        SET_ERRNO(EBADF);
+        return -1;
+    }
+    if ( len < 0 || advice < POSIX_FADV_NORMAL || advice > POSIX_FADV_NOREUSE ){
+        SET_ERRNO(EINVAL);
+        return -1;
+    }
+    return mount->fadvise( mount, fd, offset, len, advice);
+}
+
+/*read into buffer using either file position or offset, advance offset*/
+static ssize_t copy_range_read(struct MountsPublicInterface* mount, int fd, 
+			       void* buf, size_t count, off_t* offset){
+    ssize_t readed;
+    if ( offset != NULL ){
+	struct iovec iov = { buf, count };
+	readed = mount->preadv(mount, fd, &iov, 1, *offset);
+	if ( readed > 0 ) *offset += readed;
+    }
+    else
+	readed = mount->read(mount, fd, buf, count);
+    return readed;
+}
+
+/*write from buffer using either file position or offset, advance offset*/
+static ssize_t copy_range_write(struct MountsPublicInterface* mount, int fd, 
+				const void* buf, size_t count, off_t* offset){
+    ssize_t wrote;
+    if ( offset != NULL ){
+	struct iovec iov = { (void*)buf, count };
+	wrote = mount->pwritev(mount, fd, &iov, 1, *offset);
+	if ( wrote > 0 ) *offset += wrote;
+    }
+    else
+	wrote = mount->write(mount, fd, buf, count);
+    return wrote;
+}
+
+/*get offset to be used for direct access: offset param or file position*/
+static off_t copy_range_offset(struct MountsPublicInterface* mount, int fd, off_t* offset){
+    return offset != NULL ? *offset : mount->lseek(mount, fd, 0, SEEK_CUR);
+}
+
+/*advance offset param or file position after direct access*/
+static void copy_range_advance(struct MountsPublicInterface* mount, int fd, 
+			       off_t* offset, off_t pos, size_t count){
+    if ( offset != NULL )
+	*offset = pos + count;
+    else
+	mount->lseek(mount, fd, pos + count, SEEK_SET);
+}
+
+/*Copy single chunk, prefer direct access to data of source or
+ *destination, it saves one memcpy against read+write. Chunk is copied
+ *via bounce buffer only if both mounts not storing data.
+ *@return copied bytes, 0 at EOF, -1 if error*/
+static ssize_t copy_range_chunk(struct MountsPublicInterface* in_mount, int in_fd, off_t* off_in,
+				struct MountsPublicInterface* out_mount, int out_fd, off_t* off_out,
+				size_t count, char** bounce){
+    void* ptr;
+    size_t len = count;
+    off_t pos;
+
+    /*read directly from source data*/
+    if ( (pos=copy_range_offset(in_mount, in_fd, off_in)) != -1 &&
+	 in_mount->direct_buffer(in_mount, in_fd, pos, &len, 0, &ptr) == 0 ){
+	if ( len == 0 ) return 0; /*EOF*/
+	ssize_t wrote = copy_range_write(out_mount, out_fd, ptr, len, off_out);
+	if ( wrote > 0 ) copy_range_advance(in_mount, in_fd, off_in, pos, wrote);
+	return wrote;
+    }
+    else if ( errno != ENOSYS ) return -1;
+
+    /*read source directly into destination data*/
+    struct stat st;
+    len = count;
+    if ( (pos=copy_range_offset(out_mount, out_fd, off_out)) != -1 &&
+	 out_mount->fstat(out_mount, out_fd, &st) == 0 &&
+	 out_mount->direct_buffer(out_mount, out_fd, pos, &len, 1, &ptr) == 0 ){
+	ssize_t readed = copy_range_read(in_mount, in_fd, ptr, len, off_in);
+	if ( readed < (ssize_t)len ){
+	    /*drop unused space reserved at the end of file*/
+	    out_mount->ftruncate_size(out_mount, out_fd, 
+				      MAX(st.st_size, pos + (readed > 0 ? readed : 0)) );
+	}
+	if ( readed > 0 ) copy_range_advance(out_mount, out_fd, off_out, pos, readed);
+	return readed;
+    }
+    else if ( errno != ENOSYS ) return -1;
+
+    /*both are channels, use intermediate buffer*/
+    if ( *bounce == NULL && (*bounce = malloc(COPY_RANGE_CHUNK_SIZE)) == NULL ){
+	SET_ERRNO(ENOMEM);
+	return -1;
+    }
+    ssize_t readed = copy_range_read(in_mount, in_fd, *bounce, count, off_in);
+    if ( readed <= 0 ) return readed;
+    return copy_range_write(out_mount, out_fd, *bounce, readed, off_out);
+}
+
+ssize_t transparent_copy_range(int in_fd, off_t* off_in, int out_fd, off_t* off_out, size_t count){
+    struct MountsPublicInterface* in_mount = s_mounts_manager->mount_byhandle(in_fd);
+    struct MountsPublicInterface* out_mount = s_mounts_manager->mount_byhandle(out_fd);
+    if ( in_mount == NULL || out_mount == NULL ){
+	SET_ERRNO(EBADF);
+	return -1;
+    }
+    if ( (off_in != NULL && *off_in < 0) || (off_out != NULL && *off_out < 0) ){
+	SET_ERRNO(EINVAL);
+	return -1;
+    }
+    /*direct pointer into source would be invalidated by writing into
+      the same file, do not allow it*/
+    struct stat in_st, out_st;
+    if ( in_mount == out_mount &&
+	 in_mount->fstat(in_mount, in_fd, &in_st) == 0 &&
+	 out_mount->fstat(out_mount, out_fd, &out_st) == 0 &&
+	 in_st.st_ino == out_st.st_ino ){
+	SET_ERRNO(EINVAL);
+	return -1;
+    }
+
+    char* bounce = NULL;
+    ssize_t copied, total=0;
+    while ( total < count ){
+	size_t chunk = MIN(count - total, COPY_RANGE_CHUNK_SIZE);
+	copied = copy_range_chunk(in_mount, in_fd, off_in, out_mount, out_fd, off_out,
+				  chunk, &bounce);
+	if ( copied < 0 ){
+	    if ( total == 0 ) total = -1; /*errno already set*/
+	    break;
+	}
+	total += copied;
+	if ( copied < chunk ) break; /*EOF or short write*/
+    }
+    free(bounce);
+    ZRT_LOG(L_INFO, "in_fd=%d out_fd=%d copied=%d", in_fd, out_fd, (int)total);
+    return total;
+}
 
 static struct MountsPublicInterface s_transparent_mount = {
         transparent_chown,
@@ -394,7 +597,13 @@ static struct MountsPublicInterface s_transparent_mount = {
         transparent_isatty,
         transparent_dup,
         transparent_dup2,
-        transparent_link
+        transparent_link,
+        transparent_readv,
+        transparent_writev,
+        transparent_preadv,
+        transparent_pwritev,
+        transparent_direct_buffer,
+        transparent_fadvise
 };
 
 struct MountsPublicInterface* alloc_transparent_mount( struct MountsManager* mounts_manager ){
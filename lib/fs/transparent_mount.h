@@ -19,9 +19,18 @@
 #ifndef TRANSPARENT_MOUNT_H_
 #define TRANSPARENT_MOUNT_H_
 
+#include <sys/types.h> //ssize_t, off_t
+
 struct MountsPublicInterface;
 struct MountsManager;
 
 struct MountsPublicInterface* alloc_transparent_mount( struct MountsManager* mounts_manager );
 
+/*Copy data between opened files of any mounts without user buffers,
+ *data of in-memory files is accessed directly. If offset param is
+ *NULL then file position is used and updated, otherwise offset is
+ *used and updated while file position is left unchanged.
+ *@return copied bytes, 0 at EOF of input, -1 if error*/
+ssize_t transparent_copy_range(int in_fd, off_t* off_in, int out_fd, off_t* off_out, size_t count);
+
 #endif /* TRANSPARENT_MOUNT_H_ */
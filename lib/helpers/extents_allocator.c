@@ -0,0 +1,316 @@
+/*
+ *
+ * Copyright (c) 2013, LiteStack, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "extents_allocator.h"
+
+#include <string.h>
+#include <assert.h>
+
+#define EXTENT_END(extent) ((extent).begin + (extent).count)
+#define NIL (-1)
+
+typedef int (*extent_cmp_t)(const struct Extent* a, const struct Extent* b);
+
+static int extent_cmp_addr(const struct Extent* a, const struct Extent* b){
+    return a->begin - b->begin;
+}
+
+static int extent_cmp_size(const struct Extent* a, const struct Extent* b){
+    return a->count != b->count ? a->count - b->count : a->begin - b->begin;
+}
+
+/*comparator of every tree, indexed by EExtentsByAddr, EExtentsBySize*/
+static const extent_cmp_t s_extent_cmp[EExtentsTreesCount] = { extent_cmp_addr, extent_cmp_size };
+
+/*treap priority of node is a hash of node index, it's enough to keep
+ *trees balanced and needs no storage*/
+static uint32_t node_priority(int32_t node){
+    uint32_t h = (uint32_t)node;
+    h ^= h >> 16;
+    h *= 0x85ebca6b;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35;
+    h ^= h >> 16;
+    return h;
+}
+
+/*@return new root of subtree*/
+static int32_t treap_insert(struct ExtentsAllocator* this, int tree, int32_t root, int32_t node){
+    struct ExtentNode* nodes = this->nodes;
+    int32_t child;
+    if ( root == NIL ) return node;
+    if ( s_extent_cmp[tree](&nodes[node].extent, &nodes[root].extent) < 0 ){
+	child = treap_insert(this, tree, nodes[root].left[tree], node);
+	nodes[root].left[tree] = child;
+	if ( node_priority(child) > node_priority(root) ){
+	    /*rotate right*/
+	    nodes[root].left[tree] = nodes[child].right[tree];
+	    nodes[child].right[tree] = root;
+	    return child;
+	}
+    }
+    else{
+	child = treap_insert(this, tree, nodes[root].right[tree], node);
+	nodes[root].right[tree] = child;
+	if ( node_priority(child) > node_priority(root) ){
+	    /*rotate left*/
+	    nodes[root].right[tree] = nodes[child].left[tree];
+	    nodes[child].left[tree] = root;
+	    return child;
+	}
+    }
+    return root;
+}
+
+/*join subtrees, all extents of left are less than extents of right
+ *@return new root of subtree*/
+static int32_t treap_merge(struct ExtentsAllocator* this, int tree, int32_t left, int32_t right){
+    struct ExtentNode* nodes = this->nodes;
+    if ( left == NIL ) return right;
+    if ( right == NIL ) return left;
+    if ( node_priority(left) > node_priority(right) ){
+	nodes[left].right[tree] = treap_merge(this, tree, nodes[left].right[tree], right);
+	return left;
+    }
+    nodes[right].left[tree] = treap_merge(this, tree, left, nodes[right].left[tree]);
+    return right;
+}
+
+/*remove node having extent equal to key, it must exist
+ *@return new root of subtree*/
+static int32_t treap_erase(struct ExtentsAllocator* this, int tree, int32_t root, 
+			   const struct Extent* key){
+    struct ExtentNode* nodes = this->nodes;
+    int cmp;
+    assert( root != NIL );
+    cmp = s_extent_cmp[tree](key, &nodes[root].extent);
+    if ( cmp == 0 )
+	return treap_merge(this, tree, nodes[root].left[tree], nodes[root].right[tree]);
+    else if ( cmp < 0 )
+	nodes[root].left[tree] = treap_erase(this, tree, nodes[root].left[tree], key);
+    else
+	nodes[root].right[tree] = treap_erase(this, tree, nodes[root].right[tree], key);
+    return root;
+}
+
+/*@return node of first extent not less than key or NIL*/
+static int32_t treap_lower_bound(struct ExtentsAllocator* this, int tree, const struct Extent* key){
+    int32_t node = this->root[tree], found = NIL;
+    while ( node != NIL ){
+	if ( s_extent_cmp[tree](&this->nodes[node].extent, key) < 0 )
+	    node = this->nodes[node].right[tree];
+	else{
+	    found = node;
+	    node = this->nodes[node].left[tree];
+	}
+    }
+    return found;
+}
+
+/*@return node of last extent less than key or NIL*/
+static int32_t treap_last_less(struct ExtentsAllocator* this, int tree, const struct Extent* key){
+    int32_t node = this->root[tree], found = NIL;
+    while ( node != NIL ){
+	if ( s_extent_cmp[tree](&this->nodes[node].extent, key) < 0 ){
+	    found = node;
+	    node = this->nodes[node].right[tree];
+	}
+	else
+	    node = this->nodes[node].left[tree];
+    }
+    return found;
+}
+
+/*@return node of greatest extent or NIL*/
+static int32_t treap_last(struct ExtentsAllocator* this, int tree){
+    int32_t node = this->root[tree];
+    while ( node != NIL && this->nodes[node].right[tree] != NIL )
+	node = this->nodes[node].right[tree];
+    return node;
+}
+
+static void extents_add(struct ExtentsAllocator* this, const struct Extent* extent){
+    int32_t node;
+    int tree;
+    assert( this->extents_count < EXTENTS_MAX_COUNT(this->items_count) );
+    /*reuse released node or take new one from storage*/
+    if ( this->free_node != NIL ){
+	node = this->free_node;
+	this->free_node = this->nodes[node].left[0];
+    }
+    else
+	node = this->nodes_used++;
+    this->nodes[node].extent = *extent;
+    for ( tree=0; tree < EExtentsTreesCount; tree++ ){
+	this->nodes[node].left[tree] = this->nodes[node].right[tree] = NIL;
+	this->root[tree] = treap_insert(this, tree, this->root[tree], node);
+    }
+    ++this->extents_count;
+}
+
+static void extents_delete(struct ExtentsAllocator* this, int32_t node){
+    /*copy it, because node links are changing while erasing*/
+    struct Extent key = this->nodes[node].extent;
+    int tree;
+    for ( tree=0; tree < EExtentsTreesCount; tree++ ){
+	this->root[tree] = treap_erase(this, tree, this->root[tree], &key);
+    }
+    this->nodes[node].left[0] = this->free_node;
+    this->free_node = node;
+    --this->extents_count;
+}
+
+static int extents_alloc_at(struct ExtentsAllocator* this, int begin, int count);
+
+static int extents_alloc(struct ExtentsAllocator* this, int count, int max_end, int end_align){
+    struct Extent key = {-1, count};
+    int32_t node;
+    if ( count <= 0 || end_align <= 0 ) return -1;
+    /*smallest extents fitting request are going first*/
+    node = treap_lower_bound(this, EExtentsBySize, &key);
+    while ( node != NIL ){
+	struct Extent found = this->nodes[node].extent;
+	/*first aligned range inside of extent*/
+	int begin = (found.begin+count + end_align-1)/end_align*end_align - count;
+	if ( begin+count <= EXTENT_END(found) && begin+count <= max_end ){
+	    if ( begin == found.begin ){
+		extents_delete(this, node);
+		if ( found.count > count ){
+		    struct Extent rest = { found.begin+count, found.count-count };
+		    extents_add(this, &rest);
+		}
+		this->free_items -= count;
+		return begin;
+	    }
+	    /*aligned range splits extent*/
+	    else if ( extents_alloc_at(this, begin, count) == 0 ) return begin;
+	}
+	/*next extent in size order*/
+	key.begin = found.begin+1;
+	key.count = found.count;
+	node = treap_lower_bound(this, EExtentsBySize, &key);
+    }
+    return -1;
+}
+
+static int extents_alloc_at(struct ExtentsAllocator* this, int begin, int count){
+    struct Extent key = { begin+1, 0 };
+    struct Extent found;
+    int32_t node;
+    if ( count <= 0 || begin < 0 || begin+count > this->items_count ) return -1;
+    /*the only extent that can contain range is last one starting not after begin*/
+    node = treap_last_less(this, EExtentsByAddr, &key);
+    if ( node == NIL ) return -1;
+    found = this->nodes[node].extent;
+    if ( EXTENT_END(found) < begin+count ) return -1;
+
+    extents_delete(this, node);
+    if ( found.begin < begin ){
+	struct Extent head = { found.begin, begin-found.begin };
+	extents_add(this, &head);
+    }
+    if ( EXTENT_END(found) > begin+count ){
+	struct Extent tail = { begin+count, EXTENT_END(found)-begin-count };
+	extents_add(this, &tail);
+    }
+    this->free_items -= count;
+    return 0;
+}
+
+static void extents_free(struct ExtentsAllocator* this, int begin, int count){
+    struct Extent merged = { begin, count };
+    int end = begin+count;
+    int32_t node;
+    assert( begin >= 0 && end <= this->items_count );
+    if ( count <= 0 ) return;
+    this->free_items += count;
+    /*join with overlapping and adjacent free extents*/
+    node = treap_last_less(this, EExtentsByAddr, &merged);
+    if ( node == NIL || EXTENT_END(this->nodes[node].extent) < begin )
+	node = treap_lower_bound(this, EExtentsByAddr, &merged);
+    while ( node != NIL && this->nodes[node].extent.begin <= end ){
+	struct Extent joined = this->nodes[node].extent;
+	struct Extent next = { joined.begin+1, 0 };
+	/*items that were already free are not counted twice*/
+	int overlap_begin = joined.begin > begin ? joined.begin : begin;
+	int overlap_end = EXTENT_END(joined) < end ? EXTENT_END(joined) : end;
+	if ( overlap_end > overlap_begin ) this->free_items -= overlap_end - overlap_begin;
+
+	if ( joined.begin < merged.begin ){
+	    merged.count += merged.begin - joined.begin;
+	    merged.begin = joined.begin;
+	}
+	if ( EXTENT_END(joined) > EXTENT_END(merged) )
+	    merged.count = EXTENT_END(joined) - merged.begin;
+	extents_delete(this, node);
+	node = treap_lower_bound(this, EExtentsByAddr, &next);
+    }
+    extents_add(this, &merged);
+}
+
+static void extents_stat(struct ExtentsAllocator* this, struct ExtentsStat* stat){
+    int32_t largest = treap_last(this, EExtentsBySize);
+    int32_t highest = treap_last(this, EExtentsByAddr);
+    stat->items_count = this->items_count;
+    stat->free_items = this->free_items;
+    stat->free_extents = this->extents_count;
+    stat->largest_free = largest != NIL ? this->nodes[largest].extent.count : 0;
+    stat->tail_free_begin = this->items_count;
+    if ( highest != NIL && EXTENT_END(this->nodes[highest].extent) == this->items_count )
+	stat->tail_free_begin = this->nodes[highest].extent.begin;
+}
+
+static void extents_free_runs_subtree(struct ExtentsAllocator* this, int32_t node,
+				      int* items_by_log2, int buckets){
+    while ( node != NIL ){
+	int count = this->nodes[node].extent.count;
+	int bucket = 31 - __builtin_clz((uint32_t)count);
+	items_by_log2[bucket < buckets ? bucket : buckets-1] += count;
+	extents_free_runs_subtree(this, this->nodes[node].left[EExtentsByAddr], 
+				  items_by_log2, buckets);
+	node = this->nodes[node].right[EExtentsByAddr];
+    }
+}
+
+static void extents_free_runs(struct ExtentsAllocator* this, int* items_by_log2, int buckets){
+    memset(items_by_log2, '\0', buckets*sizeof(int));
+    extents_free_runs_subtree(this, this->root[EExtentsByAddr], items_by_log2, buckets);
+}
+
+struct ExtentsAllocatorPublicInterface* 
+extents_allocator_construct( int items_count, void* storage, struct ExtentsAllocator* exist ){
+    /*use existing object memory, for example resided in bss  */
+    struct ExtentsAllocator* this = exist;
+
+    /*set functions*/
+    this->public.alloc = (void*)extents_alloc;
+    this->public.alloc_at = (void*)extents_alloc_at;
+    this->public.free =  (void*)extents_free;
+    this->public.stat =  (void*)extents_stat;
+    this->public.free_runs = (void*)extents_free_runs;
+    /*set data members*/
+    this->items_count = items_count;
+    this->free_items = 0;
+    this->extents_count = 0;
+    this->nodes = (struct ExtentNode*)storage;
+    this->nodes_used = 0;
+    this->free_node = NIL;
+    this->root[EExtentsByAddr] = this->root[EExtentsBySize] = NIL;
+    /*everything is free*/
+    extents_free(this, 0, items_count);
+    return (struct ExtentsAllocatorPublicInterface*)this;
+}
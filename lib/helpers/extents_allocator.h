@@ -0,0 +1,102 @@
+/*
+ *
+ * Copyright (c) 2013, LiteStack, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __EXTENTS_ALLOCATOR_H__
+#define __EXTENTS_ALLOCATOR_H__
+
+#include <stdint.h>
+
+#include "zrt_defines.h" //CONSTRUCT_L
+
+/*name of constructor*/
+#define EXTENTS_ALLOCATOR extents_allocator_construct
+
+/*free extents are not adjacent, so their count is limited by half of items*/
+#define EXTENTS_MAX_COUNT(items_count) ((items_count)/2+1)
+/*size of storage needed for allocator of items_count items*/
+#define EXTENTS_STORAGE_SIZE(items_count) (EXTENTS_MAX_COUNT(items_count)*sizeof(struct ExtentNode))
+
+/*trees of free extents*/
+enum { EExtentsByAddr=0, EExtentsBySize=1, EExtentsTreesCount };
+
+/*range of items [begin, begin+count)*/
+struct Extent{
+    int32_t begin;
+    int32_t count;
+};
+
+/*free extent is a node of both trees, links are node indexes or -1*/
+struct ExtentNode{
+    struct Extent extent;
+    int32_t left[EExtentsTreesCount];
+    int32_t right[EExtentsTreesCount];
+};
+
+struct ExtentsStat{
+    int items_count;
+    int free_items;
+    int free_extents;
+    int largest_free;    /*items count of largest free extent*/
+    int tail_free_begin; /*begin of free extent at the end of items or items_count*/
+};
+
+struct ExtentsAllocator;
+
+/*Allocator of items ranges, free ranges are kept as extents in two
+ *treaps ordered by address and by size, allocation is best fit and freed
+ *ranges are coalesced with neighbours. Every operation costs
+ *O(log(free extents)) expected, plus skipped extents if alignment or
+ *max_end is not satisfied*/
+struct ExtentsAllocatorPublicInterface{
+    /*allocate range from smallest free extent that fits, ties are
+     *resolved in favour of lowest address
+     *@param max_end allocated range must end before max_end
+     *@param end_align end of allocated range must be multiple of it, 1 for any
+     *@return begin of allocated range or -1 if no space*/
+    int  (*alloc)(struct ExtentsAllocatorPublicInterface* this, int count, int max_end, int end_align);
+    /*allocate exactly specified range
+     *@return 0 if all items of range were free, -1 and nothing changed otherwise*/
+    int  (*alloc_at)(struct ExtentsAllocatorPublicInterface* this, int begin, int count);
+    /*free range, it's allowed to contain already free items*/
+    void (*free)(struct ExtentsAllocatorPublicInterface* this, int begin, int count);
+    void (*stat)(struct ExtentsAllocatorPublicInterface* this, struct ExtentsStat* stat);
+    /*sum free items by length of free extents, extents of length in
+     *[2^i, 2^(i+1)) are accounted in items_by_log2[i], last bucket
+     *gets all longer extents*/
+    void (*free_runs)(struct ExtentsAllocatorPublicInterface* this, int* items_by_log2, int buckets);
+};
+
+struct ExtentsAllocator{
+    //base, it is must be a first member
+    struct ExtentsAllocatorPublicInterface public;
+    /*private data*/
+    int items_count;
+    int free_items;
+    int extents_count;
+    struct ExtentNode* nodes; /*nodes storage*/
+    int32_t nodes_used;       /*nodes taken from storage, never decreases*/
+    int32_t free_node;        /*list of released nodes linked by left[0]*/
+    int32_t root[EExtentsTreesCount]; /*ordered by begin; by count then by begin*/
+};
+
+/*@param storage memory of EXTENTS_STORAGE_SIZE(items_count) bytes
+ *@return result pointer can be casted to struct ExtentsAllocator,
+ *initially all items are free*/
+struct ExtentsAllocatorPublicInterface* 
+extents_allocator_construct( int items_count, void* storage, struct ExtentsAllocator* exist );
+
+#endif //__EXTENTS_ALLOCATOR_H__
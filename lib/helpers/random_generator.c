@@ -0,0 +1,90 @@
+/*
+ *
+ * Copyright (c) 2013, LiteStack, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+
+#include "random_generator.h"
+#include "ticks.h" /*cpu_ticks*/
+
+#define ROTL64(x, k) (((x) << (k)) | ((x) >> (64 - (k))))
+
+/*splitmix64 is used to expand single seed value into generator state*/
+static uint64_t splitmix64(uint64_t* x){
+    uint64_t z = (*x += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+/*xoshiro256** step*/
+static inline uint64_t xoshiro256ss_next(uint64_t* s){
+    const uint64_t result = ROTL64(s[1] * 5, 7) * 9;
+    const uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = ROTL64(s[3], 45);
+    return result;
+}
+
+static void random_generator_seed(struct RandomGenerator* this, uint64_t seed){
+    int i;
+    for ( i=0; i < 4; i++ )
+	this->state[i] = splitmix64(&seed);
+}
+
+static void random_generator_fill(struct RandomGenerator* this, void* buf, size_t size){
+    uint64_t* s = this->state;
+    unsigned char* p = (unsigned char*)buf;
+    uint64_t r;
+    /*whole 8 bytes words, memcpy is used because buf may be unaligned*/
+    for ( ; size >= sizeof(r); size -= sizeof(r), p += sizeof(r) ){
+	r = xoshiro256ss_next(s);
+	memcpy(p, &r, sizeof(r));
+    }
+    /*tail*/
+    if ( size > 0 ){
+	r = xoshiro256ss_next(s);
+	memcpy(p, &r, size);
+    }
+}
+
+uint64_t random_session_seed(){
+    static uint64_t s_counter;
+    /*gettimeofday is not used: it advances synthetic time seen by user
+      program and it's deterministic anyway. Mix cpu ticks, stack
+      address and sequence number of call*/
+    uint64_t seed = cpu_ticks();
+    seed ^= (uint64_t)(uintptr_t)&seed << 32;
+    seed ^= ++s_counter * 0x9E3779B97F4A7C15ULL;
+    return splitmix64(&seed);
+}
+
+struct RandomGeneratorPublicInterface* 
+random_generator_construct( uint64_t seed, struct RandomGenerator* exist ){
+    /*use existing object memory*/
+    struct RandomGenerator* this = exist;
+
+    /*set functions*/
+    this->public.seed = (void*)random_generator_seed;
+    this->public.fill = (void*)random_generator_fill;
+    /*set data members*/
+    random_generator_seed(this, seed);
+    return (struct RandomGeneratorPublicInterface*)this;
+}
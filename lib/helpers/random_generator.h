@@ -0,0 +1,55 @@
+/*
+ *
+ * Copyright (c) 2013, LiteStack, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef __RANDOM_GENERATOR_H__
+#define __RANDOM_GENERATOR_H__
+
+#include <stdint.h>
+#include <stddef.h> //size_t
+
+#include "zrt_defines.h" //CONSTRUCT_L
+
+/*name of constructor*/
+#define RANDOM_GENERATOR random_generator_construct
+
+/*Pseudo random generator xoshiro256** is used for emulation of
+ *random devices. Every step produces 8 bytes of output.*/
+struct RandomGeneratorPublicInterface{
+    /*reset generator state, the same seed gives the same sequence*/
+    void (*seed)(struct RandomGeneratorPublicInterface* this, uint64_t seed);
+    /*fill buffer by random bytes*/
+    void (*fill)(struct RandomGeneratorPublicInterface* this, void* buf, size_t size);
+};
+
+struct RandomGenerator{
+    //base, it is must be a first member
+    struct RandomGeneratorPublicInterface public;
+    /*private data*/
+    uint64_t state[4];
+};
+
+/*@return seed value that differs for every session, it's used if
+ *deterministic seed was not provided via nvram*/
+uint64_t random_session_seed();
+
+/*@param exist use existing object memory
+ *@return result pointer can be casted to struct RandomGenerator*/
+struct RandomGeneratorPublicInterface* 
+random_generator_construct( uint64_t seed, struct RandomGenerator* exist );
+
+#endif //__RANDOM_GENERATOR_H__
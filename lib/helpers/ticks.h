@@ -0,0 +1,37 @@
+/*
+ *
+ * Copyright (c) 2013, LiteStack, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef __TICKS_H__
+#define __TICKS_H__
+
+#include <stdint.h>
+
+/*cpu ticks counter used to measure time inside of zrt, because zrt
+ *time functions are synthetic and calling them would change time
+ *visible to user. Returns 0 on architectures without rdtsc*/
+#if defined(__x86_64__) || defined(__i386__)
+static inline uint64_t cpu_ticks(){
+    uint32_t lo, hi;
+    __asm__ __volatile__ ("rdtsc" : "=a"(lo), "=d"(hi));
+    return ((uint64_t)hi << 32) | lo;
+}
+#else
+static inline uint64_t cpu_ticks(){ return 0; }
+#endif
+
+#endif //__TICKS_H__
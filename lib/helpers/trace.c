@@ -0,0 +1,213 @@
+/*
+ * trace.c
+ * In memory spans and counters written at exit as Chrome trace events
+ *
+ * Copyright (c) 2013, LiteStack, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/stat.h> //S_IRUSR
+
+#include "zrtlog.h"
+#include "zrtapi.h"
+#include "zrt_helper_macros.h"
+#include "mounts_interface.h"
+#include "ticks.h" /*cpu_ticks*/
+#include "trace.h"
+
+#define TRACE_CHANNEL_NAME_MAX 256
+#define TRACE_WRITE_BUFFER_SIZE 4096
+/*enough for single event with escaped name*/
+#define TRACE_EVENT_JSON_MAX 1024
+/*ticks are written as "ts" field, where trace viewers are expecting
+ *microseconds, so divide to get readable scale*/
+#define TRACE_TICKS_PER_UNIT 1000
+
+typedef enum { ETraceArmed=0, ETraceOn, ETraceOff } TraceState;
+
+struct TraceEvent{
+    uint64_t    ticks;
+    int64_t     arg;   /*counter value, or duration of complete event*/
+    const char* name;
+    char        phase; /*'B','E','X','C' as trace event format defines*/
+};
+
+static TraceState        s_trace_state;
+static uint64_t          s_trace_threshold = TRACE_DEFAULT_ZCALL_THRESHOLD;
+static char              s_trace_channel[TRACE_CHANNEL_NAME_MAX];
+static struct TraceEvent s_trace_events[TRACE_MAX_EVENTS];
+static int               s_trace_count;
+static uint64_t          s_trace_dropped;
+
+void trace_enable(const char* channel, uint64_t threshold){
+    strncpy(s_trace_channel, channel, sizeof(s_trace_channel)-1);
+    s_trace_threshold = threshold;
+    s_trace_state = ETraceOn;
+}
+
+int trace_is_enabled(){
+    return s_trace_state != ETraceOff;
+}
+
+void trace_prolog_done(){
+    if ( s_trace_state == ETraceArmed ){
+	s_trace_state = ETraceOff;
+	s_trace_count = 0;
+	s_trace_dropped = 0;
+    }
+}
+
+static void trace_event(char phase, const char* name, uint64_t ticks, int64_t arg){
+    struct TraceEvent* event;
+    if ( s_trace_state == ETraceOff ) return;
+    if ( s_trace_count == TRACE_MAX_EVENTS ){
+	++s_trace_dropped;
+	return;
+    }
+    event = &s_trace_events[s_trace_count++];
+    event->ticks = ticks;
+    event->arg = arg;
+    event->name = name;
+    event->phase = phase;
+}
+
+void trace_begin(const char* name){
+    trace_event('B', name, cpu_ticks(), 0);
+}
+
+void trace_end(const char* name){
+    trace_event('E', name, cpu_ticks(), 0);
+}
+
+void trace_counter(const char* name, int64_t value){
+    trace_event('C', name, cpu_ticks(), value);
+}
+
+void trace_zcall(const char* name, uint64_t start_ticks, uint64_t end_ticks){
+    if ( end_ticks - start_ticks < s_trace_threshold ) return;
+    trace_event('X', name, start_ticks, end_ticks - start_ticks);
+}
+
+/*public api, see zrtapi.h*/
+void zrt_trace_begin(const char* name){
+    trace_begin(name);
+}
+
+void zrt_trace_end(const char* name){
+    trace_end(name);
+}
+
+void zrt_trace_counter(const char* name, int64_t value){
+    trace_counter(name, value);
+}
+
+/*copy name as JSON string contents
+ *@return length of escaped name*/
+static int trace_escape_name(char* buf, int size, const char* name){
+    int len=0;
+    if ( name == NULL ) name = "(null)";
+    for ( ; *name && len < size-7; name++ ){
+	unsigned char c = (unsigned char)*name;
+	if ( c == '"' || c == '\\' ){
+	    buf[len++] = '\\';
+	    buf[len++] = c;
+	}
+	else if ( c < 0x20 )
+	    len += sprintf(buf+len, "\\u%04x", c);
+	else
+	    buf[len++] = c;
+    }
+    buf[len] = '\0';
+    return len;
+}
+
+/*time in units relative to earliest event, as "integer.fraction"*/
+#define TRACE_TIME_ARGS(ticks)						\
+    (unsigned long long)((ticks) / TRACE_TICKS_PER_UNIT),		\
+	(unsigned)((ticks) % TRACE_TICKS_PER_UNIT)
+
+static int trace_format_event(char* buf, int size, const struct TraceEvent* event,
+			      uint64_t base_ticks, int first){
+    char name[TRACE_EVENT_JSON_MAX/2];
+    int len;
+    trace_escape_name(name, sizeof(name), event->name);
+    len = snprintf(buf, size, "%s\n{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%llu.%03u,"
+		   "\"pid\":1,\"tid\":1", first ? "" : ",", name, event->phase,
+		   TRACE_TIME_ARGS(event->ticks - base_ticks));
+    if ( event->phase == 'X' )
+	len += snprintf(buf+MIN(len, size), size > len ? size-len : 0,
+			",\"dur\":%llu.%03u", TRACE_TIME_ARGS((uint64_t)event->arg));
+    else if ( event->phase == 'C' )
+	len += snprintf(buf+MIN(len, size), size > len ? size-len : 0,
+			",\"args\":{\"value\":%lld}", (long long)event->arg);
+    len += snprintf(buf+MIN(len, size), size > len ? size-len : 0, "}");
+    return len;
+}
+
+/*write whole buffer
+ *@return 0 if OK, -1 on error*/
+static int trace_write_buf(struct MountsPublicInterface* mount, int fd,
+			   const char* buf, int len){
+    ssize_t res;
+    while ( len > 0 ){
+	res = mount->write(mount, fd, buf, len);
+	if ( res <= 0 ) return -1;
+	buf += res;
+	len -= res;
+    }
+    return 0;
+}
+
+int trace_write(struct MountsPublicInterface* mount){
+    char buf[TRACE_WRITE_BUFFER_SIZE];
+    int i, fd, len=0, res=0;
+    uint64_t base_ticks;
+    if ( s_trace_state != ETraceOn ) return 0;
+    /*zcalls made while writing should not be traced*/
+    s_trace_state = ETraceOff;
+
+    /*trace can be written into regular file as well as into channel*/
+    fd = mount->open(mount, s_trace_channel, O_WRONLY|O_CREAT|O_TRUNC, S_IRUSR|S_IWUSR);
+    if ( fd < 0 ){
+	ZRT_LOG(L_ERROR, "can't open trace channel %s, errno=%d", s_trace_channel, errno);
+	return -1;
+    }
+    /*complete events are recorded at end, so they can start before
+     *previously recorded events*/
+    base_ticks = s_trace_count > 0 ? s_trace_events[0].ticks : 0;
+    for ( i=1; i < s_trace_count; i++ )
+	base_ticks = MIN(base_ticks, s_trace_events[i].ticks);
+    len = snprintf(buf, sizeof(buf), "{\"traceEvents\":[");
+    for ( i=0; i < s_trace_count && res == 0; i++ ){
+	if ( len + TRACE_EVENT_JSON_MAX > (int)sizeof(buf) ){
+	    res = trace_write_buf(mount, fd, buf, len);
+	    len = 0;
+	}
+	len += trace_format_event(buf+len, sizeof(buf)-len, &s_trace_events[i],
+				  base_ticks, i==0);
+    }
+    len += snprintf(buf+len, sizeof(buf)-len,
+		    "\n],\"otherData\":{\"ts_unit\":\"%d cpu ticks\",\"dropped_events\":%llu}}\n",
+		    TRACE_TICKS_PER_UNIT, (unsigned long long)s_trace_dropped);
+    if ( res == 0 )
+	res = trace_write_buf(mount, fd, buf, len);
+    mount->close(mount, fd);
+    ZRT_LOG(L_SHORT, "trace events=%d, dropped=%llu written into %s, res=%d",
+	    s_trace_count, (unsigned long long)s_trace_dropped, s_trace_channel, res);
+    return res;
+}
@@ -0,0 +1,59 @@
+/*
+ * trace.h
+ * In memory spans and counters written at exit as Chrome trace events
+ *
+ * Copyright (c) 2013, LiteStack, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __TRACE_H__
+#define __TRACE_H__
+
+#include <stdint.h>
+
+/*Trace is recording events into static array, because it should work
+ *in prolog before heap is available. Tracing is armed at start, so
+ *events of early prolog phases are kept, and it's switched off by
+ *trace_prolog_done if nvram has no trace channel in [debug] section.
+ *Time is measured in cpu ticks like I/O statistics do; event names
+ *are not copied and must stay valid until exit.*/
+
+#define TRACE_MAX_EVENTS 0x2000
+/*zcalls took less ticks are not traced, if threshold is not set by nvram*/
+#define TRACE_DEFAULT_ZCALL_THRESHOLD 10000
+
+struct MountsPublicInterface;
+
+/*switch tracing on, events are written into channel at exit
+ *@param threshold minimal zcall duration in ticks to be traced*/
+void trace_enable(const char* channel, uint64_t threshold);
+int  trace_is_enabled();
+
+/*drop events recorded before nvram handling if tracing was not enabled*/
+void trace_prolog_done();
+
+/*nested span, begin and end must be paired*/
+void trace_begin(const char* name);
+void trace_end(const char* name);
+void trace_counter(const char* name, int64_t value);
+
+/*complete span of zcall, skipped if shorter than threshold*/
+void trace_zcall(const char* name, uint64_t start_ticks, uint64_t end_ticks);
+
+/*write all recorded events as JSON into trace channel and switch
+ *tracing off, does nothing if tracing is not enabled
+ *@return 0 if OK, -1 if channel can't be written*/
+int trace_write(struct MountsPublicInterface* mount);
+
+#endif //__TRACE_H__
@@ -20,10 +20,20 @@
 #include <stdlib.h>
 #include <unistd.h> //sbrk
 #include <limits.h>
+#include <errno.h>
+#include <sys/uio.h> //struct iovec
 
 #include "zrtlog.h"
+#include "zrt_helper_macros.h"
 #include "utils.h"
 
+#ifndef IOV_MAX
+#  define IOV_MAX 1024
+#endif
+#ifndef SSIZE_MAX
+#  define SSIZE_MAX INT_MAX
+#endif
+
 #define MERGE_PATH_COMPONENTS(path1, path2, result){		\
 	int path1len = strlen(path1);				\
 	strcpy(result, path1);					\
@@ -93,3 +103,40 @@ uint strtouint_nolocale(const char* str, int base, int *err ){
     return res;
 }
 
+
+
+ssize_t iovec_length( const struct iovec* iov, int iovcnt ){
+    int i;
+    size_t len=0;
+    if ( iovcnt < 0 || iovcnt > IOV_MAX || (iovcnt > 0 && iov == NULL) ){
+	SET_ERRNO(EINVAL);
+	return -1;
+    }
+    for ( i=0; i < iovcnt; i++ ){
+	if ( iov[i].iov_len > SSIZE_MAX - len ){
+	    SET_ERRNO(EINVAL);
+	    return -1;
+	}
+	len += iov[i].iov_len;
+    }
+    return (ssize_t)len;
+}
+
+void iovec_gather( char* dest, const struct iovec* iov, int iovcnt ){
+    int i;
+    for ( i=0; i < iovcnt; i++ ){
+	memcpy(dest, iov[i].iov_base, iov[i].iov_len);
+	dest += iov[i].iov_len;
+    }
+}
+
+void iovec_scatter( const struct iovec* iov, int iovcnt, const char* src, size_t len ){
+    int i;
+    size_t part;
+    for ( i=0; i < iovcnt && len > 0; i++ ){
+	part = MIN(iov[i].iov_len, len);
+	memcpy(iov[i].iov_base, src, part);
+	src += part;
+	len -= part;
+    }
+}
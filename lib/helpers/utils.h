@@ -19,6 +19,10 @@
 #ifndef __HELPERS_UTILS_H__
 #define __HELPERS_UTILS_H__
 
+#include <sys/types.h> //ssize_t
+
+struct iovec;
+
 /*
  * analog of realpath, that allows non existant file/dir as a last 
  * component path. 
@@ -32,4 +36,17 @@ char* zrealpath( const char* path, char* resolved_path );
 /*convert string to unsingned int, to be used in prolog, not used locale */
 uint strtouint_nolocale(const char* str, int base, int *err );
 
+/*
+ * Validate iovec array and get summary length of all buffers.
+ * @return total length, or -1 and errno set to EINVAL if iovcnt is
+ * out of range or summary length overflows ssize_t.
+ */
+ssize_t iovec_length( const struct iovec* iov, int iovcnt );
+
+/*copy data of all iovec buffers into single contiguous buffer dest*/
+void iovec_gather( char* dest, const struct iovec* iov, int iovcnt );
+
+/*distribute len bytes of src buffer over iovec buffers in order*/
+void iovec_scatter( const struct iovec* iov, int iovcnt, const char* src, size_t len );
+
 #endif //__HELPERS_UTILS_H__
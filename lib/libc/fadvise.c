@@ -0,0 +1,50 @@
+/*
+ * fadvise.c
+ * posix_fadvise implementation, advice is passed to mount owning file
+ *
+ * Copyright (c) 2013, LiteStack, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <sys/types.h>
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <assert.h>
+
+#include "zrt.h"
+#include "zcalls_zrt.h"
+#include "zcalls.h"
+#include "zrtlog.h"
+#include "zrt_helper_macros.h"
+#include "zrt_check.h"
+#include "transparent_mount.h"
+#include "mounts_interface.h"
+
+/*************************************************************************
+ * Implementation used by glibc, through zcall interface; It's not using weak alias;
+ **************************************************************************/
+
+int zrt_zcall_fadvise(int fd, off_t offset, off_t len, int advice){
+    CHECK_EXIT_IF_ZRT_NOT_READY;
+
+    LOG_SYSCALL_START("fd=%d offset=%lld len=%lld advice=%d", fd, offset, len, advice);
+    errno=0;
+
+    struct MountsPublicInterface* transpar_mount = transparent_mount();
+    assert(transpar_mount);
+    int ret = transpar_mount->fadvise(transpar_mount, fd, offset, len, advice);
+    LOG_SHORT_SYSCALL_FINISH(ret, "fd=%d advice=%d", fd, advice);
+    return ret;
+}
@@ -0,0 +1,55 @@
+/*
+ * mremap.c
+ * mremap implementation, mapping is resized by memory manager
+ *
+ * Copyright (c) 2013, LiteStack, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define _GNU_SOURCE /*MREMAP_MAYMOVE*/
+
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+
+#include "zcalls_zrt.h"
+#include "zcalls.h"
+#include "zrtlog.h"
+#include "zrt_helper_macros.h"
+#include "zrt_check.h"
+#include "memory_syscall_handlers.h"
+
+/*************************************************************************
+ * Implementation used by glibc, through zcall interface; It's not using weak alias;
+ **************************************************************************/
+
+int zrt_zcall_mremap(void **addr, size_t old_size, size_t new_size, int flags){
+    CHECK_EXIT_IF_ZRT_NOT_READY;
+    int32_t retcode;
+
+    LOG_SYSCALL_START("addr=%p old_size=%u new_size=%u flags=%d", 
+		      *addr, old_size, new_size, flags);
+    errno=0;
+
+    struct MemoryManagerPublicInterface* memif = memory_interface_instance();
+    retcode = memif->mremap(memif, *addr, old_size, new_size, flags);
+    if ( (void*)retcode != MAP_FAILED ){
+	*addr = (void*)retcode;
+	retcode=0;
+    }
+    LOG_SHORT_SYSCALL_FINISH( retcode, "addr=%p new_size=%u", *addr, new_size);
+    return retcode;
+}
@@ -0,0 +1,100 @@
+/*
+ * readv_writev.c
+ * readv, writev, preadv, pwritev
+ * implementation that substitude glibc implementation doing 
+ * read/write call per every iovec
+ *
+ * Copyright (c) 2013, LiteStack, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <errno.h>
+#include <assert.h>
+
+#include "zrt.h"
+#include "zcalls_zrt.h"
+#include "zcalls.h"
+#include "zrtlog.h"
+#include "zrt_helper_macros.h"
+#include "zrt_check.h"
+#include "transparent_mount.h"
+#include "mounts_interface.h"
+
+/*************************************************************************
+ * Implementation used by glibc, through zcall interface; It's not using weak alias;
+ **************************************************************************/
+
+ssize_t zrt_zcall_readv(int fd, const struct iovec *iov, int iovcnt){
+    CHECK_EXIT_IF_ZRT_NOT_READY;
+
+    LOG_SYSCALL_START("fd=%d iov=%p iovcnt=%d", fd, iov, iovcnt);
+    errno=0;
+
+    struct MountsPublicInterface* transpar_mount = transparent_mount();
+    assert(transpar_mount);
+    ssize_t ret = transpar_mount->readv(transpar_mount, fd, iov, iovcnt);
+    LOG_INFO_SYSCALL_FINISH(ret, "fd=%d iovcnt=%d", fd, iovcnt);
+    return ret;
+}
+
+ssize_t zrt_zcall_writev(int fd, const struct iovec *iov, int iovcnt){
+    CHECK_EXIT_IF_ZRT_NOT_READY;
+    int log_state;
+    errno=0;
+    DISABLE_LOG_FOR_STD_HANDLES(fd, &log_state);
+
+    LOG_SYSCALL_START("fd=%d iov=%p iovcnt=%d", fd, iov, iovcnt);
+
+    struct MountsPublicInterface* transpar_mount = transparent_mount();
+    assert(transpar_mount);
+    ssize_t ret = transpar_mount->writev(transpar_mount, fd, iov, iovcnt);
+    LOG_INFO_SYSCALL_FINISH(ret, "fd=%d iovcnt=%d", fd, iovcnt);
+    RESTORE_LOG_STATE(log_state);
+    return ret;
+}
+
+ssize_t zrt_zcall_preadv(int fd, const struct iovec *iov, int iovcnt, off_t offset){
+    CHECK_EXIT_IF_ZRT_NOT_READY;
+
+    LOG_SYSCALL_START("fd=%d iov=%p iovcnt=%d offset=%lld", fd, iov, iovcnt, offset);
+    errno=0;
+
+    struct MountsPublicInterface* transpar_mount = transparent_mount();
+    assert(transpar_mount);
+    ssize_t ret = transpar_mount->preadv(transpar_mount, fd, iov, iovcnt, offset);
+    LOG_INFO_SYSCALL_FINISH(ret, "fd=%d iovcnt=%d offset=%lld", fd, iovcnt, offset);
+    return ret;
+}
+
+ssize_t zrt_zcall_pwritev(int fd, const struct iovec *iov, int iovcnt, off_t offset){
+    CHECK_EXIT_IF_ZRT_NOT_READY;
+    int log_state;
+    errno=0;
+    DISABLE_LOG_FOR_STD_HANDLES(fd, &log_state);
+
+    LOG_SYSCALL_START("fd=%d iov=%p iovcnt=%d offset=%lld", fd, iov, iovcnt, offset);
+
+    struct MountsPublicInterface* transpar_mount = transparent_mount();
+    assert(transpar_mount);
+    ssize_t ret = transpar_mount->pwritev(transpar_mount, fd, iov, iovcnt, offset);
+    LOG_INFO_SYSCALL_FINISH(ret, "fd=%d iovcnt=%d offset=%lld", fd, iovcnt, offset);
+    RESTORE_LOG_STATE(log_state);
+    return ret;
+}
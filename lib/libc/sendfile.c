@@ -0,0 +1,74 @@
+/*
+ * sendfile.c
+ * sendfile, copy_file_range implementation, data is copied inside
+ * of zrt without user buffers
+ *
+ * Copyright (c) 2013, LiteStack, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <sys/types.h>
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <errno.h>
+#include <assert.h>
+
+#include "zrt.h"
+#include "zcalls_zrt.h"
+#include "zcalls.h"
+#include "zrtlog.h"
+#include "zrt_helper_macros.h"
+#include "zrt_check.h"
+#include "transparent_mount.h"
+
+/*************************************************************************
+ * Implementation used by glibc, through zcall interface; It's not using weak alias;
+ **************************************************************************/
+
+ssize_t zrt_zcall_sendfile(int out_fd, int in_fd, off_t *offset, size_t count){
+    CHECK_EXIT_IF_ZRT_NOT_READY;
+    int log_state;
+    DISABLE_LOG_FOR_STD_HANDLES(out_fd, &log_state);
+
+    LOG_SYSCALL_START("out_fd=%d in_fd=%d offset=%p count=%u", out_fd, in_fd, offset, count);
+    errno=0;
+
+    ssize_t ret = transparent_copy_range(in_fd, offset, out_fd, NULL, count);
+    LOG_INFO_SYSCALL_FINISH(ret, "out_fd=%d in_fd=%d count=%u", out_fd, in_fd, count);
+    RESTORE_LOG_STATE(log_state);
+    return ret;
+}
+
+ssize_t zrt_zcall_copy_file_range(int fd_in, off_t *off_in, int fd_out, off_t *off_out,
+				  size_t len, unsigned int flags){
+    CHECK_EXIT_IF_ZRT_NOT_READY;
+    int log_state;
+    DISABLE_LOG_FOR_STD_HANDLES(fd_out, &log_state);
+
+    LOG_SYSCALL_START("fd_in=%d off_in=%p fd_out=%d off_out=%p len=%u flags=%u", 
+		      fd_in, off_in, fd_out, off_out, len, flags);
+    errno=0;
+
+    ssize_t ret;
+    if ( flags != 0 ){
+	SET_ERRNO(EINVAL);
+	ret = -1;
+    }
+    else
+	ret = transparent_copy_range(fd_in, off_in, fd_out, off_out, len);
+    LOG_INFO_SYSCALL_FINISH(ret, "fd_in=%d fd_out=%d len=%u", fd_in, fd_out, len);
+    RESTORE_LOG_STATE(log_state);
+    return ret;
+}
@@ -24,12 +24,14 @@
 
 enum { EDataNotOwned=0, EDataOwned=1 };
 
-/*if data owned it will be freed, else nothing happens*/
+/*owned key and value are freed, else nothing happens*/
 #define TRY_FREE_MRITEM_DATA(elasticitem_p)				\
-    if ( (elasticitem_p)->own_value == EDataOwned )			\
-	free((void*)(elasticitem_p)->value.addr), (elasticitem_p)->value.addr=0; \
-    else if ( (elasticitem_p)->own_key == EDataOwned )			\
-	free((void*)(elasticitem_p)->key_data.addr), (elasticitem_p)->key_data.addr=0;
+    do{									\
+	if ( (elasticitem_p)->own_value == EDataOwned )			\
+	    free((void*)(elasticitem_p)->value.addr), (elasticitem_p)->value.addr=0; \
+	if ( (elasticitem_p)->own_key == EDataOwned )			\
+	    free((void*)(elasticitem_p)->key_data.addr), (elasticitem_p)->key_data.addr=0; \
+    }while(0)
 
 typedef struct BinaryData{
     uintptr_t addr;
@@ -42,11 +44,11 @@ typedef struct ElasticBufItemData{
     /*value.addr also may be interpreted as data depending of MR configuration,
      in this case value.size will not be used*/
     BinaryData     value; 
-    /*1-owned or 0-not value referred by pointer, for owned values they should be freed 
-      by user functions.*/
-    uint8_t        own_key; 
     /*1-owned or 0-not key referred by pointer, for owned keys they should be freed 
-      by user functions.*/
+      by user functions. Key allocated by MapArenaAlloc is not owned.*/
+    uint8_t        own_key; 
+    /*1-owned or 0-not value referred by pointer, for owned values they should be freed 
+      by user functions. Value allocated by MapArenaAlloc is not owned.*/
     uint8_t        own_value; 
     /*key_hash not strictly equal to 1byte, it can out of buond of declared structure
       because data type size can be configured at runtime, so real size of whole struct 
@@ -0,0 +1,83 @@
+/*
+ * Map side aggregation of items with equal hashes by hash table
+ *
+ * Copyright (c) 2013, LiteStack, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h> //calloc
+#include <stdio.h>
+#include <string.h> //memcmp
+#include <stdint.h>
+#include <assert.h>
+
+#include "map_reduce_lib.h"
+#include "mr_defines.h"
+#include "elastic_mr_item.h"
+#include "hash_fold.h"
+#include "key_hash.h"
+
+int
+FoldByHash( struct MapReduceUserIf *mif,
+	    const Buffer *map,
+	    Buffer *result,
+	    int max_items ){
+    int hash_size = HASH_SIZE(mif);
+    uint32_t table_size = 16;
+    uint32_t *table; /*index of result item +1, 0 for empty cell*/
+    const ElasticBufItemData *item;
+    ElasticBufItemData *folded;
+    uint32_t cell;
+    int i;
+
+    assert( mif->Fold );
+    assert( max_items >= 0 );
+    /*load factor is kept under 1/2*/
+    while ( table_size < 2*(uint32_t)MIN(map->header.count, max_items) ){
+	table_size <<= 1;
+    }
+    table = calloc( table_size, sizeof(uint32_t) );
+    IF_ALLOC_ERROR(table?0:table_size*sizeof(uint32_t));
+
+    for ( i=0; i < map->header.count; i++ ){
+	item = (const ElasticBufItemData*)BufferItemPointer( map, i );
+	/*key hash made by user can be bad for table index*/
+	cell = KeyHash64( &item->key_hash, hash_size, 0 ) & (table_size-1);
+	/*linear probing*/
+	while ( table[cell] ){
+	    folded = (ElasticBufItemData*)BufferItemPointer( result, table[cell]-1 );
+	    if ( !memcmp( &folded->key_hash, &item->key_hash, hash_size ) ) break;
+	    cell = (cell+1) & (table_size-1);
+	}
+	if ( table[cell] ){
+	    mif->Fold( folded, item );
+	}
+	else if ( result->header.count < max_items ){
+	    AddBufferItem( result, item );
+	    table[cell] = result->header.count;
+	}
+	else{
+	    /*too many distinct hashes, hash table doesn't help*/
+	    break;
+	}
+    }
+    free(table);
+    WRITE_FMT_LOG( "FoldByHash: %d items folded into %d\n", i, result->header.count );
+    if ( i == map->header.count ) return 0;
+
+    for ( ; i < map->header.count; i++ ){
+	AddBufferItem( result, BufferItemPointer( map, i ) );
+    }
+    return -1;
+}
@@ -0,0 +1,43 @@
+/*
+ * Map side aggregation of items with equal hashes by hash table
+ *
+ * Copyright (c) 2013, LiteStack, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef __HASH_FOLD_H__
+#define __HASH_FOLD_H__
+
+#include "buffer.h"
+
+//forward decl
+struct MapReduceUserIf;
+
+#define MAP_FOLD_TABLE_ITEMS_ENV      "MAP_FOLD_TABLE_ITEMS"
+/*default max count of distinct hashes folded in chunk*/
+#define DEFAULT_MAP_FOLD_TABLE_ITEMS  0x10000
+
+/*Fold items of map buffer with equal hashes into result by user Fold
+ *function, without sorting. If distinct hashes count exceeds max_items
+ *then folding stops and the rest of items are added into result as is.
+ *Result is not sorted.
+ *@return 0 if all items folded, -1 if not*/
+int
+FoldByHash( struct MapReduceUserIf *mif,
+	    const Buffer *map,
+	    Buffer *result,
+	    int max_items );
+
+#endif //__HASH_FOLD_H__
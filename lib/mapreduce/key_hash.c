@@ -0,0 +1,175 @@
+/*
+ * Built-in hash of keys for user Map functions, based on wyhash by
+ * Wang Yi released into the public domain
+ *
+ * Copyright (c) 2013, LiteStack, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <string.h> //memcpy
+#include <stdint.h>
+#include <assert.h>
+
+#include "map_reduce_lib.h"
+#include "mr_defines.h"
+#include "elastic_mr_item.h"
+#include "key_hash.h"
+
+static const uint64_t s_secret[4] = { 0xa0761d6478bd642full, 0xe7037ed1a0b428dbull,
+				      0x8ebc6af09c88c6e3ull, 0x589965cc75374cc3ull };
+
+/*128bit product of A and B, low half into A, high half into B*/
+static inline void
+Mum( uint64_t *A, uint64_t *B ){
+#if defined(__SIZEOF_INT128__)
+    __uint128_t r = *A;
+    r *= *B;
+    *A = (uint64_t)r;
+    *B = (uint64_t)(r >> 64);
+#else
+    uint64_t ha = *A >> 32, hb = *B >> 32, la = (uint32_t)*A, lb = (uint32_t)*B;
+    uint64_t rh = ha*hb, rm0 = ha*lb, rm1 = hb*la, rl = la*lb;
+    uint64_t t = rl + (rm0 << 32), c = t < rl, lo, hi;
+    lo = t + (rm1 << 32);
+    c += lo < t;
+    hi = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+    *A = lo;
+    *B = hi;
+#endif
+}
+
+static inline uint64_t
+Mix( uint64_t A, uint64_t B ){
+    Mum( &A, &B );
+    return A ^ B;
+}
+
+static inline uint64_t
+Read8( const uint8_t *p ){
+    uint64_t v;
+    memcpy( &v, p, sizeof(v) );
+    return v;
+}
+
+static inline uint64_t
+Read4( const uint8_t *p ){
+    uint32_t v;
+    memcpy( &v, p, sizeof(v) );
+    return v;
+}
+
+/*1..3 bytes*/
+static inline uint64_t
+Read3( const uint8_t *p, size_t k ){
+    return ((uint64_t)p[0] << 16) | ((uint64_t)p[k >> 1] << 8) | p[k-1];
+}
+
+uint64_t
+KeyHash64( const void *key, size_t size, uint64_t seed ){
+    const uint8_t *p = (const uint8_t*)key;
+    uint64_t a, b;
+    size_t i = size;
+    seed ^= Mix( seed ^ s_secret[0], s_secret[1] );
+    if ( size <= 16 ){
+	if ( size >= 4 ){
+	    a = (Read4(p) << 32) | Read4(p + ((size >> 3) << 2));
+	    b = (Read4(p+size-4) << 32) | Read4(p + size - 4 - ((size >> 3) << 2));
+	}
+	else if ( size > 0 ){
+	    a = Read3( p, size );
+	    b = 0;
+	}
+	else{
+	    a = b = 0;
+	}
+    }
+    else{
+	if ( i > 48 ){
+	    uint64_t see1 = seed, see2 = seed;
+	    do{
+		seed = Mix( Read8(p) ^ s_secret[1], Read8(p+8) ^ seed );
+		see1 = Mix( Read8(p+16) ^ s_secret[2], Read8(p+24) ^ see1 );
+		see2 = Mix( Read8(p+32) ^ s_secret[3], Read8(p+40) ^ see2 );
+		p += 48;
+		i -= 48;
+	    }while( i > 48 );
+	    seed ^= see1 ^ see2;
+	}
+	while ( i > 16 ){
+	    seed = Mix( Read8(p) ^ s_secret[1], Read8(p+8) ^ seed );
+	    i -= 16;
+	    p += 16;
+	}
+	a = Read8( p+i-16 );
+	b = Read8( p+i-8 );
+    }
+    a ^= s_secret[1];
+    b ^= seed;
+    Mum( &a, &b );
+    return Mix( a ^ s_secret[0] ^ size, b ^ s_secret[1] );
+}
+
+void
+KeyHash( const void *key, size_t size, void *hash, int hash_size ){
+    uint8_t *dest = (uint8_t*)hash;
+    uint64_t word = 0;
+    int i;
+    /*bytes of word are copied in little endian order on any platform*/
+    for ( i=0; i < hash_size; i++ ){
+	if ( i % sizeof(word) == 0 )
+	    word = KeyHash64( key, size, i / sizeof(word) );
+	dest[i] = (uint8_t)(word >> 8*(i % sizeof(word)));
+    }
+}
+
+/*variant for hash size known at compile time*/
+static inline void
+KeyHashItemsSized( Buffer *map, int start, int hash_size ){
+    ElasticBufItemData *item;
+    uint64_t word;
+    int i;
+    for ( i=start; i < map->header.count; i++ ){
+	item = (ElasticBufItemData*)BufferItemPointer( map, i );
+	if ( HASH_SIZE_SPECIALIZED(hash_size) && hash_size <= 8 ){
+	    word = KeyHash64( (const void*)item->key_data.addr, item->key_data.size, 0 );
+	    memcpy( &item->key_hash, &word, hash_size );
+	}
+	else{
+	    KeyHash( (const void*)item->key_data.addr, item->key_data.size,
+		     &item->key_hash, hash_size );
+	}
+    }
+}
+
+void
+KeyHashBufferItems( const struct MapReduceUserIf *mif, Buffer *map, int start ){
+    switch ( HASH_SIZE(mif) ){
+    case 4:  KeyHashItemsSized( map, start, 4 ); break;
+    case 8:  KeyHashItemsSized( map, start, 8 ); break;
+    default: KeyHashItemsSized( map, start, HASH_SIZE(mif) ); break;
+    }
+}
+
+char*
+HashAsStringDefault( char *str, const uint8_t *hash, int size ){
+    static const char digits[] = "0123456789abcdef";
+    int i;
+    for ( i=0; i < size; i++ ){
+	str[2*i]   = digits[ hash[size-1-i] >> 4 ];
+	str[2*i+1] = digits[ hash[size-1-i] & 0xf ];
+    }
+    str[2*size] = '\0';
+    return str;
+}
@@ -0,0 +1,54 @@
+/*
+ * Built-in hash of keys for user Map functions
+ *
+ * Copyright (c) 2013, LiteStack, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef __KEY_HASH_H__
+#define __KEY_HASH_H__
+
+#include <stddef.h> //size_t
+#include <stdint.h>
+
+#include "buffer.h"
+
+//forward decl
+struct MapReduceUserIf;
+
+/*64bit hash of key data, it's wyhash algorithm: fast for short keys and
+ *passes SMHasher, so it gives even partitioning by any hash bytes*/
+uint64_t
+KeyHash64( const void *key, size_t size, uint64_t seed );
+
+/*Hash of key written into hash of hash_size bytes, hash can be
+ *unaligned. Up to 8 bytes it's the low bytes of KeyHash64, every next 8
+ *bytes are got by KeyHash64 with another seed, so long hashes are not
+ *collide more than 64bit one*/
+void
+KeyHash( const void *key, size_t size, void *hash, int hash_size );
+
+/*Set key_hash of map items starting from start item by hash of their
+ *keys, for Map to hash all emitted items at once*/
+void
+KeyHashBufferItems( const struct MapReduceUserIf *mif, Buffer *map, int start );
+
+/*Default DebugHashAsString: hex string, most significant byte first as
+ *default hash order is
+ *@param str at least size*2+1 bytes*/
+char*
+HashAsStringDefault( char *str, const uint8_t *hash, int size );
+
+#endif //__KEY_HASH_H__
@@ -0,0 +1,130 @@
+/*
+ * Arena for keys and values of map items
+ *
+ * Copyright (c) 2013, LiteStack, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h> //malloc
+#include <stdio.h>
+#include <string.h> //memcpy
+#include <stdint.h>
+#include <assert.h>
+
+#include "mr_defines.h"
+#include "map_arena.h"
+
+struct MapArenaBlock{
+    struct MapArenaBlock *next;
+    size_t                size;  /*size of data*/
+    size_t                used;
+    char                  data[];
+};
+
+/*current block is the head of list, map node is single threaded*/
+static struct MapArenaBlock *s_arena = NULL;
+/*bytes used in blocks that are not current anymore*/
+static size_t s_arena_used_before = 0;
+
+static struct MapArenaBlock*
+MapArenaNewBlock( size_t size ){
+    struct MapArenaBlock *block = malloc( sizeof(struct MapArenaBlock)+size );
+    IF_ALLOC_ERROR(block?0:(int)size);
+    block->size = size;
+    block->used = 0;
+    return block;
+}
+
+/*@param align power of 2*/
+static inline void*
+MapArenaAllocAligned( size_t size, size_t align ){
+    struct MapArenaBlock *block;
+    size_t pos;
+    if ( s_arena ){
+	pos = (s_arena->used + align-1) & ~(align-1);
+	if ( pos + size <= s_arena->size ){
+	    s_arena->used = pos + size;
+	    return s_arena->data + pos;
+	}
+    }
+    if ( size > MAP_ARENA_BLOCK_SIZE/4 ){
+	/*big data gets own block placed after current block, so the rest
+	 *of current block is still used by next allocations*/
+	block = MapArenaNewBlock( size );
+	block->used = size;
+	if ( s_arena ){
+	    block->next = s_arena->next;
+	    s_arena->next = block;
+	    s_arena_used_before += size;
+	}
+	else{
+	    /*it's current block now, its used bytes are counted as current*/
+	    block->next = NULL;
+	    s_arena = block;
+	}
+	return block->data;
+    }
+    block = MapArenaNewBlock( MAP_ARENA_BLOCK_SIZE );
+    block->next = s_arena;
+    if ( s_arena ) s_arena_used_before += s_arena->used;
+    s_arena = block;
+    block->used = size;
+    return block->data;
+}
+
+void*
+MapArenaAlloc( size_t size ){
+    return MapArenaAllocAligned( size, MAP_ARENA_ALIGN );
+}
+
+char*
+MapArenaDup( const void *data, size_t size ){
+    char *copy = MapArenaAllocAligned( size+1, 1 );
+    memcpy( copy, data, size );
+    copy[size] = '\0';
+    return copy;
+}
+
+void
+MapArenaReset(){
+    struct MapArenaBlock *block, *keep = NULL;
+    while ( s_arena ){
+	block = s_arena;
+	s_arena = block->next;
+	if ( keep == NULL && block->size == MAP_ARENA_BLOCK_SIZE ){
+	    keep = block;
+	}
+	else{
+	    free(block);
+	}
+    }
+    if ( keep ){
+	keep->next = NULL;
+	keep->used = 0;
+    }
+    s_arena = keep;
+    s_arena_used_before = 0;
+}
+
+void
+MapArenaFree(){
+    MapArenaReset();
+    free(s_arena);
+    s_arena = NULL;
+}
+
+size_t
+MapArenaUsed(){
+    return s_arena_used_before + (s_arena ? s_arena->used : 0);
+}
@@ -0,0 +1,57 @@
+/*
+ * Arena for keys and values of map items, it's freed by whole after
+ * chunk is sent to reducers
+ *
+ * Copyright (c) 2013, LiteStack, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef __MAP_ARENA_H__
+#define __MAP_ARENA_H__
+
+#include <stddef.h> //size_t
+
+/*arena memory is taken from system by blocks of this size, bigger
+ *allocations are got by separate blocks*/
+#define MAP_ARENA_BLOCK_SIZE 0x100000
+/*alignment of MapArenaAlloc result*/
+#define MAP_ARENA_ALIGN      sizeof(void*)
+
+/*Allocate memory for key or value of map item in user Map or Combine.
+ *Memory is valid until current chunk is sent to reducers and then it's
+ *freed by library at once, so item referring it should be marked as
+ *EDataNotOwned. On reduce node memory is freed after Reduce.
+ *@return aligned pointer*/
+void*
+MapArenaAlloc( size_t size );
+
+/*Copy data into arena, result is not aligned and null terminated,
+ *it's convenient for keys and values parsed from input*/
+char*
+MapArenaDup( const void *data, size_t size );
+
+/*Free all memory allocated from arena, single block is kept for reuse*/
+void
+MapArenaReset();
+
+/*Free arena entirely*/
+void
+MapArenaFree();
+
+/*@return bytes allocated from arena since last reset*/
+size_t
+MapArenaUsed();
+
+#endif //__MAP_ARENA_H__
@@ -44,6 +44,8 @@ struct MapReduceData{
     int mr_item_size;     /*user must provide right mr item structure size*/
     int hash_size;        /*set BufItemElastic::key_hash size*/
     int value_addr_is_data; /*use BufItemElastic::addr as data*/
+    int cmp_hash_size;    /*hash size of built-in specialized comparator,
+			    0 if user comparator or size is not specialized*/
     //internals
     Histogram *histograms_list;
     int        histograms_count; /*histograms count is equal to map nodes count*/
@@ -51,14 +53,22 @@ struct MapReduceData{
 };
 
 
+/*Input data of map node, data not handled by Map is kept for next chunk*/
+struct MapInputBuffer{
+    char  *data;       /*it's null terminated*/
+    size_t size;       /*allocated size*/
+    size_t data_size;
+    size_t chunk_size; /*preferred size of chunk passed into Map*/
+    int    eof;        /*1 if all input is read*/
+};
+
 /*currently pointer functions not used, but real function exist in 'internals' section*/
 struct MapNodeEvents{
-    /*@return actual data size copied into input_buffer from input(file|stdin) */
+    /*@return actual data size in input buffer read from input(file|stdin) */
     size_t
     (*MapInputDataProvider)( int fd, 
-			     char **input_buffer, 
-			     size_t requested_buf_size, 
-			     int unhandled_data_pos );
+			     struct MapInputBuffer *input, 
+			     size_t unhandled_data_pos );
     /* @param buf input  buffer
      * @param buf_size  buffer size
      * @param result_keys Saving orocessed keys. should be valid pointer.
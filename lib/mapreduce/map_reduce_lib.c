@@ -23,84 +23,113 @@
 #include <sys/types.h> //temp read file
 #include <sys/stat.h> //temp read file
 #include <fcntl.h> //temp read file
+#include <sys/uio.h> //writev
 #include <assert.h> //assert
 #include <alloca.h>
 
+#include "zrtapi.h" //zrt_trace_*
 #include "map_reduce_lib.h"
 #include "mr_defines.h"
 #include "elastic_mr_item.h"
 #include "eachtoother_comm.h"
 #include "channels_conf.h"
-#include "buffered_io.h"
+#include "reduce_spill.h"
+#include "hash_fold.h"
+#include "map_arena.h"
 
 #include "buffer.h"
 
-#define BUFFERED_READ_ASSERT(r_bytes_p, r_bio, r_desc, r_buf, r_size ){		\
-	int cur_read = r_bio->read( (r_bio), (r_desc), (void*)(r_buf), (r_size)); \
-	assert(cur_read>0);						\
-	*(r_bytes_p) += cur_read;					\
-    }
+/*spans are recorded by zrt tracing, references are weak to keep
+ *library usable without libzrt, then spans are just skipped*/
+#pragma weak zrt_trace_begin
+#pragma weak zrt_trace_end
+#define MR_TRACE_BEGIN(name) { if ( zrt_trace_begin != NULL ) zrt_trace_begin(name); }
+#define MR_TRACE_END(name)   { if ( zrt_trace_end != NULL ) zrt_trace_end(name); }
+
 
 
-static size_t 
+size_t 
 MapInputDataProvider( int fd, 
-		      char **input_buffer, 
-		      size_t requested_buf_size, 
-		      int unhandled_data_pos ){
-    WRITE_FMT_LOG("MapInputDataProvider *input_buffer=%p, fd=%d, "
-		  "requested_buf_size=%u, unhandled_data_pos=%d\n",
-		  *input_buffer, fd, (uint32_t)requested_buf_size, unhandled_data_pos );
-    size_t rest_data_in_buffer = requested_buf_size - unhandled_data_pos;
-    int first_call = *input_buffer == NULL ? 1 : 0;
-    if ( !*input_buffer ){
-	/*if input buffer not yet initialized then alloc it. 
-	  It should be deleted by our framework after use*/
-	*input_buffer = calloc( requested_buf_size+1, sizeof(char) );
-	/*no data in buffer, it seems to be a first call of DataProvider*/
-	rest_data_in_buffer = 0;
+		      struct MapInputBuffer *input, 
+		      size_t unhandled_data_pos ){
+    WRITE_FMT_LOG("MapInputDataProvider input->data=%p, fd=%d, "
+		  "chunk_size=%u, unhandled_data_pos=%u\n",
+		  input->data, fd, (uint32_t)input->chunk_size, (uint32_t)unhandled_data_pos );
+    assert( input->chunk_size > 0 );
+    /*For first call of DataProvider unhandled_data_pos is ignoring*/
+    size_t rest_data_in_buffer = 0;
+    if ( input->data_size ){
+	assert( unhandled_data_pos <= input->data_size );
+	rest_data_in_buffer = input->data_size - unhandled_data_pos;
     }
-
-    /**********************************************************************
-     * Check for unsupported data handling. User should get handled data pos,
-     * and we should concatenate unprocessed data with new data from input file.
-     * For first launch of DataProvider unhandled_data_pos is ignoring*/
-    if ( !first_call ){
-	if ( !unhandled_data_pos ){
-	    /* user Map function not hadnled data at all. In any case user Map must
-	     * handle data, but in case if insufficiently of data in input buffer
-	     * then user should increase buffer size via MAP_CHUNK_SIZE*/
-	    assert( unhandled_data_pos );
-	}
-	else if ( unhandled_data_pos < requested_buf_size/2 ){
-	    /* user Map function hadnled less than half of data. In normal case we need
-	     * to move the rest of data to begining of buffer, but we can't do it just
-	     * move because end of moved data and start of unhandled data is overlaps;
-	     * For a while we don't want create another heap buffers to join rest data 
-	     * and new data; */
-	    assert( unhandled_data_pos > requested_buf_size/2 );
-	}
-	else if ( unhandled_data_pos != requested_buf_size )
-	    {
-		/*if not all data processed by previous call of DataProvider 
-		 *then copy the rest into input_buffer*/
-		memcpy( (*input_buffer), 
-			(*input_buffer)+unhandled_data_pos, 
-			rest_data_in_buffer );
-	    }
+    /*Buffer is large enough to read whole chunk, but if the most of buffer is
+     *occupied by unhandled data, for example Map waiting for long record end,
+     *then it grows, so read is never small and any leftover is supported*/
+    size_t wanted_size = input->chunk_size;
+    if ( rest_data_in_buffer > input->chunk_size/2 ){
+	wanted_size = rest_data_in_buffer + input->chunk_size;
     }
-    ssize_t readed = read( fd, 
-			   *input_buffer, 
-			   requested_buf_size - rest_data_in_buffer );
-    assert(readed>0);
-
-    WRITE_FMT_LOG("MapInputDataProvider OK return handled bytes=%u\n", 
-		  (uint32_t)(rest_data_in_buffer+readed) );
-    return rest_data_in_buffer+readed;
+    if ( input->size < wanted_size+1 ){
+	input->data = realloc( input->data, wanted_size+1 );
+	IF_ALLOC_ERROR(input->data?0:wanted_size+1);
+	input->size = wanted_size+1;
+    }
+    /*concatenate unprocessed data with new data from input file, Map
+     *result is not referring input buffer at this point*/
+    if ( rest_data_in_buffer && unhandled_data_pos ){
+	memmove( input->data, input->data+unhandled_data_pos, rest_data_in_buffer );
+    }
+    input->data_size = rest_data_in_buffer;
+
+    /*read until chunk is filled, input can return less data than requested*/
+    while ( !input->eof && input->data_size < wanted_size ){
+	ssize_t readed = read( fd, 
+			       input->data + input->data_size, 
+			       wanted_size - input->data_size );
+	assert(readed>=0);
+	if ( readed == 0 ) 
+	    input->eof = 1;
+	input->data_size += readed;
+    }
+    input->data[input->data_size] = '\0';
+
+    WRITE_FMT_LOG("MapInputDataProvider OK return data bytes=%u, eof=%d\n", 
+		  (uint32_t)input->data_size, input->eof );
+    return input->data_size;
 }
 
 
+/*qsort comparator has no context, it's used to order items by user
+ *ComparatorHash if item comparator is not provided*/
+static struct MapReduceUserIf *s_sort_mif;
+
+static int
+ComparatorMrItemByHash( const void *p1, const void *p2 ){
+    return HASH_CMP( s_sort_mif, 
+		     &((const ElasticBufItemData*)p1)->key_hash, 
+		     &((const ElasticBufItemData*)p2)->key_hash );
+}
+
 void 
 LocalSort( struct MapReduceUserIf *mif, Buffer *sortable ){
+    if ( mif->ComparatorMrItem == NULL && mif->ComparatorHash == NULL ){
+	/*items ordered only by hash in default order, the same as
+	 *HASH_CMP gives, sort it without comparator calls*/
+	int res = RadixSortByHash( sortable, HASH_SIZE(mif) );
+	IF_ALLOC_ERROR(res);
+	return;
+    }
+    else if ( mif->ComparatorMrItem == NULL ){
+	/*items must be sorted in the same order as user hash comparator
+	 *gives, dividers, histograms and merge are using it*/
+	s_sort_mif = mif;
+	qsort( sortable->data, 
+	       sortable->header.count, 
+	       sortable->header.item_size, 
+	       ComparatorMrItemByHash );
+	s_sort_mif = NULL;
+	return;
+    }
     /*sort created array*/
     qsort( sortable->data, 
 	   sortable->header.count, 
@@ -390,6 +419,32 @@ MapInputDataLocalProcessing( struct MapReduceUserIf *mif,
 		  (uint32_t)sort.header.count, (uint32_t)unhandled_data_pos );
 
     WRITE_LOG_BUFFER(mif, sort );
+
+    /*aggregate items by hash table, only distinct items are sorted*/
+    if ( mif->Fold ){
+	int max_items = DEFAULT_MAP_FOLD_TABLE_ITEMS;
+	if ( getenv(MAP_FOLD_TABLE_ITEMS_ENV) )
+	    max_items = atoi(getenv(MAP_FOLD_TABLE_ITEMS_ENV));
+	if ( max_items < 0 ){
+	    WRITE_FMT_LOG("wrong %s=%d, default is used\n", 
+			  MAP_FOLD_TABLE_ITEMS_ENV, max_items);
+	    max_items = DEFAULT_MAP_FOLD_TABLE_ITEMS;
+	}
+	res = AllocBuffer(result, MRITEM_SIZE(mif), MIN(sort.header.count, max_items)+1 );
+	IF_ALLOC_ERROR(res);
+	res = FoldByHash( mif, &sort, result, max_items );
+	FreeBufferData(&sort);
+	if ( res == 0 ){
+	    LocalSort( mif, result );
+	    WRITE_FMT_LOG("MapCallEvent: Fold Complete, count=%u\n", (uint32_t)result->header.count);
+	    WRITE_LOG_BUFFER(mif, *result );
+	    return unhandled_data_pos;
+	}
+	/*too many distinct hashes, partially folded items are sorted and combined*/
+	sort = *result;
+	memset( result, '\0', sizeof(*result) );
+    }
+
     LocalSort( mif, &sort);
 
     WRITE_FMT_LOG("MapCallEvent:sorted map, count=%u\n", (uint32_t)sort.header.count);
@@ -467,150 +522,221 @@ MapCreateHistogramSendEachToOtherCreateDividersList( struct ChannelsConfigInterf
     free(reduce_nodes_list);
 }
 
-static int
-BufferedWriteSingleMrItem( BufferedIOWrite* bio, 
-			   int fdw,
-			   const ElasticBufItemData* item,
-			   int hashsize,
-			   int value_addr_is_data){
-    int bytes=0;
-    /*key size*/
-    bytes+=bio->write( bio, fdw, (void*)&item->key_data.size, sizeof(item->key_data.size));
-    /*key data*/
-    bytes+=bio->write( bio, fdw, (void*)item->key_data.addr, item->key_data.size);
-
-    if ( value_addr_is_data ){
-	/*ElasticBufItemData::key_data::addr used as data, key_data::size not used*/
-	bytes+=bio->write( bio, fdw, (void*)&item->value.addr, sizeof(item->value.addr) );
+/*Write all iovecs, short writes are continued*/
+static void
+WriteVectorFull( int fd, struct iovec *iov, int iovcnt ){
+    ssize_t wrote;
+    while ( iovcnt > 0 ){
+	wrote = writev( fd, iov, iovcnt );
+	assert( wrote > 0 );
+	/*skip written iovecs and advance partially written one*/
+	while ( iovcnt > 0 && (size_t)wrote >= iov->iov_len ){
+	    wrote -= iov->iov_len;
+	    ++iov, --iovcnt;
+	}
+	if ( iovcnt > 0 ){
+	    iov->iov_base = (char*)iov->iov_base + wrote;
+	    iov->iov_len -= wrote;
+	}
+    }
+}
+
+static void
+ReadFull( int fd, void *buf, size_t size ){
+    ssize_t cur_read;
+    while ( size > 0 ){
+	cur_read = read( fd, buf, size );
+	assert(cur_read>0);
+	buf = (char*)buf + cur_read;
+	size -= cur_read;
+    }
+}
+
+static void
+ShuffleWriteIovecs( struct ShuffleWriter *writer ){
+    if ( writer->iovcnt ){
+	WriteVectorFull( writer->fd, writer->iov, writer->iovcnt );
+	writer->iovcnt = 0;
+	writer->staging_used = 0;
+    }
+}
+
+/*add data to be written by next writev, data continuing previous
+ *iovec is joined with it*/
+static void
+ShuffleAddIovec( struct ShuffleWriter *writer, const char *data, size_t size ){
+    struct iovec *last = writer->iovcnt ? &writer->iov[writer->iovcnt-1] : NULL;
+    if ( last && (const char*)last->iov_base + last->iov_len == data ){
+	last->iov_len += size;
     }
     else{
-	/*value size*/
-	bytes+=bio->write( bio, fdw, (void*)&item->value.size, sizeof(item->value.size));
-	/*value data*/
-	bytes+=bio->write( bio, fdw,(void*)item->value.addr, item->value.size);
+	if ( writer->iovcnt == SHUFFLE_IOV_MAX ){
+	    ShuffleWriteIovecs( writer );
+	}
+	writer->iov[writer->iovcnt].iov_base = (void*)data;
+	writer->iov[writer->iovcnt].iov_len = size;
+	++writer->iovcnt;
     }
-    /*hash of key*/
-    bytes+=bio->write( bio, fdw, (void*)&item->key_hash, hashsize );
-    return bytes;
 }
 
-static int
-BufferedReadSingleMrItem( BufferedIORead* bio, 
-			  int fdr,
-			  ElasticBufItemData* item,
-			  int hashsize,
-			  int value_addr_is_data){
-    int bytes=0;
-    /*key size*/
-    BUFFERED_READ_ASSERT( &bytes, bio, fdr, (void*)&item->key_data.size, sizeof(item->key_data.size) );
-    /*key data*/
-    item->key_data.addr = (uintptr_t)malloc(item->key_data.size);
-    item->own_key = EDataOwned;
-    BUFFERED_READ_ASSERT( &bytes, bio, fdr, (void*)item->key_data.addr, item->key_data.size );
-    if ( value_addr_is_data ){
-	/*ElasticBufItemData::key_data::addr used as data, key_data::size not used*/
-	BUFFERED_READ_ASSERT( &bytes, bio, fdr, (void*)&item->value.addr, sizeof(item->value.addr) );
-	item->own_value = EDataNotOwned;
-	item->value.size = 0;
+/*get space in staging buffer, previously staged data is written if no
+ *space left*/
+static char*
+ShuffleStagingAlloc( struct ShuffleWriter *writer, size_t size ){
+    char *staged;
+    assert( size <= writer->staging_size );
+    if ( writer->staging_used + size > writer->staging_size
+	 || writer->iovcnt == SHUFFLE_IOV_MAX ){
+	ShuffleWriteIovecs( writer );
+    }
+    staged = writer->staging + writer->staging_used;
+    writer->staging_used += size;
+    ShuffleAddIovec( writer, staged, size );
+    return staged;
+}
+
+/*move pending data into iovecs, small data is copied into staging buffer*/
+static void
+ShuffleCommitPending( struct ShuffleWriter *writer ){
+    size_t size = writer->pending_size;
+    if ( !size ) return;
+    writer->pending_size = 0;
+    if ( size < SHUFFLE_DIRECT_WRITE_MIN ){
+	memcpy( ShuffleStagingAlloc( writer, size ), writer->pending, size );
     }
     else{
+	ShuffleAddIovec( writer, writer->pending, size );
+    }
+}
 
-	/*value size*/
-	BUFFERED_READ_ASSERT( &bytes, bio, fdr, (void*)&item->value.size, sizeof(item->value.size) );
-	/*value data*/
-	item->value.addr = (uintptr_t)malloc(item->value.size);
-	item->own_value=EDataOwned;
-	BUFFERED_READ_ASSERT( &bytes, bio, fdr, (void*)item->value.addr, item->value.size );
+/*Data adjacent to previously appended is joined with it, so contiguous
+ *data like arena packed keys is written directly from its memory, and
+ *small scattered pieces are copied into staging buffer. Data must be
+ *valid until ShuffleFlush*/
+static void
+ShuffleAppend( struct ShuffleWriter *writer, const void *data, size_t size ){
+    if ( !size ) return;
+    if ( writer->pending_size && writer->pending + writer->pending_size == data ){
+	writer->pending_size += size;
+	return;
     }
-    /*key hash*/
-    BUFFERED_READ_ASSERT( &bytes, bio, fdr, (void*)&item->key_hash, hashsize );
-    return bytes;
+    ShuffleCommitPending( writer );
+    writer->pending = data;
+    writer->pending_size = size;
 }
- 
+
+/*get space to be filled by caller, written in order with appended data*/
+static char*
+ShuffleReserve( struct ShuffleWriter *writer, size_t size ){
+    ShuffleCommitPending( writer );
+    return ShuffleStagingAlloc( writer, size );
+}
+
+static void
+ShuffleFlush( struct ShuffleWriter *writer ){
+    ShuffleCommitPending( writer );
+    ShuffleWriteIovecs( writer );
+}
+
+/*item header in packet: key size, value data or value size, key hash*/
+#define SHUFFLE_ITEM_HEADER_SIZE(mif_p)					\
+    ( sizeof(((struct BinaryData*)0)->size) + HASH_SIZE(mif_p) +	\
+      ((mif_p)->data.value_addr_is_data ?				\
+       sizeof(((struct BinaryData*)0)->addr) : sizeof(((struct BinaryData*)0)->size)) )
 
 static size_t
-CalculateSendingDataSize(const Buffer *map, 
-			 int data_start_index, 
-			 int items_count,
-			 int hashsize,
-			 int value_addr_is_data)
+CalculatePayloadSize(const Buffer *map, 
+		     int data_start_index, 
+		     int items_count,
+		     int value_addr_is_data)
 {
-    /*calculate sending data of size */
-    size_t senddatasize= 0;
-    senddatasize += sizeof(int) + sizeof(int); //last_data_flag,items count
+    size_t payload_size= 0;
     int loop_up_to_count = data_start_index+items_count;
     const ElasticBufItemData* item;
 
     for( int i=data_start_index; i < loop_up_to_count; i++ ){
 	item = (const ElasticBufItemData*)BufferItemPointer( map, i );
-	senddatasize+= item->key_data.size;     /*size of key data*/
+	payload_size+= item->key_data.size;     /*size of key data*/
 	if ( !value_addr_is_data )
-	    senddatasize+= item->value.size;    /*size of value data*/
+	    payload_size+= item->value.size;    /*size of value data*/
     }
-    /*size of value data / value size*/
-    //value data/size
-    if ( value_addr_is_data )
-	senddatasize+= items_count * sizeof(((struct BinaryData*)0)->addr);
-    else
-	senddatasize+= items_count * sizeof(((struct BinaryData*)0)->size);
-    /*size of hash*/
-    senddatasize+= items_count * hashsize;
-    /*size of key size*/
-    senddatasize+= items_count * sizeof(((struct BinaryData*)0)->size);
-    /*************************************/
-    WRITE_FMT_LOG( "senddatasize=%d\n", senddatasize );
-    return senddatasize;
+    return payload_size;
 }
  
 void 
 WriteDataToReduce( struct MapReduceUserIf *mif,
-		   BufferedIOWrite* bio, 
+		   struct ShuffleWriter *writer, 
 		   int fdw, 
 		   const Buffer *map, 
 		   int data_start_index, 
 		   int items_count,
 		   int last_data_flag ){
-    int bytes=0;
-    ElasticBufItemData* current = alloca( MRITEM_SIZE(mif) );
     int loop_up_to_count = data_start_index+items_count;
+    const ElasticBufItemData* item;
+    char *header;
     assert( loop_up_to_count <= map->header.count );
 
-    int senddatasize = CalculateSendingDataSize(map, 
-						data_start_index, 
-						items_count, 
-						HASH_SIZE(mif),
-						mif->data.value_addr_is_data);
+    /*packet: last data flag, items count, item headers, packed keys and values*/
+    int senddatasize = sizeof(int) + sizeof(int) 
+	+ items_count*SHUFFLE_ITEM_HEADER_SIZE(mif)
+	+ CalculatePayloadSize(map, 
+			       data_start_index, 
+			       items_count, 
+			       mif->data.value_addr_is_data);
+    WRITE_FMT_LOG( "senddatasize=%d\n", senddatasize );
 
     /*log first and last hashes of range to send */
 #ifdef DEBUG
     WRITE_FMT_LOG( "data_start_index=%d, items_count=%d\n", 
 		   data_start_index, items_count );
-    ElasticBufItemData* temp = alloca( MRITEM_SIZE(mif) );
-    GetBufferItem( map, data_start_index, current );
-    GetBufferItem( map, data_start_index+items_count-1, temp ); /*last item from range*/
-    WRITE_FMT_LOG( "send range of hashes [%s - %s]",
-		   PRINTABLE_HASH(mif, &current->key_hash), 
-		   PRINTABLE_HASH(mif, &temp->key_hash) );
+    if ( items_count > 0 ){
+	ElasticBufItemData* current = alloca( MRITEM_SIZE(mif) );
+	ElasticBufItemData* temp = alloca( MRITEM_SIZE(mif) );
+	GetBufferItem( map, data_start_index, current );
+	GetBufferItem( map, data_start_index+items_count-1, temp ); /*last item from range*/
+	WRITE_FMT_LOG( "send range of hashes [%s - %s]",
+		       PRINTABLE_HASH(mif, &current->key_hash), 
+		       PRINTABLE_HASH(mif, &temp->key_hash) );
+    }
     WRITE_FMT_LOG( "fdw=%d, last_data_flag=%d, items_count=%d\n", 
 		   fdw, last_data_flag, items_count );
 #endif //DEBUG
 
-    bio->write( bio, fdw, &senddatasize, sizeof(int) );
-    
-    /*write last data flag 0 | 1, if reducer receives 1 then it
-      should exclude this map node from communications*/
-    bytes+= bio->write( bio, fdw, &last_data_flag, sizeof(int) );
-    /*items count we want send to a single reducer*/
-    bytes+= bio->write( bio, fdw, &items_count, sizeof(int) );
+    writer->fd = fdw;
+    /*packet size, last data flag 0 | 1, if reducer receives 1 then it
+      should exclude this map node from communications; and items
+      count we want send to a single reducer*/
+    header = ShuffleReserve( writer, 3*sizeof(int) );
+    memcpy( header, &senddatasize, sizeof(int) );
+    memcpy( header+sizeof(int), &last_data_flag, sizeof(int) );
+    memcpy( header+2*sizeof(int), &items_count, sizeof(int) );
 
+    /*item headers are filled directly in staging buffer*/
+    for( int i=data_start_index; i < loop_up_to_count; i++ ){
+	item = (const ElasticBufItemData*)BufferItemPointer( map, i );
+	header = ShuffleReserve( writer, SHUFFLE_ITEM_HEADER_SIZE(mif) );
+	memcpy( header, &item->key_data.size, sizeof(item->key_data.size) );
+	header += sizeof(item->key_data.size);
+	if ( mif->data.value_addr_is_data ){
+	    /*ElasticBufItemData::value::addr used as data, value::size not used*/
+	    memcpy( header, &item->value.addr, sizeof(item->value.addr) );
+	    header += sizeof(item->value.addr);
+	}
+	else{
+	    memcpy( header, &item->value.size, sizeof(item->value.size) );
+	    header += sizeof(item->value.size);
+	}
+	memcpy( header, &item->key_hash, HASH_SIZE(mif) );
+    }
+    /*keys and values are written from their memory if contiguous*/
     for( int i=data_start_index; i < loop_up_to_count; i++ ){
-	GetBufferItem( map, i, current );
-	bytes+= BufferedWriteSingleMrItem( bio, fdw, current, 
-					   HASH_SIZE(mif),
-					   mif->data.value_addr_is_data);
+	item = (const ElasticBufItemData*)BufferItemPointer( map, i );
+	ShuffleAppend( writer, (const void*)item->key_data.addr, item->key_data.size );
+	if ( !mif->data.value_addr_is_data ){
+	    ShuffleAppend( writer, (const void*)item->value.addr, item->value.size );
+	}
     }
-    bio->flush_write(bio, fdw);
-    assert(bytes ==senddatasize);
+    ShuffleFlush( writer );
 }
 
 /*struct to be used inside MapSendToAllReducers*/
@@ -640,12 +766,10 @@ MapSendToAllReducers( struct ChannelsConfigInterface *ch_if,
     WRITE_FMT_LOG("dividers_count=%d, basket_count=%d\n", dividers_count, basket_count);
     assert(dividers_count==basket_count);
 
-    /*Declare big buffer to provide efficient buffered IO, free it at the function end*/
-    void *send_buffer; 
-    send_buffer= malloc(SEND_BUFFER_SIZE);
-    IF_ALLOC_ERROR(send_buffer?0:SEND_BUFFER_SIZE);
-    BufferedIOWrite* bio = AllocBufferedIOWrite( send_buffer, SEND_BUFFER_SIZE, NULL);
-    IF_ALLOC_ERROR( bio?0:SEND_BUFFER_SIZE );
+    /*Declare big staging buffer for small pieces of data, free it at the function end*/
+    struct ShuffleWriter writer;
+    SHUFFLE_WRITER_INIT( &writer, malloc(SEND_BUFFER_SIZE), SEND_BUFFER_SIZE );
+    IF_ALLOC_ERROR(writer.staging?0:SEND_BUFFER_SIZE);
 
     for( int i=0; i < basket_count; i++ ){
 	/*send to reducer with current_divider_index index*/
@@ -656,7 +780,7 @@ MapSendToAllReducers( struct ChannelsConfigInterface *ch_if,
 	WRITE_FMT_LOG( "write to fdw=%d /reducer node=%d, %d items\n", fdw,
 		       reduce_nodes_list[i], basket_array[i].count_in_section );
 	WriteDataToReduce( mif,
-			   bio,
+			   &writer,
 			   fdw, 
 			   map, 
 			   basket_array[i].data_start_index, 
@@ -664,19 +788,11 @@ MapSendToAllReducers( struct ChannelsConfigInterface *ch_if,
 			   last_data );
     }
 
-    free(bio);
-    free(send_buffer);
+    free(writer.staging);
     free(reduce_nodes_list);
 }
 
 
-/*Depend on mif->data.dividers_list calculate inex of beginning item index and items
- *count of buffer map to be send into reducer node in further, 
- *@param resulted array with calculation info*/
-struct BasketInfo* DistributeDataIntoBaskets(struct MapReduceUserIf *mif, 
-					     const Buffer *map,
-					     int basket_count){
-
 #define LOG_ADD_TO_NEW_BASKET(mif_p, map_p, itemindex, basketindex, dataindex, countsection, \
 			      currentdivider)				\
 	{								\
@@ -688,33 +804,40 @@ struct BasketInfo* DistributeDataIntoBaskets(struct MapReduceUserIf *mif,
 			       PRINTABLE_HASH(mif_p, currentdivider),	\
 			       itemindex-1, PRINTABLE_HASH(mif, &previtem->key_hash) );	\
 	    }								\
-	    WRITE_FMT_LOG( "reducer #%d divider_hash=%s, [%d]=%s\n",	\
-			   basketindex,					\
-			   PRINTABLE_HASH(mif_p, currentdivider),	\
-			   itemindex, PRINTABLE_HASH(mif_p, &current->key_hash) ); \
+	    if ( itemindex < (map_p)->header.count ){			\
+		WRITE_FMT_LOG( "reducer #%d divider_hash=%s, [%d]=%s\n", \
+			       basketindex,				\
+			       PRINTABLE_HASH(mif_p, currentdivider),	\
+			       itemindex, PRINTABLE_HASH(mif_p, &current->key_hash) ); \
+	    }								\
 	    WRITE_FMT_LOG( "Basket #%d start_index=%d, count=%d\n",	\
 			   basketindex, dataindex, countsection );	\
 	}								\
 
+/*variant of baskets filling for hash size, items are not copied, only
+ *hashes are compared
+ *@param basket_index count of filled baskets*/
+ALWAYS_INLINE void
+FillBaskets( struct MapReduceUserIf *mif, 
+	     const Buffer *map,
+	     struct BasketInfo* basket_array,
+	     int *basket_index,
+	     int cmp_hash_size ){
     int switchbasket=0;
-    int basket_index=0;
     int data_start_index = 0;
     int count_in_section = 0;
     int current_divider_index = 0;
-    ElasticBufItemData* current = alloca( MRITEM_SIZE(mif) );
-    void*  current_divider_hash = alloca( HASH_SIZE(mif) );
-    struct BasketInfo* basket_array;
-    basket_array = malloc(sizeof(struct BasketInfo)*basket_count);
-
+    const ElasticBufItemData* current = NULL;
     /*Get first divider hash*/
-    GetBufferItem(&mif->data.dividers_list, 0, current_divider_hash);
+    const void* current_divider_hash = BufferItemPointer(&mif->data.dividers_list, 0);
 
     /*loop for data +1, no out of bounds can be because handle it*/
     for ( int j=0; j < map->header.count+1; j++ ){
 	if ( j < map->header.count ){
 	    /*get item by valid index*/
-	    GetBufferItem( map, j, current);
-	    if ( HASH_CMP(mif, &current->key_hash, current_divider_hash ) <= 0 ){
+	    current = (const ElasticBufItemData*)BufferItemPointer( map, j );
+	    if ( HASH_CMP_SIZED(mif, &current->key_hash, current_divider_hash, 
+				cmp_hash_size ) <= 0 ){
 		switchbasket=0;
 		count_in_section++;
 	    }
@@ -730,21 +853,20 @@ struct BasketInfo* DistributeDataIntoBaskets(struct MapReduceUserIf *mif,
 	/*if current item is last OR current hash more than current divider key*/
 	if ( switchbasket != 0 ){
 #ifdef DEBUG
-	    LOG_ADD_TO_NEW_BASKET(mif, map, j, basket_index, data_start_index, 
+	    LOG_ADD_TO_NEW_BASKET(mif, map, j, *basket_index, data_start_index, 
 				  count_in_section, current_divider_hash);
 #endif
 	    struct BasketInfo info;
 	    info.data_start_index = data_start_index;
 	    info.count_in_section = count_in_section;
-	    basket_array[basket_index++] = info;
+	    basket_array[(*basket_index)++] = info;
 
 	    /*switch to next divider, do increment if it's not last handling item*/
 	    current_divider_index++;
 	    if ( current_divider_index < mif->data.dividers_list.header.count ){
 		/*retrieve hash value by updated index*/
-		GetBufferItem( &mif->data.dividers_list, 
-			       current_divider_index, 
-			       current_divider_hash);
+		current_divider_hash = BufferItemPointer( &mif->data.dividers_list, 
+							  current_divider_index );
 	    }
 	    /*update data start index for new divider*/
 	    data_start_index = j;
@@ -752,6 +874,19 @@ struct BasketInfo* DistributeDataIntoBaskets(struct MapReduceUserIf *mif,
 	    count_in_section = 1;
 	}
     }
+}
+
+/*Depend on mif->data.dividers_list calculate inex of beginning item index and items
+ *count of buffer map to be send into reducer node in further, 
+ *@param resulted array with calculation info*/
+struct BasketInfo* DistributeDataIntoBaskets(struct MapReduceUserIf *mif, 
+					     const Buffer *map,
+					     int basket_count){
+    int basket_index=0;
+    struct BasketInfo* basket_array;
+    basket_array = malloc(sizeof(struct BasketInfo)*basket_count);
+
+    CALL_HASH_SIZE_SPECIALIZED( mif, FillBaskets, mif, map, basket_array, &basket_index );
 
     /*add info about empty data to the rest of baskets*/
     for(int i=basket_index; i < basket_count; i++ ){
@@ -820,27 +955,29 @@ MapNodeMain( struct MapReduceUserIf *mif,
     assert(mif->Map);
     /*Combine function can be not defined*/
     assert(mif->Reduce);
-    assert(mif->ComparatorHash);
-    assert(mif->ComparatorMrItem);
+    /*inlined hash comparison is only for default hash order*/
+    assert(mif->ComparatorHash == NULL || mif->data.cmp_hash_size == 0);
 #ifndef DISABLE_WRITE_LOG_BUFFER
     assert(mif->DebugHashAsString);
 #endif
 
+    MR_TRACE_BEGIN("map_node");
     struct MapNodeEvents events;
     InitMapInternals(mif, chif, &events);
 
     PrintDebugInfo(mif, chif);
 
-    /*should be initialized at fist call of DataProvider*/
-    char *buffer = NULL;
+    /*input buffer is allocated at first call of DataProvider*/
+    struct MapInputBuffer input;
+    memset( &input, '\0', sizeof(input) );
     size_t returned_buf_size = 0;
     /*default block size for input file*/
-    size_t split_input_size=DEFAULT_MAP_CHUNK_SIZE_BYTES;
+    input.chunk_size=DEFAULT_MAP_CHUNK_SIZE_BYTES;
 
     /*get from environment block size for input file*/
     if ( getenv(MAP_CHUNK_SIZE_ENV) )
-	split_input_size = atoi(getenv(MAP_CHUNK_SIZE_ENV));
-    WRITE_FMT_LOG( "MAP_CHUNK_SIZE_BYTES=%d\n", split_input_size );
+	input.chunk_size = atoi(getenv(MAP_CHUNK_SIZE_ENV));
+    WRITE_FMT_LOG( "MAP_CHUNK_SIZE_BYTES=%d\n", input.chunk_size );
 	
     /*by default can set any number, but actually it should be point to start of unhandled data,
      * for fully handled data it should be set to data size*/
@@ -856,17 +993,16 @@ MapNodeMain( struct MapReduceUserIf *mif,
 
     /*read input data*/
     do{
-	free(buffer), buffer=NULL;
-
 	/*last parameter is not used for first call, 
 	  for another calls it should be assigned by user returned value of Map call*/
+	MR_TRACE_BEGIN("map_input");
 	returned_buf_size = events.MapInputDataProvider(
 							channel->fd,
-							&buffer,
-							split_input_size,
+							&input,
 							current_unhandled_data_pos
 							);
-	last_chunk = returned_buf_size < split_input_size? 1 : 0; //last chunk flag
+	MR_TRACE_END("map_input");
+	last_chunk = input.eof; //last chunk flag
 	if ( last_chunk != 0 ){
 	    WRITE_LOG( "MapInputDataProvider last chunk data" );
 	}
@@ -876,48 +1012,169 @@ MapNodeMain( struct MapReduceUserIf *mif,
 
 	if ( returned_buf_size ){
 	    /*call users Map, Combine functions only for non empty data set*/
+	    MR_TRACE_BEGIN("map_local_processing");
 	    current_unhandled_data_pos = 
 		events.MapInputDataLocalProcessing( mif,
-						    buffer, 
+						    input.data, 
 						    returned_buf_size,
 						    last_chunk,
 						    &map_buffer );
+	    MR_TRACE_END("map_local_processing");
+	}
+	else{
+	    /*no more input, but reducers are waiting last data flag*/
+	    int res = AllocBuffer( &map_buffer, MRITEM_SIZE(mif), 1 );
+	    IF_ALLOC_ERROR(res);
+	    current_unhandled_data_pos = 0;
 	}
 
 	if ( !mif->data.dividers_list.header.count ){
+	    MR_TRACE_BEGIN("map_histogram");
 	    events.MapCreateHistogramSendEachToOtherCreateDividersList( chif, 
 									mif, 
 									&map_buffer );
+	    MR_TRACE_END("map_histogram");
 	}
 
 	/*based on dividers list which helps easy distribute data to reduce nodes*/
+	MR_TRACE_BEGIN("map_send");
 	events.MapSendToAllReducers( chif, 
 				     mif,
 				     last_chunk, 
 				     &map_buffer);
+	MR_TRACE_END("map_send");
 
 	for(int i=0; i < map_buffer.header.count; i++){
 	    TRY_FREE_MRITEM_DATA( (ElasticBufItemData*) 
 				  BufferItemPointer(&map_buffer, i ) );
 	}
 	FreeBufferData(&map_buffer);
+	/*keys, values allocated by Map, Combine from arena are sent already*/
+	WRITE_FMT_LOG( "map arena used %u bytes\n", (uint32_t)MapArenaUsed() );
+	MapArenaReset();
     }while( last_chunk == 0 );
+    free(input.data);
+    MapArenaFree();
 
+    MR_TRACE_END("map_node");
     WRITE_LOG("MapNodeMain Complete\n");
 
     return 0;
 }
 
+/*Source of k-way merge, current item is compared while merging*/
+struct MergeSource{
+    const char *current;
+    const char *end;
+    int         index;  /*index of source buffer*/
+};
+
+#define MERGE_SOURCE_HASH(source_p) \
+    (&((const ElasticBufItemData*)(source_p)->current)->key_hash)
+
+/*Equal hashes are ordered by source index, so items of the first source
+ *are merged first whatever merge method used*/
+ALWAYS_INLINE int
+MergeSourceLess( struct MapReduceUserIf *mif, 
+		 const struct MergeSource *s1, const struct MergeSource *s2,
+		 int cmp_hash_size ){
+    int cmp = HASH_CMP_SIZED( mif, MERGE_SOURCE_HASH(s1), MERGE_SOURCE_HASH(s2),
+			      cmp_hash_size );
+    return cmp < 0 || (cmp == 0 && s1->index < s2->index);
+}
+
+/*restore min heap property for subtree of heap item i*/
+ALWAYS_INLINE void
+MergeHeapSiftDown( struct MapReduceUserIf *mif, 
+		   struct MergeSource *heap, int count, int i, int cmp_hash_size ){
+    struct MergeSource item = heap[i];
+    int child;
+    while ( (child = 2*i+1) < count ){
+	if ( child+1 < count && 
+	     MergeSourceLess(mif, &heap[child+1], &heap[child], cmp_hash_size) )
+	    ++child;
+	if ( !MergeSourceLess(mif, &heap[child], &item, cmp_hash_size) ) break;
+	heap[i] = heap[child];
+	i = child;
+    }
+    heap[i] = item;
+}
+
+/*copy the rest of source items by single copy*/
+static void
+MergeCopyRest( Buffer *dest, const struct MergeSource *source ){
+    size_t bytes = source->end - source->current;
+    memcpy( dest->data + dest->header.count*dest->header.item_size, 
+	    source->current, bytes );
+    dest->header.count += bytes / dest->header.item_size;
+}
+
+/*merge of two sources, the most frequent case*/
+ALWAYS_INLINE void
+MergeTwoSources( struct MapReduceUserIf *mif, Buffer *dest, 
+		 struct MergeSource *s1, struct MergeSource *s2, int cmp_hash_size ){
+    size_t item_size = dest->header.item_size;
+    while ( s1->current < s1->end && s2->current < s2->end ){
+	/*item of first source goes first if hashes are equal*/
+	if ( HASH_CMP_SIZED( mif, MERGE_SOURCE_HASH(s2), MERGE_SOURCE_HASH(s1),
+			     cmp_hash_size ) < 0 ){
+	    SetBufferItem( dest, dest->header.count++, s2->current );
+	    s2->current += item_size;
+	}
+	else{
+	    SetBufferItem( dest, dest->header.count++, s1->current );
+	    s1->current += item_size;
+	}
+    }
+    MergeCopyRest( dest, s1 );
+    MergeCopyRest( dest, s2 );
+}
+
+/*merge of any sources count by binary heap, O(N*log(k)) comparisons*/
+ALWAYS_INLINE void
+MergeHeapSources( struct MapReduceUserIf *mif, Buffer *dest, 
+		  struct MergeSource *heap, int count, int cmp_hash_size ){
+    size_t item_size = dest->header.item_size;
+    int i;
+    for ( i=count/2-1; i >= 0; i-- ){
+	MergeHeapSiftDown( mif, heap, count, i, cmp_hash_size );
+    }
+    while ( count > 2 ){
+	SetBufferItem( dest, dest->header.count++, heap[0].current );
+	heap[0].current += item_size;
+	if ( heap[0].current == heap[0].end ){
+	    heap[0] = heap[--count];
+	}
+	MergeHeapSiftDown( mif, heap, count, 0, cmp_hash_size );
+    }
+    /*finish the rest by two way merge, keep sources order for equal items*/
+    if ( count == 2 ){
+	if ( heap[0].index < heap[1].index )
+	    MergeTwoSources( mif, dest, &heap[0], &heap[1], cmp_hash_size );
+	else
+	    MergeTwoSources( mif, dest, &heap[1], &heap[0], cmp_hash_size );
+    }
+    else if ( count == 1 ){
+	MergeCopyRest( dest, &heap[0] );
+    }
+}
+
+/*variant of merge for hash size*/
+ALWAYS_INLINE void
+MergeSources( struct MapReduceUserIf *mif, Buffer *dest, 
+	      struct MergeSource *sources, int count, int cmp_hash_size ){
+    if ( count == 2 )
+	MergeTwoSources( mif, dest, &sources[0], &sources[1], cmp_hash_size );
+    else
+	MergeHeapSources( mif, dest, sources, count, cmp_hash_size );
+}
+
 /*Copy into dest buffer items from source_arrays buffers in sorted order*/
 void 
 MergeBuffersToNew( struct MapReduceUserIf *mif,
 		   Buffer *dest,
 		   const Buffer *source_arrays, 
 		   int arrays_count ){
-    int SearchMinimumHashAmongCurrentItemsOfAllMergeBuffers( struct MapReduceUserIf *mif,
-							     const Buffer* merge_buffers, 
-							     int *current_indexes_array,
-							     int count);
     int all_items_count=0;
     /*List of items count of every merging item before merge*/
     int i;
@@ -930,86 +1187,55 @@ MergeBuffersToNew( struct MapReduceUserIf *mif,
     int ret = AllocBuffer( dest, MRITEM_SIZE(mif), all_items_count );
     IF_ALLOC_ERROR(ret);
 
-    int merge_pos[arrays_count];
-    memset(merge_pos, '\0', sizeof(merge_pos) );
-    int min_key_array;
-    ElasticBufItemData* current;
-
-    /*search minimal key among current items of source_arrays*/
-    min_key_array =
-	SearchMinimumHashAmongCurrentItemsOfAllMergeBuffers( mif,
-							     source_arrays, 
-							     merge_pos,
-							     arrays_count);
+    /*only non empty buffers are merged*/
+    struct MergeSource sources[arrays_count > 0 ? arrays_count : 1];
+    int sources_count=0;
+    for(i=0; i < arrays_count; i++ ){
+	if ( !source_arrays[i].header.count ) continue;
+	sources[sources_count].current = BufferItemPointer( &source_arrays[i], 0 );
+	sources[sources_count].end = 
+	    BufferItemPointer( &source_arrays[i], source_arrays[i].header.count );
+	sources[sources_count].index = i;
+	++sources_count;
+    }
+    CALL_HASH_SIZE_SPECIALIZED( mif, MergeSources, mif, dest, sources, sources_count );
+    assert( dest->header.count == all_items_count );
+
+#ifdef DEBUG
     uint32_t merge_result_bytes_occupied=0;
-    while( min_key_array !=-1 ){
-	/*copy item data with minimal key into destination buffer*/
-	current = (ElasticBufItemData*)
-	    BufferItemPointer( &source_arrays[min_key_array], merge_pos[min_key_array] );
-	AddBufferItem( dest, current );
-	merge_pos[min_key_array]++;
-	min_key_array =
-	    SearchMinimumHashAmongCurrentItemsOfAllMergeBuffers( mif,
-								 source_arrays, 
-								 merge_pos,
-								 arrays_count);
+    const ElasticBufItemData* current;
+    for(i=0; i < dest->header.count; i++ ){
+	current = (const ElasticBufItemData*)BufferItemPointer( dest, i );
 	merge_result_bytes_occupied += mif->data.mr_item_size + current->key_data.size;
 	if( !mif->data.value_addr_is_data )
 	    merge_result_bytes_occupied += current->value.size;
     }
     WRITE_FMT_LOG("Merged Items memory occupied=%u\n", merge_result_bytes_occupied);
-}
-
-int
-SearchMinimumHashAmongCurrentItemsOfAllMergeBuffers( struct MapReduceUserIf *mif,
-						     const Buffer* merge_buffers, 
-						     int *current_indexes_array,
-						     int count){ 
-    int res = -1;
-    ElasticBufItemData* item;
-    const uint8_t* current_hash;
-    const uint8_t* minimal_hash = NULL;
-    for ( int i=0; i < count; i++ ){ /*loop for merge arrays*/
-	/*check bounds of current buffer*/
-	if ( BOUNDS_OK(current_indexes_array[i],merge_buffers[i].header.count) ){
-	    /*get minimal value among currently indexed histogram values*/ 
-		item = (ElasticBufItemData*)BufferItemPointer( &merge_buffers[i],
-							       current_indexes_array[i]);
-		current_hash =  (const uint8_t*)&item->key_hash;
-	    if ( minimal_hash == NULL || HASH_CMP( mif, current_hash, minimal_hash ) <= 0 ){
-		res = i;
-		minimal_hash = current_hash;
-	    }
-	}
-    }
-    return res;
+#endif
 }
 
 
-static exclude_flag_t
+exclude_flag_t
 RecvDataFromSingleMap( struct MapReduceUserIf *mif,
 		       int fdr,
-		       Buffer *map) {
+		       Buffer *map,
+		       char **packet ){
     exclude_flag_t excl_flag=0;
     int items_count;
-    char* recv_buffer;
     int bytes;
+    *packet = NULL;
     /*read exact packet size and allocate buffer to read a whole data by single read i/o*/
-    if ( read(fdr, &bytes, sizeof(int) ) <= 0 )
-	assert(0);
+    ReadFull( fdr, &bytes, sizeof(int) );
     WRITE_FMT_LOG( "packet size=%d\n", bytes );
     if ( bytes > 0 ){
-	recv_buffer = malloc(bytes);
-	IF_ALLOC_ERROR(recv_buffer?0:bytes);
-
-	BufferedIORead* bio = AllocBufferedIORead( recv_buffer, bytes, NULL);
-	IF_ALLOC_ERROR(bio?0:bytes);
+	*packet = malloc(bytes);
+	IF_ALLOC_ERROR(*packet?0:bytes);
+	ReadFull( fdr, *packet, bytes );
 	/*read last data flag 0 | 1, if reducer receives 1 then it should
 	 * exclude sender map node from communications in further*/
-	bytes=0;
-	BUFFERED_READ_ASSERT( &bytes, bio, fdr, &excl_flag, sizeof(int) );
+	memcpy( &excl_flag, *packet, sizeof(int) );
 	/*read items count*/
-	BUFFERED_READ_ASSERT( &bytes, bio, fdr, &items_count, sizeof(int) );
+	memcpy( &items_count, *packet+sizeof(int), sizeof(int) );
 	WRITE_FMT_LOG( "readmap exclude flag=%d, items_count=%d\n", excl_flag, items_count );
 
 	/*alloc memory for all array cells expected to receive, if no items will recevied
@@ -1017,48 +1243,127 @@ RecvDataFromSingleMap( struct MapReduceUserIf *mif,
 	int res = AllocBuffer(map, MRITEM_SIZE(mif), items_count);
 	IF_ALLOC_ERROR(res);
 
-	if ( items_count > 0 ){
-	    /*read items_count items*/
-	    ElasticBufItemData* item;
-	    for( int i=0; i < items_count; i++ ){
-		/*add item manually, no excesive copy doing*/
-		AddBufferItemVirtually(map);
-		item = (ElasticBufItemData*)BufferItemPointer( map, i );
-		/*save directly into array*/
-		bytes+=BufferedReadSingleMrItem( bio, fdr, item, 
-						 HASH_SIZE(mif),
-						 mif->data.value_addr_is_data);
+	/*parse headers into items, keys and values are referring packet*/
+	const char *header = *packet + 2*sizeof(int);
+	char *payload = *packet + 2*sizeof(int) + items_count*SHUFFLE_ITEM_HEADER_SIZE(mif);
+	ElasticBufItemData* item;
+	for( int i=0; i < items_count; i++ ){
+	    /*add item manually, no excesive copy doing*/
+	    AddBufferItemVirtually(map);
+	    item = (ElasticBufItemData*)BufferItemPointer( map, i );
+	    memcpy( &item->key_data.size, header, sizeof(item->key_data.size) );
+	    header += sizeof(item->key_data.size);
+	    item->key_data.addr = (uintptr_t)payload;
+	    item->own_key = EDataNotOwned;
+	    payload += item->key_data.size;
+	    if ( mif->data.value_addr_is_data ){
+		memcpy( &item->value.addr, header, sizeof(item->value.addr) );
+		header += sizeof(item->value.addr);
+		item->value.size = 0;
 	    }
+	    else{
+		memcpy( &item->value.size, header, sizeof(item->value.size) );
+		header += sizeof(item->value.size);
+		item->value.addr = (uintptr_t)payload;
+		payload += item->value.size;
+	    }
+	    item->own_value = EDataNotOwned;
+	    memcpy( &item->key_hash, header, HASH_SIZE(mif) );
+	    header += HASH_SIZE(mif);
 	}
+	assert( payload == *packet + bytes );
 	WRITE_FMT_LOG( "readed %d bytes from Map node, fdr=%d, item count=%d\n", 
 		       bytes, fdr, map->header.count );
 	WRITE_LOG_BUFFER( mif, *map );
-	free(bio);
-	free(recv_buffer);
     }
     return excl_flag;
 }
 
-/*into newbuf_p will be added all from merge_buffers_p and from all buffer in sort order*/
-#define MERGE_PREVIOUS_AND_NEW(mif_p, merge_buffers_p, count_buffers, prevbuf, newbuf ){ \
-	/*grow array of buffers, and add previous merge result into merge array*/ \
-	merge_buffers_p = realloc( merge_buffers_p,			\
-				   (++count_buffers)*sizeof(Buffer) );	\
-	merge_buffers_p[count_buffers-1] = prevbuf;			\
-	memset( &prevbuf, '\0', sizeof(prevbuf) );			\
-	WRITE_LOG( "Data received from mappers, merge it" );		\
-	/*Alloc buffers for merge results, and merge previous and new data*/ \
-	MergeBuffersToNew(mif_p, &newbuf, merge_buffers_p, count_buffers ); \
-	WRITE_FMT_LOG( "merge complete, keys count %d, data=%p\n", newbuf.header.count, newbuf.data ); \
-	/*Merge complete, free source recv buffers*/			\
-	for ( int i=0; i < count_buffers; i++ ){			\
-	    FreeBufferData(&merge_buffers_p[i]);			\
-	}								\
-	/*reset merge buffers*/						\
-	free(merge_buffers_p), merge_buffers_p = NULL;			\
-	count_buffers=0;						\
+/*Merge sources into dest and free sources, merge result is combined if
+ *Combine defined. Single source is already combined and moved as is*/
+static void
+MergeAndCombine( struct MapReduceUserIf *mif, 
+		 Buffer *dest, 
+		 Buffer *sources, 
+		 int count ){
+    Buffer merged;
+    if ( count == 1 ){
+	*dest = sources[0];
+	memset( &sources[0], '\0', sizeof(Buffer) );
+	return;
+    }
+    MergeBuffersToNew( mif, &merged, sources, count );
+    WRITE_FMT_LOG( "merge complete, keys count %d, data=%p\n", merged.header.count, merged.data );
+    /*Merge complete, free source buffers*/
+    for ( int i=0; i < count; i++ ){
+	FreeBufferData(&sources[i]);
+    }
+    if ( !mif->Combine ){
+	*dest = merged;
+	return;
     }
+    int granularity = merged.header.count>3? merged.header.count/3 : 1000;
+    int ret = AllocBuffer( dest, MRITEM_SIZE(mif), granularity );
+    IF_ALLOC_ERROR(ret);
+    WRITE_LOG_BUFFER(mif,merged);
+    WRITE_FMT_LOG( "keys count before Combine: %d\n", (int)merged.header.count );
+    mif->Combine( &merged, dest );
+    FreeBufferData( &merged );
+    WRITE_FMT_LOG( "keys count after Combine: %d\n", (int)dest->header.count );
+}
+
+void
+AddReduceRun( struct MapReduceUserIf *mif, 
+	      struct ReduceRuns *runs,
+	      Buffer *run ){
+    Buffer merged;
+    if ( !run->header.count ){
+	FreeBufferData(run);
+	return;
+    }
+    runs->runs = realloc( runs->runs, (runs->count+1)*sizeof(Buffer) );
+    IF_ALLOC_ERROR(runs->runs?0:(runs->count+1)*sizeof(Buffer));
+    runs->runs[runs->count++] = *run;
+    memset( run, '\0', sizeof(Buffer) );
+    /*merge last run with previous one while previous is not bigger, so
+     *sizes of runs are decreasing from first to last like bits of binary
+     *counter and every item is merged O(log rounds) times*/
+    while ( runs->count > 1 
+	    && runs->runs[runs->count-2].header.count <= runs->runs[runs->count-1].header.count ){
+	WRITE_FMT_LOG( "merge runs #%d, #%d\n", runs->count-2, runs->count-1 );
+	MergeAndCombine( mif, &merged, &runs->runs[runs->count-2], 2 );
+	runs->runs[runs->count-2] = merged;
+	--runs->count;
+    }
+}
+
+void
+MergeReduceRuns( struct MapReduceUserIf *mif, 
+		 struct ReduceRuns *runs,
+		 Buffer *dest ){
+    WRITE_FMT_LOG( "final merge of %d runs\n", runs->count );
+    MergeAndCombine( mif, dest, runs->runs, runs->count );
+    free(runs->runs);
+    runs->runs = NULL;
+    runs->count = 0;
+}
 
+/*memory occupied by received packet, approximately*/
+static size_t
+ReceivedDataSize( struct MapReduceUserIf *mif, const Buffer *received ){
+    return received->header.count*SHUFFLE_ITEM_HEADER_SIZE(mif)
+	+ CalculatePayloadSize( received, 0, received->header.count, 
+				mif->data.value_addr_is_data );
+}
+
+static size_t
+BuffersItemsSize( struct MapReduceUserIf *mif, const Buffer *buffers, int count ){
+    size_t size=0;
+    for ( int i=0; i < count; i++ ){
+	size += buffers[i].header.count*MRITEM_SIZE(mif);
+    }
+    return size;
+}
 
 int 
 ReduceNodeMain( struct MapReduceUserIf *mif, 
@@ -1068,8 +1373,8 @@ ReduceNodeMain( struct MapReduceUserIf *mif,
     assert(mif->Map);
     /*Combine function can be not defined*/
     assert(mif->Reduce);
-    assert(mif->ComparatorHash);
-    assert(mif->ComparatorMrItem);
+    /*inlined hash comparison is only for default hash order*/
+    assert(mif->ComparatorHash == NULL || mif->data.cmp_hash_size == 0);
 #ifndef DISABLE_WRITE_LOG_BUFFER
     assert(mif->DebugHashAsString);
 #endif
@@ -1078,6 +1383,7 @@ ReduceNodeMain( struct MapReduceUserIf *mif,
     PrintDebugInfo(mif, chif);
 #endif
 
+    MR_TRACE_BEGIN("reduce_node");
     /*get map_nodes_count*/
     int *map_nodes_list = NULL;
     int map_nodes_count = chif->GetNodesListByType( chif, EMapNode, &map_nodes_list);
@@ -1086,10 +1392,24 @@ ReduceNodeMain( struct MapReduceUserIf *mif,
      *it will grow runtime */
     Buffer *merge_buffers = NULL;
     int merge_buffers_count=0;
-    /*Buffer for merge*/
-    Buffer merged;
+    /*Combined data of previous rounds, merged lazily*/
+    struct ReduceRuns runs = {NULL, 0};
+    /*Buffer for combined data of current round*/
+    Buffer run;
     /*Buffer for sorted*/
-    Buffer all; memset( &all, '\0', sizeof(all) );
+    Buffer all;
+    /*received packets, items are referring keys and values in it until
+     *Reduce done*/
+    char **packets = NULL;
+    int packets_count=0;
+    size_t packets_size=0;
+    /*if memory budget is set then data exceeding it is spilled into
+     *scratch file, it should be a random access channel to save memory*/
+    size_t memory_budget=0;
+    struct ReduceSpill spill = {NULL, -1, NULL, 0};
+    if ( getenv(REDUCE_MEMORY_BUDGET_ENV) )
+	memory_budget = strtoul(getenv(REDUCE_MEMORY_BUDGET_ENV), NULL, 10);
+    WRITE_FMT_LOG( "REDUCE_MEMORY_BUDGET=%u\n", (uint32_t)memory_budget );
 
     int excluded_map_nodes[map_nodes_count];
     memset( excluded_map_nodes, '\0', sizeof(excluded_map_nodes) );
@@ -1098,6 +1418,7 @@ ReduceNodeMain( struct MapReduceUserIf *mif,
     int leave_map_nodes; /*is used as condition for do while loop*/
     do{
 	leave_map_nodes = 0;
+	MR_TRACE_BEGIN("reduce_recv");
 	for( int i=0; i < map_nodes_count; i++ ){
 	    /*If expecting data from current map node*/
 	    if ( excluded_map_nodes[i] != MAP_NODE_EXCLUDE ){
@@ -1110,10 +1431,13 @@ ReduceNodeMain( struct MapReduceUserIf *mif,
 		/*grow array of buffers, and always receive items into new buffer*/
 		merge_buffers = realloc( merge_buffers, 
 					 (++merge_buffers_count)*sizeof(Buffer) );
+		packets = realloc( packets, (++packets_count)*sizeof(char*) );
 		excluded_map_nodes[i] 
 		    = RecvDataFromSingleMap( mif, 
 					     channel->fd, 
-					     &merge_buffers[merge_buffers_count-1] );
+					     &merge_buffers[merge_buffers_count-1],
+					     &packets[packets_count-1] );
+		packets_size += ReceivedDataSize( mif, &merge_buffers[merge_buffers_count-1] );
 		
 		/*set next wait loop condition*/
 		if ( excluded_map_nodes[i] != MAP_NODE_EXCLUDE ){
@@ -1122,45 +1446,93 @@ ReduceNodeMain( struct MapReduceUserIf *mif,
 		}
 	    }
 	}//for
+	MR_TRACE_END("reduce_recv");
 
 	/**********************************************************/
-	/*combine data every time while it receives from map nodes*/
+	/*combine data every time while it receives from map nodes,
+	 *combined data of round is kept as a run and merged with
+	 *previous runs only if they have similar size*/
 	if ( mif->Combine ){
-	    MERGE_PREVIOUS_AND_NEW(mif, merge_buffers, merge_buffers_count, all, merged );
-
-	    int granularity = all.header.count>0? all.header.count/3 : 1000;
-	    int ret = AllocBuffer( &all, MRITEM_SIZE(mif), granularity );
-	    IF_ALLOC_ERROR(ret);
-
-	    WRITE_LOG_BUFFER(mif,merged);
-	    WRITE_FMT_LOG( "keys count before Combine: %d\n", 
-			   (int)merged.header.count );
-	    mif->Combine( &merged, &all );
-	    FreeBufferData( &merged );
-	    WRITE_FMT_LOG( "keys count after Combine: %d\n", (int)all.header.count );
-	    WRITE_LOG_BUFFER(mif,all);
+	    MR_TRACE_BEGIN("reduce_merge_combine");
+	    WRITE_LOG( "Data received from mappers, merge it" );
+	    MergeAndCombine( mif, &run, merge_buffers, merge_buffers_count );
+	    free(merge_buffers), merge_buffers = NULL;
+	    merge_buffers_count=0;
+	    AddReduceRun( mif, &runs, &run );
+	    WRITE_FMT_LOG( "runs count %d\n", runs.count );
+	    MR_TRACE_END("reduce_merge_combine");
 	}else{
 	    WRITE_LOG( "Combine function not defined and skipped" );
 	}
+
+	/*memory budget exceeded, write all data as single sorted run into
+	 *scratch file; then no items are referring received packets*/
+	if ( memory_budget && packets_size 
+	     + BuffersItemsSize( mif, runs.runs, runs.count ) 
+	     + BuffersItemsSize( mif, merge_buffers, merge_buffers_count ) > memory_budget ){
+	    MR_TRACE_BEGIN("reduce_spill");
+	    if ( spill.fd == -1 ){
+		const char *path = getenv(REDUCE_SPILL_FILE_ENV);
+		ReduceSpillOpen( &spill, path ? path : DEFAULT_REDUCE_SPILL_FILE );
+	    }
+	    if ( mif->Combine ){
+		MergeReduceRuns( mif, &runs, &run );
+	    }
+	    else{
+		MergeAndCombine( mif, &run, merge_buffers, merge_buffers_count );
+		free(merge_buffers), merge_buffers = NULL;
+		merge_buffers_count=0;
+	    }
+	    ReduceSpillWrite( mif, &spill, &run );
+	    for ( int i=0; i < packets_count; i++ ){
+		free(packets[i]);
+	    }
+	    free(packets), packets = NULL;
+	    packets_count=0;
+	    packets_size=0;
+	    MR_TRACE_END("reduce_spill");
+	}
 	WRITE_FMT_LOG("sbrk()=%p\n", (void*)sbrk(0) );
     }while( leave_map_nodes != 0 );
 
-    /*do merge only once if Combine not defined*/
-    if ( !mif->Combine ){
-	MERGE_PREVIOUS_AND_NEW(mif, merge_buffers, merge_buffers_count, all, merged );
-	/*assign data from 'merged' buffer into 'all' buffer*/
-	FreeBufferData(&all);
-	all = merged;
+    /*do merge only once: k-way merge of combined runs, or of all
+     *received buffers if Combine not defined*/
+    MR_TRACE_BEGIN("reduce_merge");
+    if ( mif->Combine ){
+	MergeReduceRuns( mif, &runs, &all );
     }
-
-    if( mif->Reduce ){
+    else{
+	MergeAndCombine( mif, &all, merge_buffers, merge_buffers_count );
+	free(merge_buffers);
+    }
+    WRITE_LOG_BUFFER(mif,all);
+    MR_TRACE_END("reduce_merge");
+
+    if ( spill.count ){
+	/*merge spilled runs and data in memory streaming into Reduce*/
+	WRITE_FMT_LOG( "Reduce : %d spilled runs, %d items in memory\n", 
+		       spill.count, (int)all.header.count );
+	MR_TRACE_BEGIN("reduce");
+	ReduceSpillMerge( mif, &spill, &all );
+	MR_TRACE_END("reduce");
+    }
+    else if( mif->Reduce ){
 	/*user should output data into output file/s*/
 	WRITE_FMT_LOG( "Reduce : %d items, data=%p\n", (int)all.header.count, all.data );
+	MR_TRACE_BEGIN("reduce");
 	mif->Reduce( &all );
+	MR_TRACE_END("reduce");
     }
 
     free(map_nodes_list);
     FreeBufferData(&all);
+    for ( int i=0; i < packets_count; i++ ){
+	free(packets[i]);
+    }
+    free(packets);
+    /*data allocated by Combine from arena*/
+    MapArenaFree();
+    MR_TRACE_END("reduce_node");
 
     WRITE_LOG("ReduceNodeMain Complete\n");
     return 0;
@@ -20,7 +20,11 @@
 #ifndef __MAP_REDUCE_LIB_H__
 #define __MAP_REDUCE_LIB_H__
 
+#include <sys/uio.h> //struct iovec
+
 #include "map_reduce_datatypes.h"
+#include "radix_sort.h"
+#include "key_hash.h"
 
 //forward decl
 struct ChannelsConfigInterface;
@@ -32,9 +36,20 @@ enum { EMapNode=1, EReduceNode=2, EInputOutputNode=3 };
 #define SEND_BUFFER_SIZE             0x200000 //2MB
 #define DEFAULT_MAP_CHUNK_SIZE_BYTES 0x100000 //1MB
 #define MAP_CHUNK_SIZE_ENV           "MAP_CHUNK_SIZE"
+/*max iovecs written by single writev while sending to reducer*/
+#define SHUFFLE_IOV_MAX              64
+/*contiguous data of this size and bigger is written directly from its
+ *memory, smaller is copied into staging buffer*/
+#define SHUFFLE_DIRECT_WRITE_MIN     0x1000 //4KB
 
 /*Init MapReduceUserIf existing pointer object and get it ready to use
-  comparator_f - if user provides NULL then default comparator will used */
+  comparator_f - if user provides NULL then default comparator will used,
+  see HashCompareDefault; if mritemcomparator_f is NULL then items are
+  ordered by hash, and if hashcomparator_f is NULL too they are sorted
+  by radix sort without comparator calls. For default comparator
+  and 4, 8, 16, 20 bytes hash library loops use inlined comparison, so
+  ComparatorHash should be set only by this macro. If hashstr_f is NULL
+  then hashes are printed by HashAsStringDefault*/
 #define PREPARE_MAPREDUCE(mif_p, map_f, combine_f, reduce_f, mritemcomparator_f, \
 			  hashcomparator_f,  hashstr_f,			\
 			  val_addr_is_data, item_size, h_size ){	\
@@ -45,9 +60,16 @@ enum { EMapNode=1, EReduceNode=2, EInputOutputNode=3 };
 	(mif_p)->ComparatorHash = (hashcomparator_f);			\
 	/*set user function convert hash to a string */			\
 	(mif_p)->DebugHashAsString = (hashstr_f);			\
+	if ( (mif_p)->DebugHashAsString == NULL )			\
+	    (mif_p)->DebugHashAsString = HashAsStringDefault;		\
 	(mif_p)->data.value_addr_is_data = (val_addr_is_data);		\
 	(mif_p)->data.mr_item_size = item_size;				\
 	(mif_p)->data.hash_size = (h_size);				\
+	(mif_p)->Fold = NULL; /*hash aggregation is off by default*/	\
+	/*select inlined comparison for default order of common sizes*/ \
+	(mif_p)->data.cmp_hash_size =					\
+	    (mif_p)->ComparatorHash == NULL && HASH_SIZE_SPECIALIZED(h_size) ? \
+	    (h_size) : 0;						\
     }
 
 
@@ -65,14 +87,23 @@ struct MapReduceUserIf{
     /* Waiting sorted map_buffer.
      * reduce and put reduced into reduce_buffer*/
     int (*Combine)( const Buffer *map_buffer, Buffer *reduce_buffer );
+    /* optional, can be set after PREPARE_MAPREDUCE: fold item into
+     * accumulated item having the same hash, for example sum values.
+     * If defined then map items are aggregated by hash table instead of
+     * sorting all of them and Combine, it's faster when keys are mostly
+     * repeated. Combine is still needed if too many distinct hashes in
+     * chunk, see MAP_FOLD_TABLE_ITEMS_ENV. Data owned by folded item
+     * should be freed by Fold as Combine does*/
+    int (*Fold)( ElasticBufItemData *accumulated, const ElasticBufItemData *item );
     /*reduce and output data into stdout*/
     int (*Reduce)( const Buffer *reduce_buffer );
-    /*comparator for elastic_mr_item can be overrided by user*/
+    /*comparator for elastic_mr_item can be overrided by user, 
+     *NULL means items are ordered by key_hash using ComparatorHash*/
     int (*ComparatorMrItem)(const void *p1, const void *p2);
-    /*comparator for hash can be overrided by user*/
+    /*comparator for hash can be overrided by user, NULL means default order*/
     int (*ComparatorHash)(const void *p1, const void *p2);
     /*function converts hash to a string can be overrided by user, otherwise library 
-      will use own. It's function used by library for test purposes*/
+      will use own HashAsStringDefault. It's function used by library for test purposes*/
     char* (*DebugHashAsString)( char* str, const uint8_t* hash, int size);
     /*data*/
     struct MapReduceData data;
@@ -89,6 +120,17 @@ int ReduceNodeMain(struct MapReduceUserIf *userif,
 /*Functions internal to implementation, 
   moved into this header to be tested in separate main*/
 
+/*Read next chunk of input into input buffer, data not handled by previous
+ *Map call is moved to the buffer begin and buffer grows if such data is
+ *too big for reading next chunk. input->eof is set at the end of input.
+ *@param unhandled_data_pos position of data not handled by previous Map
+ *call, it's ignored for first call
+ *@return data size in input buffer*/
+size_t 
+MapInputDataProvider( int fd, 
+		      struct MapInputBuffer *input, 
+		      size_t unhandled_data_pos );
+
 /*Read MR items from map buffer and pass every "step" item into histogram->buffer array
  *histogram created histogram
  *@return count of added items into histogram*/
@@ -110,7 +152,9 @@ GetReducersDividerArrayBasedOnSummarizedHistograms( struct MapReduceUserIf *mif,
 						    int histograms_count, 
 						    Buffer *divider_array );
 
-/*Sort Buffer array using mritem comparator provided by mif*/
+/*Sort Buffer array using mritem comparator provided by mif. If it's not
+ *provided then items are sorted by hash: by radix sort for default hash
+ *order, or by qsort using user ComparatorHash*/
 void 
 LocalSort( struct MapReduceUserIf *mif, Buffer *sortable );
 
@@ -131,6 +175,76 @@ MergeBuffersToNew( struct MapReduceUserIf *mif,
 		   const Buffer *source_arrays, 
 		   int arrays_count );
 
+/*Gathers data sent by map node into reducer for vectored writes*/
+struct ShuffleWriter{
+    int          fd;
+    char        *staging;      /*buffer for small pieces of data*/
+    size_t       staging_size;
+    size_t       staging_used;
+    const char  *pending;      /*last appended data, is grown by adjacent data*/
+    size_t       pending_size;
+    struct iovec iov[SHUFFLE_IOV_MAX];
+    int          iovcnt;
+};
+
+#define SHUFFLE_WRITER_INIT(writer_p, staging_p, size ){	\
+	(writer_p)->fd = -1;					\
+	(writer_p)->staging = (char*)(staging_p);		\
+	(writer_p)->staging_size = (size);			\
+	(writer_p)->staging_used = 0;				\
+	(writer_p)->pending = NULL;				\
+	(writer_p)->pending_size = 0;				\
+	(writer_p)->iovcnt = 0;					\
+    }
+
+/*Send items range of map buffer into reducer. Packet is: size of rest
+ *of packet, last data flag, items count, item headers and then keys and
+ *values data packed in items order. Headers are filled in staging
+ *buffer and contiguous keys, values are written directly from memory
+ *by a few writev.*/
+void 
+WriteDataToReduce( struct MapReduceUserIf *mif,
+		   struct ShuffleWriter *writer, 
+		   int fdw, 
+		   const Buffer *map, 
+		   int data_start_index, 
+		   int items_count,
+		   int last_data_flag );
+
+/*Receive packet written by WriteDataToReduce by single read, keys and
+ *values of items are pointing into packet without copying and aren't
+ *owned by items.
+ *@param packet received data, it should be freed when items are not
+ *used anymore
+ *@return last data flag*/
+int
+RecvDataFromSingleMap( struct MapReduceUserIf *mif,
+		       int fdr,
+		       Buffer *map,
+		       char **packet );
+
+/*Sorted runs received by reducer. Runs of similar size are merged as
+ *soon as added, so there are O(log rounds) runs and every item is
+ *copied O(log rounds) times instead of merging all data every round*/
+struct ReduceRuns{
+    Buffer *runs;
+    int     count;
+};
+
+/*Add sorted run, it's moved into runs and merged with previous runs which
+ *are not bigger, merged data is combined if Combine defined*/
+void
+AddReduceRun( struct MapReduceUserIf *mif, 
+	      struct ReduceRuns *runs,
+	      Buffer *run );
+
+/*Merge all runs into dest by single k-way merge and combine it, runs are
+ *freed*/
+void
+MergeReduceRuns( struct MapReduceUserIf *mif, 
+		 struct ReduceRuns *runs,
+		 Buffer *dest );
+
 #endif //__MAP_REDUCE_LIB_H__
 
 
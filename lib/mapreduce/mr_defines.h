@@ -64,8 +64,32 @@ typedef int exclude_flag_t;
 				(mif_p)->data.hash_size)		\
     :""
 
-#define HASH_COPY(dest, src, size) memcpy((dest), (src), (size))
-#define HASH_CMP(mif_p, h1_p, h2_p) (mif_p)->ComparatorHash( (h1_p), (h2_p) )
+#define HASH_COPY(dest, src, size) HashCopySized((dest), (src), (size))
+#define HASH_CMP(mif_p, h1_p, h2_p)					\
+    ( (mif_p)->ComparatorHash != NULL ?					\
+      (mif_p)->ComparatorHash( (h1_p), (h2_p) ) :			\
+      HashCompareDefault( (h1_p), (h2_p), HASH_SIZE(mif_p) ) )
+
+/*Hash comparison in loop specialized by hash size, cmp_hash_size is a
+ *constant in every variant of loop and 0 means generic HASH_CMP*/
+#define HASH_CMP_SIZED(mif_p, h1_p, h2_p, cmp_hash_size)		\
+    ( (cmp_hash_size) ?							\
+      HashCompareSized( (h1_p), (h2_p), (cmp_hash_size) ) :		\
+      HASH_CMP( (mif_p), (h1_p), (h2_p) ) )
+
+/*function variants specialized by hash size must be inlined into switch*/
+#define ALWAYS_INLINE static inline __attribute__((always_inline))
+
+/*Call variant of inline function specialized for hash size selected by
+ *PREPARE_MAPREDUCE, function gets cmp_hash_size as last argument*/
+#define CALL_HASH_SIZE_SPECIALIZED(mif_p, func, ...)			\
+    switch ( (mif_p)->data.cmp_hash_size ){				\
+    case 4:  func( __VA_ARGS__, 4 ); break;				\
+    case 8:  func( __VA_ARGS__, 8 ); break;				\
+    case 16: func( __VA_ARGS__, 16 ); break;				\
+    case 20: func( __VA_ARGS__, 20 ); break;				\
+    default: func( __VA_ARGS__, 0 ); break;				\
+    }
 
 /*Buffer item size used by mapreduce library*/
 #define MRITEM_SIZE(mif_p) ((mif_p)->data.mr_item_size)
@@ -0,0 +1,217 @@
+/*
+ * Radix sort of map-reduce items by key hash
+ *
+ * Copyright (c) 2013, LiteStack, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h> //malloc
+#include <string.h> //memcpy
+#include <stddef.h> //offsetof
+#include <assert.h>
+#include <alloca.h>
+
+#include "elastic_mr_item.h"
+#include "mr_defines.h"
+#include "radix_sort.h"
+
+/*hashes fit into 64bit key are sorted LSD by keys copied into
+ *separate array, longer hashes are sorted MSD by indexes*/
+#define RADIX_MAX_LSD_HASH_SIZE  8
+/*buckets smaller than it are sorted by insertion*/
+#define RADIX_INSERTION_THRESHOLD 32
+
+#define ITEM_HASH(buf_p, index)						\
+    ((const uint8_t*)BufferItemPointer((buf_p), (index))		\
+     + offsetof(ElasticBufItemData, key_hash))
+
+struct RadixKey{
+    uint64_t key;
+    uint32_t index;
+};
+
+/*Move items to their sorted positions following permutation cycles,
+ *so only one temporary item is needed
+ *@param order order[i] is index of item should be placed at i, it's
+ *destroyed*/
+static void
+PermuteItems( Buffer *buf, uint32_t *order ){
+    size_t item_size = buf->header.item_size;
+    char *temp = alloca(item_size);
+    uint32_t i, j, next;
+    for ( i=0; i < buf->header.count; i++ ){
+	if ( order[i] == i ) continue;
+	memcpy( temp, BufferItemPointer(buf, i), item_size );
+	j = i;
+	while ( order[j] != i ){
+	    next = order[j];
+	    memcpy( (char*)BufferItemPointer(buf, j), BufferItemPointer(buf, next), item_size );
+	    order[j] = j;
+	    j = next;
+	}
+	memcpy( (char*)BufferItemPointer(buf, j), temp, item_size );
+	order[j] = j;
+    }
+}
+
+static int
+LsdSort( Buffer *buf, int hash_size ){
+    size_t count = buf->header.count;
+    struct RadixKey *src, *dst, *swap;
+    uint32_t (*histograms)[256];
+    uint32_t *order;
+    size_t i, sum, next;
+    const uint8_t *hash;
+    int byte, b;
+
+    src = malloc( 2*count*sizeof(struct RadixKey) );
+    if ( src == NULL ) return 2*count*sizeof(struct RadixKey);
+    dst = src+count;
+    histograms = alloca( hash_size*sizeof(*histograms) );
+    memset( histograms, '\0', hash_size*sizeof(*histograms) );
+
+    /*copy keys and count bytes for all passes at once*/
+    for ( i=0; i < count; i++ ){
+	hash = ITEM_HASH(buf, i);
+	src[i].index = i;
+	if ( HASH_SIZE_SPECIALIZED(hash_size) && hash_size == 8 )
+	    src[i].key = HashWord64( hash, 0 );
+	else if ( HASH_SIZE_SPECIALIZED(hash_size) && hash_size == 4 )
+	    src[i].key = HashWord32( hash, 0 );
+	else{
+	    src[i].key = 0;
+	    for ( b=0; b < hash_size; b++ ){
+		src[i].key |= (uint64_t)hash[b] << (8*b);
+	    }
+	}
+	for ( b=0; b < hash_size; b++ ){
+	    ++histograms[b][hash[b]];
+	}
+    }
+
+    for ( byte=0; byte < hash_size; byte++ ){
+	uint32_t *counts = histograms[byte];
+	/*pass changes nothing if all keys have the same byte*/
+	if ( counts[(src[0].key >> (8*byte)) & 0xff] == count ) continue;
+	for ( b=0, sum=0; b < 256; b++ ){
+	    next = sum + counts[b];
+	    counts[b] = sum;
+	    sum = next;
+	}
+	for ( i=0; i < count; i++ ){
+	    dst[ counts[(src[i].key >> (8*byte)) & 0xff]++ ] = src[i];
+	}
+	swap = src, src = dst, dst = swap;
+    }
+
+    /*unused half of keys array is enough for order*/
+    order = (uint32_t*)dst;
+    for ( i=0; i < count; i++ ){
+	order[i] = src[i].index;
+    }
+    PermuteItems( buf, order );
+    free( src < dst ? src : dst );
+    return 0;
+}
+
+ALWAYS_INLINE void
+InsertionSortSized( const Buffer *buf, uint32_t *indexes, size_t count, int hash_size ){
+    size_t i, j;
+    uint32_t current;
+    for ( i=1; i < count; i++ ){
+	current = indexes[i];
+	for ( j=i; j > 0 && HashCompareSized( ITEM_HASH(buf, indexes[j-1]),
+					      ITEM_HASH(buf, current),
+					      hash_size ) > 0; j-- ){
+	    indexes[j] = indexes[j-1];
+	}
+	indexes[j] = current;
+    }
+}
+
+/*only hashes longer than RADIX_MAX_LSD_HASH_SIZE are sorted by insertion*/
+static void
+InsertionSort( const Buffer *buf, uint32_t *indexes, size_t count, int hash_size ){
+    switch ( hash_size ){
+    case 16: InsertionSortSized( buf, indexes, count, 16 ); break;
+    case 20: InsertionSortSized( buf, indexes, count, 20 ); break;
+    default: InsertionSortSized( buf, indexes, count, hash_size ); break;
+    }
+}
+
+/*sort indexes by hash bytes starting from most significant byte*/
+static void
+MsdSort( const Buffer *buf, uint32_t *indexes, uint32_t *temp, size_t count,
+	 int byte, int hash_size ){
+    uint32_t counts[256];
+    uint32_t starts[256];
+    size_t i, sum;
+    int b;
+
+    while ( byte >= 0 ){
+	if ( count < RADIX_INSERTION_THRESHOLD ){
+	    InsertionSort( buf, indexes, count, hash_size );
+	    return;
+	}
+	memset( counts, '\0', sizeof(counts) );
+	for ( i=0; i < count; i++ ){
+	    ++counts[ ITEM_HASH(buf, indexes[i])[byte] ];
+	}
+	/*all items are in single bucket, go to next byte without scatter*/
+	if ( counts[ ITEM_HASH(buf, indexes[0])[byte] ] == count ){
+	    --byte;
+	    continue;
+	}
+	for ( b=0, sum=0; b < 256; b++ ){
+	    starts[b] = sum;
+	    sum += counts[b];
+	}
+	for ( i=0; i < count; i++ ){
+	    temp[ starts[ ITEM_HASH(buf, indexes[i])[byte] ]++ ] = indexes[i];
+	}
+	memcpy( indexes, temp, count*sizeof(*indexes) );
+	if ( byte == 0 ) return;
+	for ( b=0, sum=0; b < 256; b++ ){
+	    if ( counts[b] > 1 )
+		MsdSort( buf, indexes+sum, temp+sum, counts[b], byte-1, hash_size );
+	    sum += counts[b];
+	}
+	return;
+    }
+}
+
+static int
+MsdSortIndexes( Buffer *buf, int hash_size ){
+    size_t count = buf->header.count;
+    size_t i;
+    uint32_t *indexes = malloc( 2*count*sizeof(uint32_t) );
+    if ( indexes == NULL ) return 2*count*sizeof(uint32_t);
+    for ( i=0; i < count; i++ ){
+	indexes[i] = i;
+    }
+    MsdSort( buf, indexes, indexes+count, count, hash_size-1, hash_size );
+    PermuteItems( buf, indexes );
+    free( indexes );
+    return 0;
+}
+
+int
+RadixSortByHash( Buffer *sortable, int hash_size ){
+    assert( hash_size > 0 );
+    if ( sortable->header.count < 2 ) return 0;
+    if ( hash_size <= RADIX_MAX_LSD_HASH_SIZE )
+	return LsdSort( sortable, hash_size );
+    else
+	return MsdSortIndexes( sortable, hash_size );
+}
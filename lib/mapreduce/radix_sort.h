@@ -0,0 +1,115 @@
+/*
+ * Radix sort of map-reduce items by key hash
+ *
+ * Copyright (c) 2013, LiteStack, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef __RADIX_SORT_H__
+#define __RADIX_SORT_H__
+
+#include <stdint.h>
+#include <string.h> //memcpy
+
+#include "buffer.h"
+
+/*Default order of hashes, used if user comparators are not provided:
+ *hash is unsigned little endian integer of hash_size bytes, it's the
+ *same order as native comparison of uint16_t, uint32_t, uint64_t hashes
+ *gives on x86*/
+static inline int
+HashCompareDefault( const void *h1, const void *h2, int hash_size ){
+    const uint8_t *b1 = (const uint8_t *)h1;
+    const uint8_t *b2 = (const uint8_t *)h2;
+    int i;
+    for ( i=hash_size-1; i >= 0; i-- ){
+	if ( b1[i] != b2[i] ) return b1[i] < b2[i] ? -1 : 1;
+    }
+    return 0;
+}
+
+/*Hash sizes having built-in comparators loading hash by words, hash can
+ *be unaligned. Words comparison gives default order on little endian
+ *only*/
+#if defined(__x86_64__) || defined(__i386__)
+#  define HASH_SIZE_SPECIALIZED(hash_size)				\
+    ((hash_size)==4 || (hash_size)==8 || (hash_size)==16 || (hash_size)==20)
+#else
+#  define HASH_SIZE_SPECIALIZED(hash_size) 0
+#endif
+
+static inline uint32_t
+HashWord32( const void *hash, int offset ){
+    uint32_t word;
+    memcpy( &word, (const uint8_t*)hash+offset, sizeof(word) );
+    return word;
+}
+
+static inline uint64_t
+HashWord64( const void *hash, int offset ){
+    uint64_t word;
+    memcpy( &word, (const uint8_t*)hash+offset, sizeof(word) );
+    return word;
+}
+
+#define HASH_WORDS_CMP(w1, w2) \
+    if ( (w1) != (w2) ) return (w1) < (w2) ? -1 : 1;
+
+/*The same order as HashCompareDefault gives. Variant for hash size known
+ *at compile time: switch is resolved by compiler and comparison is
+ *inlined into caller loop, otherwise it's a byte loop*/
+static inline int
+HashCompareSized( const void *h1, const void *h2, int hash_size ){
+    if ( !HASH_SIZE_SPECIALIZED(hash_size) )
+	return HashCompareDefault( h1, h2, hash_size );
+    switch ( hash_size ){
+    case 4:
+	HASH_WORDS_CMP( HashWord32(h1, 0), HashWord32(h2, 0) );
+	return 0;
+    case 8:
+	HASH_WORDS_CMP( HashWord64(h1, 0), HashWord64(h2, 0) );
+	return 0;
+    case 16:
+	HASH_WORDS_CMP( HashWord64(h1, 8), HashWord64(h2, 8) );
+	HASH_WORDS_CMP( HashWord64(h1, 0), HashWord64(h2, 0) );
+	return 0;
+    default: /*20*/
+	HASH_WORDS_CMP( HashWord64(h1, 12), HashWord64(h2, 12) );
+	HASH_WORDS_CMP( HashWord64(h1, 4), HashWord64(h2, 4) );
+	HASH_WORDS_CMP( HashWord32(h1, 0), HashWord32(h2, 0) );
+	return 0;
+    }
+}
+
+/*Copy hash, size is known at compile time in specialized loops*/
+static inline void
+HashCopySized( void *dest, const void *src, int hash_size ){
+    switch ( hash_size ){
+    case 4:  memcpy( dest, src, 4 ); break;
+    case 8:  memcpy( dest, src, 8 ); break;
+    case 16: memcpy( dest, src, 16 ); break;
+    case 20: memcpy( dest, src, 20 ); break;
+    default: memcpy( dest, src, hash_size ); break;
+    }
+}
+
+/*Sort ElasticBufItemData items in default hash order, items with equal
+ *hashes are keeping their order. Only indexes are moved while sorting,
+ *items are moved once at the end.
+ *@return 0 if ok, otherwise on error unallocated data size*/
+int
+RadixSortByHash( Buffer *sortable, int hash_size );
+
+#endif //__RADIX_SORT_H__
@@ -0,0 +1,207 @@
+/*
+ * Spilling of reducer data into scratch file when memory budget exceeded
+ *
+ * Copyright (c) 2013, LiteStack, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h> //malloc
+#include <stdio.h>
+#include <string.h> //memset
+#include <unistd.h> //lseek
+#include <fcntl.h>  //open
+#include <sys/stat.h>
+#include <assert.h>
+
+#include "map_reduce_lib.h"
+#include "mr_defines.h"
+#include "elastic_mr_item.h"
+#include "reduce_spill.h"
+
+void
+ReduceSpillOpen( struct ReduceSpill *spill, const char *path ){
+    spill->path = path;
+    spill->fd = open( path, O_CREAT|O_RDWR|O_TRUNC, S_IRUSR|S_IWUSR );
+    assert( spill->fd >= 0 );
+    spill->runs = NULL;
+    spill->count = 0;
+    WRITE_FMT_LOG( "spill file %s, fd=%d\n", path, spill->fd );
+}
+
+/*free items including owned keys and values*/
+static void
+FreeItems( Buffer *items ){
+    ElasticBufItemData *item;
+    for ( int i=0; i < items->header.count; i++ ){
+	item = (ElasticBufItemData*)BufferItemPointer( items, i );
+	TRY_FREE_MRITEM_DATA( item );
+    }
+    FreeBufferData( items );
+}
+
+void
+ReduceSpillWrite( struct MapReduceUserIf *mif,
+		  struct ReduceSpill *spill,
+		  Buffer *sorted ){
+    struct ShuffleWriter writer;
+    struct SpillRun *run;
+    int start, count;
+
+    if ( sorted->header.count ){
+	spill->runs = realloc( spill->runs, (spill->count+1)*sizeof(struct SpillRun) );
+	IF_ALLOC_ERROR(spill->runs?0:(spill->count+1)*sizeof(struct SpillRun));
+	run = &spill->runs[spill->count++];
+	memset( run, '\0', sizeof(*run) );
+	run->offset = lseek( spill->fd, 0, SEEK_END );
+
+	/*run is a sequence of shuffle packets, last packet is flagged*/
+	SHUFFLE_WRITER_INIT( &writer, malloc(SEND_BUFFER_SIZE), SEND_BUFFER_SIZE );
+	IF_ALLOC_ERROR(writer.staging?0:SEND_BUFFER_SIZE);
+	for ( start=0; start < sorted->header.count; start+=count ){
+	    count = MIN( SPILL_PACKET_ITEMS, sorted->header.count-start );
+	    WriteDataToReduce( mif, &writer, spill->fd, sorted, start, count,
+			       start+count == sorted->header.count ? 
+			       MAP_NODE_EXCLUDE : MAP_NODE_NO_EXCLUDE );
+	}
+	free(writer.staging);
+	WRITE_FMT_LOG( "spilled run #%d, %d items\n", spill->count-1, sorted->header.count );
+    }
+
+    /*data is in scratch file now*/
+    FreeItems( sorted );
+}
+
+static void
+SpillRunReadPacket( struct MapReduceUserIf *mif, int fd, struct SpillRun *run ){
+    off_t pos = lseek( fd, run->offset, SEEK_SET );
+    assert( pos == run->offset );
+    run->last = RecvDataFromSingleMap( mif, fd, &run->items, &run->packet ) == MAP_NODE_EXCLUDE;
+    run->offset = lseek( fd, 0, SEEK_CUR );
+    run->pos = 0;
+}
+
+/*Batch of merged items to be passed into Combine and Reduce, it's
+ *referring keys and values of retired packets*/
+struct SpillBatch{
+    Buffer  items;
+    char  **packets;
+    int     packets_count;
+    int     flushed_count;
+};
+
+static void
+SpillBatchFlush( struct MapReduceUserIf *mif, struct SpillBatch *batch ){
+    Buffer combined;
+    int i, ret;
+    WRITE_FMT_LOG( "Reduce batch: %d items\n", batch->items.header.count );
+    if ( mif->Combine ){
+	ret = AllocBuffer( &combined, MRITEM_SIZE(mif), batch->items.header.count/3+1 );
+	IF_ALLOC_ERROR(ret);
+	mif->Combine( &batch->items, &combined );
+	mif->Reduce( &combined );
+	FreeBufferData( &combined );
+    }
+    else{
+	mif->Reduce( &batch->items );
+    }
+    batch->items.header.count = 0;
+    ++batch->flushed_count;
+    for ( i=0; i < batch->packets_count; i++ ){
+	free( batch->packets[i] );
+    }
+    batch->packets_count = 0;
+}
+
+static void
+SpillBatchRetirePacket( struct SpillBatch *batch, char *packet ){
+    if ( !packet ) return;
+    batch->packets = realloc( batch->packets, (batch->packets_count+1)*sizeof(char*) );
+    IF_ALLOC_ERROR(batch->packets?0:(batch->packets_count+1)*sizeof(char*));
+    batch->packets[batch->packets_count++] = packet;
+}
+
+void
+ReduceSpillMerge( struct MapReduceUserIf *mif,
+		  struct ReduceSpill *spill,
+		  Buffer *in_memory ){
+    /*spilled runs are older data and go first, items in memory are last source*/
+    int count = spill->count+1;
+    struct SpillRun *sources = realloc( spill->runs, count*sizeof(struct SpillRun) );
+    IF_ALLOC_ERROR(sources?0:count*sizeof(struct SpillRun));
+    struct SpillBatch batch;
+    const ElasticBufItemData *item, *min_item, *last_item;
+    int i, min, ret;
+
+    memset( &sources[count-1], '\0', sizeof(struct SpillRun) );
+    sources[count-1].items = *in_memory;
+    sources[count-1].last = 1;
+    memset( in_memory, '\0', sizeof(*in_memory) );
+    for ( i=0; i < count-1; i++ ){
+	SpillRunReadPacket( mif, spill->fd, &sources[i] );
+    }
+    memset( &batch, '\0', sizeof(batch) );
+    ret = AllocBuffer( &batch.items, MRITEM_SIZE(mif), SPILL_REDUCE_BATCH_ITEMS );
+    IF_ALLOC_ERROR(ret);
+
+    /*runs count is small, every run is a whole memory of reducer, so
+     *minimum is searched by scanning all runs*/
+    for (;;){
+	min = -1;
+	min_item = NULL;
+	for ( i=0; i < count; i++ ){
+	    if ( sources[i].pos >= sources[i].items.header.count ) continue;
+	    item = (const ElasticBufItemData*)BufferItemPointer( &sources[i].items, sources[i].pos );
+	    if ( min_item == NULL || HASH_CMP(mif, &item->key_hash, &min_item->key_hash) < 0 ){
+		min = i;
+		min_item = item;
+	    }
+	}
+	if ( min == -1 ) break;
+
+	/*batch is full, flush it before next hash begins*/
+	if ( batch.items.header.count >= SPILL_REDUCE_BATCH_ITEMS ){
+	    last_item = (const ElasticBufItemData*)
+		BufferItemPointer( &batch.items, batch.items.header.count-1 );
+	    if ( HASH_CMP(mif, &last_item->key_hash, &min_item->key_hash) != 0 ){
+		SpillBatchFlush( mif, &batch );
+	    }
+	}
+	AddBufferItem( &batch.items, min_item );
+
+	/*read next packet of run, batch is referring previous one*/
+	if ( ++sources[min].pos == sources[min].items.header.count && !sources[min].last ){
+	    FreeBufferData( &sources[min].items );
+	    SpillBatchRetirePacket( &batch, sources[min].packet );
+	    SpillRunReadPacket( mif, spill->fd, &sources[min] );
+	}
+    }
+    /*Reduce is called at least once*/
+    if ( batch.items.header.count || !batch.flushed_count ){
+	SpillBatchFlush( mif, &batch );
+    }
+
+    /*items of packets are not owning data, but items in memory can*/
+    for ( i=0; i < count; i++ ){
+	FreeItems( &sources[i].items );
+	free( sources[i].packet );
+    }
+    free( sources );
+    free( batch.packets );
+    FreeBufferData( &batch.items );
+    close( spill->fd );
+    unlink( spill->path );
+    spill->runs = NULL;
+    spill->count = 0;
+    spill->fd = -1;
+}
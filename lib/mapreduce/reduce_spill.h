@@ -0,0 +1,76 @@
+/*
+ * Spilling of reducer data into scratch file when memory budget exceeded
+ *
+ * Copyright (c) 2013, LiteStack, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef __REDUCE_SPILL_H__
+#define __REDUCE_SPILL_H__
+
+#include <sys/types.h> //off_t
+
+#include "buffer.h"
+
+//forward decl
+struct MapReduceUserIf;
+
+#define REDUCE_MEMORY_BUDGET_ENV  "REDUCE_MEMORY_BUDGET"
+#define REDUCE_SPILL_FILE_ENV     "REDUCE_SPILL_FILE"
+#define DEFAULT_REDUCE_SPILL_FILE "/reduce_spill"
+/*spilled run is written by packets of this items count, only single
+ *packet of every run is in memory while merging*/
+#define SPILL_PACKET_ITEMS        0x4000
+/*items count passed into Combine, Reduce by single call while merging
+ *spilled runs, can be bigger to keep items with equal hashes together*/
+#define SPILL_REDUCE_BATCH_ITEMS  0x10000
+
+/*Sorted run in scratch file*/
+struct SpillRun{
+    off_t  offset;  /*offset of next packet to read*/
+    int    last;    /*1 if packet in memory is last packet of run*/
+    Buffer items;   /*items of packet in memory*/
+    char  *packet;  /*keys and values of items*/
+    int    pos;     /*current item index*/
+};
+
+struct ReduceSpill{
+    const char      *path;
+    int              fd;
+    struct SpillRun *runs;
+    int              count;
+};
+
+/*Create scratch file*/
+void
+ReduceSpillOpen( struct ReduceSpill *spill, const char *path );
+
+/*Write sorted items as new run, items are freed including owned keys
+ *and values*/
+void
+ReduceSpillWrite( struct MapReduceUserIf *mif,
+		  struct ReduceSpill *spill,
+		  Buffer *sorted );
+
+/*Merge spilled runs and sorted items in memory streaming them into
+ *Combine and Reduce by batches, items with equal hashes are never split
+ *between batches; so Reduce is called some times with consecutive
+ *portions of sorted data. Scratch file is removed, in_memory is freed*/
+void
+ReduceSpillMerge( struct MapReduceUserIf *mif,
+		  struct ReduceSpill *spill,
+		  Buffer *in_memory );
+
+#endif //__REDUCE_SPILL_H__
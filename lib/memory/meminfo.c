@@ -0,0 +1,154 @@
+/*
+ *
+ * Copyright (c) 2013, LiteStack, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#include "zrtlog.h"
+#include "zrt_helper_macros.h"
+#include "dyn_array.h"
+#include "memory_syscall_handlers.h"
+#include "meminfo.h"
+
+#define MEMINFO_LINE_MAX 128
+#define KB(bytes) ((long long)(bytes)/1024)
+
+struct MemInfoFsEntry{
+    const char* name;
+    void      (*usage)(void* obj, struct MemInfoFsUsage* usage);
+    void*       obj;
+};
+
+static struct DynArray s_meminfo_fs_entries;
+static int             s_meminfo_fs_entries_inited;
+
+int meminfo_register_fs(const char* name, 
+			void (*usage)(void* obj, struct MemInfoFsUsage* usage), void* obj){
+    struct MemInfoFsEntry* entry;
+    if ( !s_meminfo_fs_entries_inited ){
+	if ( !DynArrayCtor( &s_meminfo_fs_entries, 2 ) ){
+	    SET_ERRNO(ENOMEM);
+	    return -1;
+	}
+	s_meminfo_fs_entries_inited = 1;
+    }
+    if ( (entry = malloc(sizeof(struct MemInfoFsEntry))) == NULL ){
+	SET_ERRNO(ENOMEM);
+	return -1;
+    }
+    entry->name = name;
+    entry->usage = usage;
+    entry->obj = obj;
+    if ( !DynArraySet( &s_meminfo_fs_entries, s_meminfo_fs_entries.num_entries, entry ) ){
+	free(entry);
+	SET_ERRNO(ENOMEM);
+	return -1;
+    }
+    return 0;
+}
+
+/*Get report line by index, it lets log report line by line.
+ *@return formatted length, or -1 if no more lines*/
+static int meminfo_format_line(char* buf, int size, int index, const struct MmapStat* stat,
+			       struct MemoryManagerPublicInterface* memif){
+    long long mapped_bytes = (long long)(stat->pages_total - stat->pages_free) * stat->unit_size;
+    int i;
+    switch(index){
+    case 0: return snprintf(buf, size, "HeapTotal:        %8lld kB\n", 
+			    KB((long long)memif->get_phys_pages(memif)*PAGE_SIZE));
+    case 1: return snprintf(buf, size, "MemAvailable:     %8lld kB\n", 
+			    KB((long long)memif->get_avphys_pages(memif)*PAGE_SIZE));
+    case 2: return snprintf(buf, size, "BrkUsed:          %8lld kB\n", KB(stat->brk_bytes));
+    case 3: return snprintf(buf, size, "BrkPeak:          %8lld kB\n", KB(stat->peak_brk_bytes));
+    case 4: return snprintf(buf, size, "MmapTotal:        %8lld kB\n", 
+			    KB((long long)stat->pages_total*stat->unit_size));
+    case 5: return snprintf(buf, size, "MmapUsed:         %8lld kB\n", KB(mapped_bytes));
+    case 6: return snprintf(buf, size, "MmapPeak:         %8lld kB\n", 
+			    KB((long long)stat->peak_pages_used*stat->unit_size));
+    case 7: return snprintf(buf, size, "MmapFree:         %8lld kB\n", 
+			    KB((long long)stat->pages_free*stat->unit_size));
+    case 8: return snprintf(buf, size, "MmapLargestFree:  %8lld kB\n", 
+			    KB((long long)stat->largest_free_extent*stat->unit_size));
+    case 9: return snprintf(buf, size, "MmapFreeExtents:  %8ld\n", stat->free_extents);
+    case 10: return snprintf(buf, size, "MmapFragmented:   %8d %%\n", stat->fragmentation);
+    case 11: return snprintf(buf, size, "MmapSavedByUnits: %8lld kB\n", KB(stat->saved_bytes));
+    default: break;
+    }
+    index -= 12;
+    /*free runs, only non empty lines are printed; run length is a
+      lower bound of the range*/
+    for ( i=0; i < MMAP_FREE_RUNS_BUCKETS; i++ ){
+	if ( stat->free_runs[i] == 0 ) continue;
+	if ( index-- == 0 ){
+	    char key[32];
+	    snprintf(key, sizeof(key), "FreeRun%lldk:", KB(stat->unit_size << i));
+	    return snprintf(buf, size, "%-18s%8lld kB\n", 
+			    key, KB((long long)stat->free_runs[i]*stat->unit_size));
+	}
+    }
+    /*4 lines per filesystem*/
+    if ( s_meminfo_fs_entries_inited && index/4 < s_meminfo_fs_entries.num_entries ){
+	struct MemInfoFsEntry* entry = DynArrayGet(&s_meminfo_fs_entries, index/4);
+	struct MemInfoFsUsage usage;
+	char key[64];
+	entry->usage(entry->obj, &usage);
+	switch(index%4){
+	case 0: 
+	    snprintf(key, sizeof(key), "%sData:", entry->name);
+	    return snprintf(buf, size, "%-18s%8lld kB\n", key, KB(usage.data_bytes));
+	case 1:
+	    snprintf(key, sizeof(key), "%sSlack:", entry->name);
+	    return snprintf(buf, size, "%-18s%8lld kB\n", key, 
+			    KB(usage.capacity_bytes - usage.data_bytes));
+	case 2:
+	    snprintf(key, sizeof(key), "%sPeak:", entry->name);
+	    return snprintf(buf, size, "%-18s%8lld kB\n", key, KB(usage.peak_capacity_bytes));
+	default:
+	    snprintf(key, sizeof(key), "%sFiles:", entry->name);
+	    return snprintf(buf, size, "%-18s%8d\n", key, usage.files);
+	}
+    }
+    return -1;
+}
+
+int meminfo_report(char* buf, int size){
+    struct MemoryManagerPublicInterface* memif = memory_interface_instance();
+    struct MmapStat stat;
+    int i, len=0, res;
+    memif->mmap_stat(memif, &stat);
+    for ( i=0; 
+	  (res=meminfo_format_line(buf+MIN(len, size), size > len ? size-len : 0, 
+				   i, &stat, memif)) >= 0; 
+	  i++ ){
+	len += res;
+    }
+    return len;
+}
+
+void meminfo_log_report(){
+    struct MemoryManagerPublicInterface* memif = memory_interface_instance();
+    struct MmapStat stat;
+    char line[MEMINFO_LINE_MAX];
+    int i;
+    memif->mmap_stat(memif, &stat);
+    ZRT_LOG(L_BASE, "%s", "memory usage:");
+    for ( i=0; meminfo_format_line(line, sizeof(line), i, &stat, memif) >= 0; i++ ){
+	ZRT_LOG(L_BASE, "%s", line);
+    }
+}
@@ -0,0 +1,50 @@
+/*
+ *
+ * Copyright (c) 2013, LiteStack, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef __MEMINFO_H__
+#define __MEMINFO_H__
+
+#include <stddef.h>
+
+/*Memory usage report in the /proc/meminfo manner, "Key: value kB"
+ *per line. It's summing heap state from memory manager and memory
+ *used by filesystems keeping file data in the heap*/
+
+/*memory used by filesystem*/
+struct MemInfoFsUsage{
+    size_t data_bytes;          /*length of all files*/
+    size_t capacity_bytes;      /*allocated for file data*/
+    size_t peak_capacity_bytes;
+    int    files;               /*files and directories, hardlinks counted once*/
+};
+
+/*Add filesystem to be reported, name should not be freed while it's
+ *in use. usage function is called on every report with obj param
+ *@return 0 if added, -1 and errno ENOMEM if no memory*/
+int meminfo_register_fs(const char* name, 
+			void (*usage)(void* obj, struct MemInfoFsUsage* usage), void* obj);
+
+/*format memory report as text
+ *@return length of whole report, if it's bigger than size then
+ *report was truncated, like snprintf does*/
+int meminfo_report(char* buf, int size);
+
+/*write report into debug log*/
+void meminfo_log_report();
+
+#endif //__MEMINFO_H__
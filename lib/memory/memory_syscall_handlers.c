@@ -18,6 +18,8 @@
  */
 
 
+#define _GNU_SOURCE /*MREMAP_MAYMOVE*/
+
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -31,16 +33,16 @@
 #include "zrtlog.h"
 #include "zrt_helper_macros.h"
 #include "memory_syscall_handlers.h"
-#include "bitarray.h"
+#include "extents_allocator.h"
 
-#define MEMORY_PAGE_FROM_INDEX(memory_if_p, index) ( MMAP_HIGHEST_PAGE_ADDR(memory_if_p) - index*PAGE_SIZE)
+#define MEMORY_PAGE_FROM_INDEX(memory_if_p, index) ( MMAP_HIGHEST_PAGE_ADDR(memory_if_p) - index*MMAP_UNIT_SIZE)
 
 
 #define NO_ADDR_OVERLAP(low_addr, high_addr) (low_addr) < (high_addr) ? 1 : 0
 #define HEAP_MAX_ADDR(heapptr_p, heapsize)  (heapptr_p+heapsize)
 
 #define MMAP_REGION_SIZE_ALIGNED_(heapptr_p, brk_p, heapsize)	\
-    (ROUND_UP(heapsize - ((brk_p) - (heapptr_p)), PAGE_SIZE))
+    (ROUND_UP(heapsize - ((brk_p) - (heapptr_p)), MMAP_UNIT_SIZE))
 
 #define MMAP_REGION_SIZE_ALIGNED(memory_if_p)			\
     MMAP_REGION_SIZE_ALIGNED_(memory_if_p->heap_start_ptr,	\
@@ -51,7 +53,7 @@
     (HEAP_MAX_ADDR(memory_if_p->heap_start_ptr, memory_if_p->heap_size) - MMAP_REGION_SIZE_ALIGNED(memory_if_p))
 
 #define MMAP_HIGHEST_PAGE_ADDR(memory_if_p)				\
-    (HEAP_MAX_ADDR(memory_if_p->heap_start_ptr, memory_if_p->heap_size) - PAGE_SIZE)
+    (HEAP_MAX_ADDR(memory_if_p->heap_start_ptr, memory_if_p->heap_size) - MMAP_UNIT_SIZE)
 
 
 #define SELF_CHECK							\
@@ -63,6 +65,8 @@
     assert(roundup_pow2( 536860612 )== 536870912);			\
     /*check if we have valid PAGE_SIZE macro*/				\
     assert( PAGE_SIZE == sysconf(_SC_PAGE_SIZE) );			\
+    /*mmap unit is a part of page*/					\
+    assert( PAGE_SIZE % MMAP_UNIT_SIZE == 0 );				\
     /*check align for right bound of heap*/				\
     uint32_t heap_max_addr = (uint32_t)HEAP_MAX_ADDR(heap_ptr,heap_size); \
     assert( heap_max_addr == ROUND_UP(heap_max_addr, PAGE_SIZE) );
@@ -73,15 +77,44 @@
 
 static struct MemoryManager KMemoryManager;
 
+/*@return first page index that can't be used by mmap because of brk*/
+static int mmap_pages_end_index(struct MemoryManager* mem_if_p){
+    intptr_t highest = (intptr_t)MMAP_HIGHEST_PAGE_ADDR(mem_if_p);
+    intptr_t brk = (intptr_t)mem_if_p->heap_brk;
+    int end_index;
+    if ( highest < brk ) return 0;
+    /*page with index is allowed if its address upper than brk*/
+    end_index = (highest - brk)/MMAP_UNIT_SIZE +1;
+    return MIN(end_index, mem_if_p->mmap_pages_count);
+}
+
+/*mmap pages from free tail of region are not used, so move lowest
+ *mmap address up to the lowest page in use and let brk grow*/
+static void update_lowest_mmap_addr(struct MemoryManager* mem_if_p){
+    struct ExtentsAllocatorPublicInterface* extents = 
+	(struct ExtentsAllocatorPublicInterface*)&mem_if_p->extents;
+    struct ExtentsStat stat;
+    extents->stat(extents, &stat);
+    /*extents storage pages are always used, so tail_free_begin >0*/
+    mem_if_p->heap_lowest_mmap_addr = MEMORY_PAGE_FROM_INDEX(mem_if_p, (stat.tail_free_begin-1));
+    /*update peak usage*/
+    if ( stat.items_count - stat.free_items > mem_if_p->peak_pages_used )
+	mem_if_p->peak_pages_used = stat.items_count - stat.free_items;
+}
+
 static void* alloc_memory_pseudo_mmap(struct MemoryManager* mem_if_p, 
 				      size_t memsize){ 
-    int i;
     void* ret_addr = NULL;
-    struct BitArrayPublicInterface* bitarray= (struct BitArrayPublicInterface*)&mem_if_p->bitarray;
-    int map_pages_requested = ROUND_UP(memsize, PAGE_SIZE)/PAGE_SIZE;
-
-    /*search for sequence of free pages starting from end*/
-    int mmap_index = bitarray->search_emptybit_sequence_begin(bitarray, 0, map_pages_requested); 
+    struct ExtentsAllocatorPublicInterface* extents = 
+	(struct ExtentsAllocatorPublicInterface*)&mem_if_p->extents;
+    int map_pages_requested = ROUND_UP(memsize, MMAP_UNIT_SIZE)/MMAP_UNIT_SIZE;
+    /*mappings of page size and bigger are page aligned, so end of
+      their units range must be multiple of units per page*/
+    int end_align = map_pages_requested*MMAP_UNIT_SIZE >= PAGE_SIZE ? PAGE_SIZE/MMAP_UNIT_SIZE : 1;
+
+    /*best fit free pages sequence not intersecting with brk*/
+    int mmap_index = extents->alloc(extents, map_pages_requested, 
+				    mmap_pages_end_index(mem_if_p), end_align);
     int mmap_low_page_index = mmap_index+ map_pages_requested-1;
 
     /*if indexes of map pages seems to be valid*/
@@ -93,27 +126,13 @@ static void* alloc_memory_pseudo_mmap(struct MemoryManager* mem_if_p,
 	ZRT_LOG(L_BASE, "pages low_addr=%p, high_addr=%p ", 
 		low_page_memory_addr, high_page_memory_addr);
 	/*it's only allowed to return mmap pages which address upper
-	 *than brk pointer; */
-	if ( low_page_memory_addr >= mem_if_p->heap_brk &&
-	     high_page_memory_addr <= MEMORY_PAGE_FROM_INDEX(mem_if_p, mmap_index) ){
-	    ret_addr = low_page_memory_addr;
-	    /*additional checks*/
-	    assert( ret_addr >= mem_if_p->heap_brk );
-	    assert(low_page_memory_addr <= high_page_memory_addr);
-	    
-	    /*mark map chunks corresponding to returning block of memory*/
-	    int current_chunk_index;
-	    for ( i=0; i < map_pages_requested; i++ ){
-		current_chunk_index = mmap_index+i;
-		LOG_DEBUG(ELogIndex, current_chunk_index, "mark chunk as used" );
-		bitarray->toggle_bit(bitarray, current_chunk_index);
-	    }
-	    ZRT_LOG(L_SHORT, "PSEUDO_MMAP(%u) ret addr=%p", memsize, ret_addr ); 
-	}
-	else{
-	    ZRT_LOG(L_SHORT, "ignore returned low mmap page addr=%p intersects with brk=%p", 
-		    low_page_memory_addr, mem_if_p->heap_brk );
-	}
+	 *than brk pointer, allocator already is limited by brk */
+	ret_addr = low_page_memory_addr;
+	assert( ret_addr >= mem_if_p->heap_brk );
+	assert(low_page_memory_addr <= high_page_memory_addr);
+	/*memory that would be wasted by rounding up to page size*/
+	mem_if_p->saved_bytes += ROUND_UP(memsize, PAGE_SIZE) - map_pages_requested*MMAP_UNIT_SIZE;
+	ZRT_LOG(L_SHORT, "PSEUDO_MMAP(%u) ret addr=%p", memsize, ret_addr ); 
     }
     else{
 	ZRT_LOG(L_SHORT, "PSEUDO_MMAP(%u) failed", memsize );
@@ -145,28 +164,32 @@ memory_init(struct MemoryManager* this,
     this->heap_start_ptr = heap_ptr;
     this->heap_size = heap_size;
     this->heap_brk = brk;  /*current brk*/
-    this->heap_lowest_mmap_addr = MMAP_HIGHEST_PAGE_ADDR(this);
+    this->peak_brk = brk;
+    this->saved_bytes = 0;
+    this->peak_pages_used = 0;
 
   SELF_CHECK;
 
-    /*test*/
-    int temp;
     /*constants*/
-    const int mmap_pages_count = MMAP_REGION_SIZE_ALIGNED_(heap_ptr, brk, heap_size) / PAGE_SIZE;
-    /*init array used to store status of chunks for mmap/munmap.
-     *keep in mind that pages quantity can be not multiple on 8*/
-    const int bit_array_size = mmap_pages_count/8 + ( mmap_pages_count%8>0?1:0 ); 
-    temp=mmap_pages_count/8; temp += mmap_pages_count%8>0?1:0;
-    LOG_DEBUG(ELogSize, bit_array_size, "bitarray actual size in bytes" );
-    /*remove it if working*/
-    assert(bit_array_size==temp);
-
-    /*Create and init bit array
-      set (1)external array as storage, (2)array size and 
-      (3)bitarray pointer to get resulted object*/
-    CONSTRUCT_L(BIT_ARRAY) ( this->map_chunks_bit_array, /*(1)*/
-			     bit_array_size,             /*(2)*/
-			     &this->bitarray );          /*(3)*/
+    const int mmap_pages_count = MMAP_REGION_SIZE_ALIGNED_(heap_ptr, brk, heap_size) / MMAP_UNIT_SIZE;
+    const int extents_pages_count = ROUND_UP(EXTENTS_STORAGE_SIZE(mmap_pages_count), MMAP_UNIT_SIZE) / MMAP_UNIT_SIZE;
+    LOG_DEBUG(ELogSize, mmap_pages_count, "mmap pages count" );
+    assert( mmap_pages_count <= MAX_MMAP_PAGES_COUNT );
+    assert( extents_pages_count < mmap_pages_count );
+    this->mmap_pages_count = mmap_pages_count;
+    this->extents_pages_count = extents_pages_count;
+
+    /*Create free extents allocator, set (1)pages count, (2)storage
+      as highest pages of mmap region and (3)extents pointer to get
+      resulted object*/
+    struct ExtentsAllocatorPublicInterface* extents = 
+	CONSTRUCT_L(EXTENTS_ALLOCATOR) ( mmap_pages_count,                      /*(1)*/
+					 MEMORY_PAGE_FROM_INDEX(this, (extents_pages_count-1)), /*(2)*/
+					 &this->extents );                      /*(3)*/
+    /*storage pages itself are used*/
+    int storage_index = extents->alloc(extents, extents_pages_count, mmap_pages_count, 1);
+    assert( storage_index == 0 );
+    update_lowest_mmap_addr(this);
 }
 
 
@@ -183,6 +206,7 @@ memory_sysbrk(struct MemoryManager* this, void *addr){
     else if ( addr < this->heap_lowest_mmap_addr ){
 	errno=0;
 	this->heap_brk = addr;
+	if ( addr > this->peak_brk ) this->peak_brk = addr;
 	return (intptr_t)this->heap_brk;
     }
     else{
@@ -205,8 +229,8 @@ memory_mmap(struct MemoryManager* this, void *addr, size_t length, int prot,
 	struct stat st;
 	/*fstat is checking fd passed and get file size*/
 	if ( !fstat(fd, &st) ){
-	    /*min amount of memory here is PAGE_SIZE*/
-	    wanted_mem_block_size = st.st_size == 0 ? PAGE_SIZE : st.st_size;
+	    /*min amount of memory here is MMAP_UNIT_SIZE*/
+	    wanted_mem_block_size = st.st_size == 0 ? MMAP_UNIT_SIZE : st.st_size;
 	    alloc_addr = alloc_memory_pseudo_mmap( this, wanted_mem_block_size );
 	    if ( alloc_addr != NULL ){
 		errcode = 0;
@@ -255,8 +279,7 @@ memory_mmap(struct MemoryManager* this, void *addr, size_t length, int prot,
     
     if ( errcode == 0 ){
 	/*update lowest mmap addr, for future check sbrk/mmap intersections*/
-	if ( alloc_addr < this->heap_lowest_mmap_addr )
-	    this->heap_lowest_mmap_addr = alloc_addr;
+	update_lowest_mmap_addr(this);
 	return (intptr_t)alloc_addr;
     }
     else{
@@ -265,52 +288,155 @@ memory_mmap(struct MemoryManager* this, void *addr, size_t length, int prot,
     }
 }
 
+static void
+memory_mmap_stat(struct MemoryManager* this, struct MmapStat* stat){
+    struct ExtentsAllocatorPublicInterface* extents = 
+	(struct ExtentsAllocatorPublicInterface*)&this->extents;
+    struct ExtentsStat extents_stat;
+    extents->stat(extents, &extents_stat);
+    stat->pages_total = this->mmap_pages_count - this->extents_pages_count;
+    stat->pages_free = extents_stat.free_items;
+    stat->free_extents = extents_stat.free_extents;
+    stat->largest_free_extent = extents_stat.largest_free;
+    stat->unit_size = MMAP_UNIT_SIZE;
+    stat->saved_bytes = this->saved_bytes;
+    /*extents storage is not counted*/
+    stat->peak_pages_used = this->peak_pages_used - this->extents_pages_count;
+    extents->free_runs(extents, stat->free_runs, MMAP_FREE_RUNS_BUCKETS);
+    stat->brk_bytes = this->heap_brk - this->heap_start_ptr;
+    stat->peak_brk_bytes = this->peak_brk - this->heap_start_ptr;
+    stat->fragmentation = extents_stat.free_items == 0 ? 0 :
+	100 - (int)((int64_t)extents_stat.largest_free*100/extents_stat.free_items);
+}
+
+/*@return index of page at addr or -1 if it's not mmap page*/
+static int mmap_page_index(struct MemoryManager* this, void *addr){
+    if ( addr < MMAP_LOWEST_PAGE_ADDR(this) || addr > MMAP_HIGHEST_PAGE_ADDR(this) ) 
+	return -1;
+    int index = (MMAP_HIGHEST_PAGE_ADDR(this) - addr) / MMAP_UNIT_SIZE;
+    return index < this->mmap_pages_count ? index : -1;
+}
+
+static void
+log_mmap_stat(struct MemoryManager* this){
+    struct MmapStat stat;
+    memory_mmap_stat(this, &stat);
+    ZRT_LOG(L_INFO, "mmap unit=%ld free units=%ld, free extents=%ld, largest=%ld, "
+	    "fragmentation=%d%%, saved by unit granularity=%lld bytes",
+	    stat.unit_size, stat.pages_free, stat.free_extents, stat.largest_free_extent, 
+	    stat.fragmentation, stat.saved_bytes );
+}
+
 static int
 memory_munmap(struct MemoryManager* this, void *addr, size_t length){
     errno=0;
+    /*the same as mremap, index of unaligned addr would be index of
+      next unit, so it's not allowed*/
+    if ( (intptr_t)addr % MMAP_UNIT_SIZE || length == 0 ){
+	SET_ERRNO(EINVAL);
+	return -1;
+    }
     /*if requested addr is in range of available heap range then it's
       would be returned as heap bound*/
     if ( addr >= MMAP_LOWEST_PAGE_ADDR(this) && addr <= MMAP_HIGHEST_PAGE_ADDR(this) ){
-	int i;
-	int munmap_begin_chunk_index = (MMAP_HIGHEST_PAGE_ADDR(this) - addr) / PAGE_SIZE;
-	int munmap_chnuks_count = ROUND_UP(length,PAGE_SIZE)/PAGE_SIZE;
+	int munmap_begin_chunk_index = (MMAP_HIGHEST_PAGE_ADDR(this) - addr) / MMAP_UNIT_SIZE;
+	int munmap_chnuks_count = ROUND_UP(length,MMAP_UNIT_SIZE)/MMAP_UNIT_SIZE;
 	LOG_DEBUG(ELogIndex, munmap_begin_chunk_index, "" );
 	LOG_DEBUG(ELogCount, munmap_chnuks_count, "" );
 
-	struct BitArrayPublicInterface* bitarray = (struct BitArrayPublicInterface*)&this->bitarray;
-	/*unmap region chunk by chunk*/
-	for ( i=munmap_begin_chunk_index; i < munmap_begin_chunk_index+munmap_chnuks_count ; i++ ){
-	    int bit = bitarray->get_bit( bitarray, i);
-	    ZRT_LOG(L_SHORT, "bit index=%d value=%d", i, bit);
-	    if ( bit == 1 ){
-		bitarray->toggle_bit( bitarray, i);
-	    }
-	    else{
-		LOG_DEBUG(ELogAddress, addr, "indicated address does not contain maped region" )
-		    }
+	struct ExtentsAllocatorPublicInterface* extents = 
+	    (struct ExtentsAllocatorPublicInterface*)&this->extents;
+	/*pages are indexed from the end of memory, so region beginning
+	  at addr occupies indexes going down from begin index, extents
+	  storage pages and pages out of region are never unmapped*/
+	int lowest_index = munmap_begin_chunk_index - munmap_chnuks_count + 1;
+	if ( lowest_index < this->extents_pages_count ) lowest_index = this->extents_pages_count;
+	if ( munmap_begin_chunk_index >= this->mmap_pages_count ) 
+	    munmap_begin_chunk_index = this->mmap_pages_count-1;
+	if ( munmap_begin_chunk_index >= lowest_index ){
+	    /*unmap whole range at once, it's can be a part of mapping,
+	      free neighbours are joined*/
+	    extents->free( extents, lowest_index, 
+			   munmap_begin_chunk_index - lowest_index + 1 );
+	    update_lowest_mmap_addr(this);
+	    log_mmap_stat(this);
 	}
     }
     else{
 	ZRT_LOG(L_ERROR, "Can't do unmap addr=%p is not in range [%p-%p]", 
 		addr, MMAP_LOWEST_PAGE_ADDR(this), MMAP_HIGHEST_PAGE_ADDR(this) );
+	SET_ERRNO(EINVAL);
+	return -1;
     }
     return 0;
 }
 
+static int32_t
+memory_mremap(struct MemoryManager* this, void *old_addr, size_t old_size,
+	      size_t new_size, int flags){
+    struct ExtentsAllocatorPublicInterface* extents = 
+	(struct ExtentsAllocatorPublicInterface*)&this->extents;
+    int old_pages = ROUND_UP(old_size,MMAP_UNIT_SIZE)/MMAP_UNIT_SIZE;
+    int new_pages = ROUND_UP(new_size,MMAP_UNIT_SIZE)/MMAP_UNIT_SIZE;
+    int high_index = mmap_page_index(this, old_addr);
+    /*indexes of mapping are [low_index, high_index]*/
+    int low_index = high_index - old_pages + 1;
+    void* new_addr = old_addr;
+
+    if ( (intptr_t)old_addr % MMAP_UNIT_SIZE || old_pages == 0 || new_pages == 0 ||
+	 flags & ~MREMAP_MAYMOVE || high_index == -1 || 
+	 low_index < this->extents_pages_count ){
+	SET_ERRNO(EINVAL);
+	return (intptr_t)MAP_FAILED;
+    }
+
+    if ( new_pages < old_pages ){
+	/*release pages at the end of mapping*/
+	extents->free(extents, low_index, old_pages-new_pages);
+    }
+    else if ( new_pages > old_pages ){
+	int grow_pages = new_pages-old_pages;
+	/*pages after mapping have lower indexes, get them if free*/
+	if ( low_index - grow_pages < 0 ||
+	     extents->alloc_at(extents, low_index - grow_pages, grow_pages) != 0 ){
+	    if ( !CHECK_FLAG(flags, MREMAP_MAYMOVE) ){
+		SET_ERRNO(ENOMEM);
+		return (intptr_t)MAP_FAILED;
+	    }
+	    new_addr = alloc_memory_pseudo_mmap(this, new_size);
+	    if ( new_addr == NULL ){
+		SET_ERRNO(ENOMEM);
+		return (intptr_t)MAP_FAILED;
+	    }
+	    memcpy(new_addr, old_addr, old_pages*MMAP_UNIT_SIZE);
+	    extents->free(extents, low_index, old_pages);
+	    ZRT_LOG(L_SHORT, "mremap moved %p -> %p", old_addr, new_addr);
+	}
+    }
+    update_lowest_mmap_addr(this);
+    log_mmap_stat(this);
+    return (intptr_t)new_addr;
+}
 
 static long int memory_get_phys_pages(struct MemoryManager* this){
     /*all pages count provided by zerovm (memory rounded up to page size)*/
     uint32_t beginaddr = ROUND_UP((uint32_t)this->heap_start_ptr, PAGE_SIZE);
-    uint32_t endaddr = (uint32_t)MMAP_HIGHEST_PAGE_ADDR(this);
+    uint32_t endaddr = (uint32_t)HEAP_MAX_ADDR(this->heap_start_ptr, this->heap_size);
 
-    return (endaddr - beginaddr)/PAGE_SIZE + 1;
+    return (endaddr - beginaddr)/PAGE_SIZE;
 }
 
 static long int memory_get_avphys_pages(struct MemoryManager* this){
-    /*all pages count we have in mmap memory region.  
-      TODO: Currently it's not a count of available 
-      pages, needed to calculate count.*/
-    return MMAP_REGION_SIZE_ALIGNED(this)/PAGE_SIZE;
+    struct ExtentsAllocatorPublicInterface* extents = 
+	(struct ExtentsAllocatorPublicInterface*)&this->extents;
+    struct ExtentsStat stat;
+    extents->stat(extents, &stat);
+    /*memory between brk and lowest mapping is available for both sbrk
+      and mmap, free tail of mmap region is a part of it*/
+    long long free_bytes = this->heap_lowest_mmap_addr - this->heap_brk;
+    if ( free_bytes < 0 ) free_bytes = 0;
+    free_bytes += (long long)(stat.free_items - (stat.items_count - stat.tail_free_begin)) * MMAP_UNIT_SIZE;
+    return free_bytes / PAGE_SIZE;
 }
 
 
@@ -327,8 +453,10 @@ struct MemoryManagerPublicInterface* memory_interface_construct( void *heap_ptr,
     this->public.sysbrk = (void*)memory_sysbrk;
     this->public.mmap	= (void*)memory_mmap;
     this->public.munmap = (void*)memory_munmap;
+    this->public.mremap = (void*)memory_mremap;
     this->public.get_phys_pages =    (void*)memory_get_phys_pages;
     this->public.get_avphys_pages = (void*)memory_get_avphys_pages;
+    this->public.mmap_stat = (void*)memory_mmap_stat;
 
     /*call init function*/
     this->public.init( (struct MemoryManagerPublicInterface*)this, 
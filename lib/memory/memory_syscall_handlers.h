@@ -22,18 +22,44 @@
 
 #include <stddef.h> //size_t 
 
-#include "bitarray.h"
+#include "extents_allocator.h"
 
 #include "zrt_defines.h" //CONSTRUCT_L
 
 #define MAX_MEMORY_CAPACITY_IN_GB 4
 #define ONE_GB_HEAP_SIZE (1024*1024*1024)
 #define PAGE_SIZE (1024*64)
-#define MAX_MMAP_PAGES_COUNT ( MAX_MEMORY_CAPACITY_IN_GB*(ONE_GB_HEAP_SIZE/PAGE_SIZE) )
+/*Internal allocation unit of mmap region, sysconf reports PAGE_SIZE.
+ *Mappings smaller than PAGE_SIZE are taking only units they need,
+ *bigger ones are still aligned to PAGE_SIZE. Set -DMMAP_UNIT_SIZE=65536
+ *to get page granularity back*/
+#ifndef MMAP_UNIT_SIZE
+#  define MMAP_UNIT_SIZE (1024*4)
+#endif
+#define MAX_MMAP_PAGES_COUNT ( MAX_MEMORY_CAPACITY_IN_GB*(ONE_GB_HEAP_SIZE/MMAP_UNIT_SIZE) )
 
 /*name of constructor*/
 #define MEMORY_MANAGER memory_interface_construct
 
+/*free units are grouped by log2 of free range length*/
+#define MMAP_FREE_RUNS_BUCKETS 16
+
+/*state of mmap region*/
+struct MmapStat{
+    long int unit_size;           /*bytes in mmap unit, counts below are in units*/
+    long int pages_total;         /*units available for mmap*/
+    long int pages_free;
+    long int free_extents;        /*count of free ranges*/
+    long int largest_free_extent; /*units count of largest free range*/
+    int      fragmentation;       /*percent of free units out of largest free range*/
+    long long saved_bytes;        /*total memory not wasted comparing with PAGE_SIZE granularity*/
+    long int peak_pages_used;     /*max units count mapped at once*/
+    int      free_runs[MMAP_FREE_RUNS_BUCKETS]; /*free units in ranges of [2^i, 2^(i+1)) units*/
+    /*sbrk part of heap*/
+    long long brk_bytes;
+    long long peak_brk_bytes;
+};
+
 
 /* Low level memory management functions, here are syscalls
  * implementation.  Note that all member functions has
@@ -73,15 +99,27 @@ struct MemoryManagerPublicInterface{
 		    int flags, int fd, off_t offset);
     
     /* MUNMAP emulation in user-space implementation.
-     * @param addr should be actual address starting map region
-     * @param length ignored  
-     * unmap memory range, in practice memory will released at specified addr*/
+     * @param addr address of unmapping range, rounded down to page
+     * @param length length of range, rounded up to page size
+     * unmap all pages of range, it can be a part of mapping or can
+     * cover several mappings; not mapped pages are ignored*/
     int (*munmap)(struct MemoryManagerPublicInterface* this, void *addr, size_t length);
 
+    /* MREMAP emulation in user-space implementation.
+     * @param old_addr page aligned address of mapping
+     * @param flags only MREMAP_MAYMOVE is supported
+     * Shrinking and growing are done in place if pages next to mapping
+     * are free, otherwise if MREMAP_MAYMOVE is set then data is copied
+     * into new mapping. @return new address or MAP_FAILED*/
+    int32_t (*mremap)(struct MemoryManagerPublicInterface* this, void *old_addr, size_t old_size,
+		      size_t new_size, int flags);
+
     /*result for sysconf(_SC_PHYS_PAGES)*/
     long int (*get_phys_pages)(struct MemoryManagerPublicInterface* this);
     /*result for sysconf(_SC_AVPHYS_PAGES)*/
     long int (*get_avphys_pages)(struct MemoryManagerPublicInterface* this);
+    /*get fragmentation of mmap region*/
+    void (*mmap_stat)(struct MemoryManagerPublicInterface* this, struct MmapStat* stat);
 };
 
 struct MemoryManager{
@@ -92,13 +130,16 @@ struct MemoryManager{
     void*    heap_start_ptr; /*heap memory left bound*/
     void*    heap_brk;       /*current brk pointer*/
     uint32_t heap_size;      /*entire heap size*/
-    void*    heap_lowest_mmap_addr;
-    //
-    /*map_chunks_bit_array is used for bitarray, were are only 1bit per
-     *1page needed.  here reserved memory for max available pages count.*/
-    unsigned char map_chunks_bit_array[(MAX_MMAP_PAGES_COUNT)/8]; 
+    void*    heap_lowest_mmap_addr; /*lowest page of used mmap pages*/
+    int      mmap_pages_count;      /*mmap units count of mmap region*/
+    int      extents_pages_count;   /*pages at top of mmap region reserved for extents*/
+    long long saved_bytes;          /*see MmapStat*/
+    long int peak_pages_used;       /*see MmapStat*/
+    void*    peak_brk;
     //
-    struct BitArray bitarray;
+    /*free extents of mmap pages, storage for extents is taken from
+     *the top of mmap region itself, so it's proportional to heap size*/
+    struct ExtentsAllocator extents;
 };
 
 struct MemoryManagerPublicInterface* memory_interface_construct( void *heap_ptr, uint32_t heap_size, void *brk );
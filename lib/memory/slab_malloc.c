@@ -0,0 +1,391 @@
+/*
+ * slab_malloc.c
+ * Optional size-class slab allocator, it replaces glibc malloc if
+ * libzrtmalloc.a is linked: gcc ... -lzrtmalloc
+ *
+ * Copyright (c) 2013, LiteStack, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define _GNU_SOURCE /*MREMAP_MAYMOVE*/
+
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+
+/*Small objects are served from 64KB slabs, every slab keeps objects
+ *of single size class. Slabs are aligned to SLAB_SIZE, so slab header
+ *is found from object pointer by masking. Big objects are mapped
+ *directly and have the same header at beginning of mapping.
+ *Zerovm session is single threaded and threads of libcontext are
+ *switched cooperatively, so no locks and no per-thread caches needed*/
+
+#define SLAB_SIZE (1024*64)
+#define SLAB_MASK (~((uintptr_t)SLAB_SIZE-1))
+#define SLAB_HEADER_SIZE 64 /*objects of all classes are 16 bytes aligned*/
+#define SLAB_REGION_SLABS 16 /*slabs count requested from memory manager at once*/
+#define SLAB_EMPTY_KEEP 4    /*empty slabs kept for reuse*/
+#define SLAB_MAGIC 0x51ab51ab
+
+/*8 classes by 16 bytes up to 128, then 4 classes per power of two*/
+#define SMALL_CLASSES 8
+#define SMALL_CLASS_STEP 16
+#define SMALL_CLASSES_MAX (SMALL_CLASSES*SMALL_CLASS_STEP)
+#define CLASS_MAX_SIZE (1024*16)
+#define CLASSES_COUNT (SMALL_CLASSES + (14-7)*4)
+#define LARGE_CLASS -1
+
+#define ROUND_UP_SLAB(size) (((size)+SLAB_SIZE-1)&SLAB_MASK)
+
+struct SlabHeader{
+    uint32_t magic;
+    int32_t  size_class;     /*LARGE_CLASS for direct mapping*/
+    size_t   size;           /*object size or mapping length*/
+    int32_t  used;           /*objects in use*/
+    int32_t  listed;         /*is in list of slabs having free objects*/
+    int32_t  mapped;         /*was got by mmap and can be unmapped*/
+    void*    free_list;      /*freed objects*/
+    char*    bump;           /*first never used object*/
+    struct SlabHeader* next; /*list of slabs of class having free objects*/
+    struct SlabHeader* prev;
+};
+
+static struct SlabHeader* s_partial[CLASSES_COUNT];
+static struct SlabHeader* s_empty;
+static int    s_empty_count;
+/*not sliced yet slabs of last region*/
+static char*  s_region_next;
+static char*  s_region_end;
+static int    s_region_mapped;
+
+
+static inline int size_to_class(size_t size){
+    int hibit;
+    if ( size <= SMALL_CLASSES_MAX )
+	return size == 0 ? 0 : (size-1)/SMALL_CLASS_STEP;
+    /*size in (2^hibit, 2^(hibit+1)], divided into 4 classes*/
+    hibit = 31 - __builtin_clz((uint32_t)(size-1));
+    return SMALL_CLASSES + (hibit-7)*4 + (int)(((size-1) - ((size_t)1<<hibit)) >> (hibit-2));
+}
+
+static inline size_t class_to_size(int size_class){
+    int hibit;
+    if ( size_class < SMALL_CLASSES )
+	return (size_class+1)*SMALL_CLASS_STEP;
+    hibit = 7 + (size_class-SMALL_CLASSES)/4;
+    return ((size_t)1<<hibit) + ((size_class-SMALL_CLASSES)%4+1)*((size_t)1<<(hibit-2));
+}
+
+static inline struct SlabHeader* slab_of(void* ptr){
+    struct SlabHeader* slab = (struct SlabHeader*)((uintptr_t)ptr & SLAB_MASK);
+    /*objects aligned to slab size are placed just after header slab*/
+    if ( (void*)slab == ptr ) slab = (struct SlabHeader*)((char*)ptr - SLAB_SIZE);
+    assert( slab->magic == SLAB_MAGIC );
+    return slab;
+}
+
+static void list_add(struct SlabHeader** head, struct SlabHeader* slab){
+    slab->prev = NULL;
+    slab->next = *head;
+    if ( *head ) (*head)->prev = slab;
+    *head = slab;
+    slab->listed = 1;
+}
+
+static void list_remove(struct SlabHeader** head, struct SlabHeader* slab){
+    if ( slab->prev ) slab->prev->next = slab->next;
+    else *head = slab->next;
+    if ( slab->next ) slab->next->prev = slab->prev;
+    slab->listed = 0;
+}
+
+/*get memory aligned to SLAB_SIZE from memory manager, mmap is not
+ *available while prolog is running, so sbrk is a fallback for it
+ *@param mapped 1 if memory can be released by munmap*/
+static void* get_aligned_memory(size_t length, int* mapped){
+    void* addr = mmap(NULL, length, PROT_READ|PROT_WRITE, MAP_ANONYMOUS|MAP_PRIVATE, -1, 0);
+    if ( addr != MAP_FAILED && ((uintptr_t)addr & ~SLAB_MASK) != 0 ){
+	/*not aligned, map one slab more and unmap unaligned head and
+	 *the rest of tail*/
+	munmap(addr, length);
+	addr = mmap(NULL, length+SLAB_SIZE, PROT_READ|PROT_WRITE, 
+		    MAP_ANONYMOUS|MAP_PRIVATE, -1, 0);
+	if ( addr != MAP_FAILED ){
+	    char* aligned = (char*)ROUND_UP_SLAB((uintptr_t)addr);
+	    size_t head = aligned - (char*)addr;
+	    if ( head > 0 )
+		munmap(addr, head);
+	    munmap(aligned+length, SLAB_SIZE-head);
+	    addr = aligned;
+	}
+    }
+    if ( addr != MAP_FAILED ){
+	*mapped = 1;
+	return addr;
+    }
+    else{
+	uintptr_t brk = (uintptr_t)sbrk(0);
+	size_t pad = ROUND_UP_SLAB(brk) - brk;
+	addr = sbrk(pad+length);
+	if ( addr != (void*)-1 ){
+	    *mapped = 0;
+	    return (char*)addr+pad;
+	}
+    }
+    return NULL;
+}
+
+static struct SlabHeader* slab_new(int size_class){
+    struct SlabHeader* slab;
+    if ( s_empty != NULL ){
+	slab = s_empty;
+	list_remove(&s_empty, slab);
+	--s_empty_count;
+    }
+    else{
+	if ( s_region_next == s_region_end ){
+	    s_region_next = get_aligned_memory(SLAB_SIZE*SLAB_REGION_SLABS, &s_region_mapped);
+	    if ( s_region_next == NULL ){
+		s_region_end = NULL;
+		return NULL;
+	    }
+	    s_region_end = s_region_next + SLAB_SIZE*SLAB_REGION_SLABS;
+	}
+	slab = (struct SlabHeader*)s_region_next;
+	s_region_next += SLAB_SIZE;
+	slab->magic = SLAB_MAGIC;
+	slab->mapped = s_region_mapped;
+    }
+    slab->size_class = size_class;
+    slab->size = class_to_size(size_class);
+    slab->used = 0;
+    slab->free_list = NULL;
+    slab->bump = (char*)slab + SLAB_HEADER_SIZE;
+    list_add(&s_partial[size_class], slab);
+    return slab;
+}
+
+static void slab_release(struct SlabHeader* slab){
+    list_remove(&s_partial[slab->size_class], slab);
+    if ( s_empty_count < SLAB_EMPTY_KEEP || !slab->mapped ){
+	list_add(&s_empty, slab);
+	++s_empty_count;
+    }
+    else{
+	/*partial munmap of region is supported by memory manager*/
+	munmap(slab, SLAB_SIZE);
+    }
+}
+
+static void* large_alloc(size_t size, size_t alignment){
+    /*header is placed at beginning of mapping, for big alignment whole
+      first slab is used by header*/
+    size_t offset = alignment < SLAB_SIZE ? 
+	(SLAB_HEADER_SIZE + alignment-1) & ~(alignment-1) : SLAB_SIZE;
+    size_t extra = alignment > SLAB_SIZE ? alignment - SLAB_SIZE : 0;
+    size_t length;
+    int mapped;
+    char* base;
+    struct SlabHeader* slab;
+    if ( size > SIZE_MAX - SLAB_SIZE - offset - extra ){
+	errno = ENOMEM;
+	return NULL;
+    }
+    length = ROUND_UP_SLAB(offset + size);
+    base = get_aligned_memory(length + extra, &mapped);
+    if ( base == NULL ){
+	errno = ENOMEM;
+	return NULL;
+    }
+    if ( extra ){
+	char* ptr = (char*)(((uintptr_t)base + SLAB_SIZE + alignment-1) & ~(alignment-1));
+	/*drop unused head and tail of mapping*/
+	slab = (struct SlabHeader*)(ptr - SLAB_SIZE);
+	if ( mapped ){
+	    if ( (char*)slab > base ) munmap(base, (char*)slab - base);
+	    if ( (char*)slab + length < base + length + extra )
+		munmap((char*)slab + length, base + length + extra - ((char*)slab + length));
+	}
+    }
+    else
+	slab = (struct SlabHeader*)base;
+    slab->magic = SLAB_MAGIC;
+    slab->size_class = LARGE_CLASS;
+    slab->size = length;
+    slab->mapped = mapped;
+    return (char*)slab + offset;
+}
+
+static void* slab_alloc(int size_class){
+    struct SlabHeader* slab = s_partial[size_class];
+    void* ptr;
+    if ( slab == NULL && (slab=slab_new(size_class)) == NULL ){
+	errno = ENOMEM;
+	return NULL;
+    }
+    if ( slab->free_list != NULL ){
+	ptr = slab->free_list;
+	slab->free_list = *(void**)ptr;
+    }
+    else{
+	ptr = slab->bump;
+	slab->bump += slab->size;
+    }
+    ++slab->used;
+    /*slab is full*/
+    if ( slab->free_list == NULL && slab->bump + slab->size > (char*)slab + SLAB_SIZE )
+	list_remove(&s_partial[size_class], slab);
+    return ptr;
+}
+
+/*compiler turns malloc+memset into calloc call, so calloc itself
+ *is using this function instead of malloc*/
+static void* alloc(size_t size){
+    if ( size > CLASS_MAX_SIZE )
+	return large_alloc(size, SMALL_CLASS_STEP);
+    return slab_alloc(size_to_class(size));
+}
+
+void* malloc(size_t size){
+    return alloc(size);
+}
+
+void free(void* ptr){
+    struct SlabHeader* slab;
+    if ( ptr == NULL ) return;
+    slab = slab_of(ptr);
+    if ( slab->size_class == LARGE_CLASS ){
+	/*sbrk memory stays in process*/
+	if ( slab->mapped ) munmap(slab, slab->size);
+	return;
+    }
+    *(void**)ptr = slab->free_list;
+    slab->free_list = ptr;
+    if ( !slab->listed )
+	list_add(&s_partial[slab->size_class], slab);
+    if ( --slab->used == 0 )
+	slab_release(slab);
+}
+
+size_t malloc_usable_size(void* ptr){
+    struct SlabHeader* slab;
+    if ( ptr == NULL ) return 0;
+    slab = slab_of(ptr);
+    if ( slab->size_class == LARGE_CLASS )
+	return slab->size - ((char*)ptr - (char*)slab);
+    return slab->size;
+}
+
+void* calloc(size_t nmemb, size_t size){
+    void* ptr;
+    if ( size && nmemb > SIZE_MAX/size ){
+	errno = ENOMEM;
+	return NULL;
+    }
+    /*memory manager does not clear reused pages*/
+    ptr = alloc(nmemb*size);
+    if ( ptr ) memset(ptr, 0, nmemb*size);
+    return ptr;
+}
+
+void* realloc(void* ptr, size_t size){
+    struct SlabHeader* slab;
+    size_t usable;
+    void* newptr;
+    if ( ptr == NULL ) return alloc(size);
+    if ( size == 0 ){
+	free(ptr);
+	return NULL;
+    }
+    slab = slab_of(ptr);
+    usable = malloc_usable_size(ptr);
+    if ( slab->size_class == LARGE_CLASS && slab->mapped && size > CLASS_MAX_SIZE ){
+	/*grow or shrink mapping without copying*/
+	size_t offset = (char*)ptr - (char*)slab;
+	size_t length = ROUND_UP_SLAB(offset + size);
+	if ( length == slab->size ) return ptr;
+	if ( size > SIZE_MAX - SLAB_SIZE - offset ){
+	    errno = ENOMEM;
+	    return NULL;
+	}
+	newptr = mremap(slab, slab->size, length, MREMAP_MAYMOVE);
+	if ( newptr != MAP_FAILED ){
+	    slab = newptr;
+	    slab->size = length;
+	    return (char*)slab + offset;
+	}
+    }
+    /*small object still fits into its class*/
+    else if ( slab->size_class != LARGE_CLASS && size <= usable ){
+	return ptr;
+    }
+    newptr = alloc(size);
+    if ( newptr == NULL ) return NULL;
+    memcpy(newptr, ptr, usable < size ? usable : size);
+    free(ptr);
+    return newptr;
+}
+
+void* memalign(size_t alignment, size_t size){
+    int size_class;
+    if ( alignment & (alignment-1) ){
+	errno = EINVAL;
+	return NULL;
+    }
+    if ( alignment <= SMALL_CLASS_STEP )
+	return alloc(size);
+    /*objects of slab are aligned if header and class size are aligned*/
+    if ( alignment <= SLAB_HEADER_SIZE && size <= CLASS_MAX_SIZE ){
+	for ( size_class = size_to_class(size < alignment ? alignment : size);
+	      size_class < CLASSES_COUNT; size_class++ ){
+	    if ( class_to_size(size_class) % alignment == 0 )
+		return slab_alloc(size_class);
+	}
+    }
+    return large_alloc(size, alignment);
+}
+
+int posix_memalign(void **memptr, size_t alignment, size_t size){
+    void* ptr;
+    if ( alignment % sizeof(void*) || alignment & (alignment-1) )
+	return EINVAL;
+    ptr = memalign(alignment, size);
+    if ( ptr == NULL ) return ENOMEM;
+    *memptr = ptr;
+    return 0;
+}
+
+void* aligned_alloc(size_t alignment, size_t size){
+    return memalign(alignment, size);
+}
+
+void* valloc(size_t size){
+    return memalign(getpagesize(), size);
+}
+
+void* pvalloc(size_t size){
+    size_t pagesize = getpagesize();
+    return memalign(pagesize, (size + pagesize-1) & ~(pagesize-1));
+}
+
+/*glibc internals are calling these*/
+void* __libc_malloc(size_t size) __attribute__ ((alias ("malloc")));
+void  __libc_free(void* ptr) __attribute__ ((alias ("free")));
+void* __libc_calloc(size_t nmemb, size_t size) __attribute__ ((alias ("calloc")));
+void* __libc_realloc(void* ptr, size_t size) __attribute__ ((alias ("realloc")));
+void* __libc_memalign(size_t alignment, size_t size) __attribute__ ((alias ("memalign")));
@@ -33,6 +33,7 @@
 #include "zrtlog.h"
 #include "nvram_loader.h"
 #include "conf_parser.h"
+#include "trace.h"
 
 #include "observers/args_observer.h"
 #include "observers/debug_observer.h"
@@ -42,6 +43,7 @@
 #include "observers/nvram_observer.h"
 #include "observers/settime_observer.h"
 #include "observers/precache_observer.h"
+#include "observers/random_observer.h"
 
 #define IS_VALID_POINTER_IN_RANGE(whole_data, whole_size, p) \
     (p != NULL && p >= whole_data && p < whole_data+whole_size )
@@ -285,6 +287,8 @@ void nvram_handle(struct NvramLoader* nvram, struct MNvramObserver* observer,
 		  void* obj1, void* obj2, void* obj3){
     struct ParsedRecords* records;
     int i, j;
+    /*section name is kept by observer, so it's valid for trace*/
+    trace_begin(observer->observed_section_name);
     for ( j=0; j < nvram->parsed_sections_count; j++ ){
 	records = &nvram->parsed_sections[j];
 	/*handle only records with observer matched */
@@ -297,6 +301,7 @@ void nvram_handle(struct NvramLoader* nvram, struct MNvramObserver* observer,
 	    }
 	}
     }
+    trace_end(observer->observed_section_name);
 }
 
 /*@return records count in section*/
@@ -341,6 +346,7 @@ struct NvramLoaderPublicInterface* nvram_loader(){
     this->public.add_observer(&this->public, get_mapping_observer() );
     this->public.add_observer(&this->public, get_env_observer() );
     this->public.add_observer(&this->public, get_arg_observer() );
+    this->public.add_observer(&this->public, get_random_observer() );
 
     ZRT_LOG(L_INFO, "nvram object size %u bytes", sizeof(struct NvramLoader));
 
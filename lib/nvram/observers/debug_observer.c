@@ -25,12 +25,18 @@
 
 #include "zrtlog.h"
 #include "debug_observer.h"
+#include "zcalls_stats.h"
+#include "trace.h"
 #include "nvram.h"
 #include "conf_parser.h"
 #include "conf_keys.h"
 
 
 #define DEBUG_PARAM_VERBOSITY_KEY_INDEX    0
+#define DEBUG_PARAM_BINARY_KEY_INDEX       1
+#define DEBUG_PARAM_ZCALLSTATS_KEY_INDEX   2
+#define DEBUG_PARAM_TRACE_KEY_INDEX        3
+#define DEBUG_PARAM_TRACE_THRESHOLD_KEY_INDEX 4
 
 static struct MNvramObserver s_debug_observer;
 
@@ -52,6 +58,36 @@ void handle_debug_record(struct MNvramObserver* observer,
 	    __zrt_log_set_verbosity( v - '0' );
 	}
     }
+
+    char* binary = NULL;
+    ALLOCA_PARAM_VALUE(record->parsed_params_array[DEBUG_PARAM_BINARY_KEY_INDEX], 
+		       &binary);
+    if ( binary && !strcmp("yes", binary) ){
+	ZRT_LOG(L_BASE, "%s", "binary log enabled");
+	__zrt_log_binary_enable(1);
+    }
+
+    char* zcallstats = NULL;
+    ALLOCA_PARAM_VALUE(record->parsed_params_array[DEBUG_PARAM_ZCALLSTATS_KEY_INDEX], 
+		       &zcallstats);
+    if ( zcallstats && !strcmp("yes", zcallstats) ){
+	ZRT_LOG(L_BASE, "%s", "zcalls statistics enabled");
+	zcall_stats_enable(1);
+    }
+
+    char* trace = NULL;
+    char* threshold = NULL;
+    ALLOCA_PARAM_VALUE(record->parsed_params_array[DEBUG_PARAM_TRACE_KEY_INDEX], 
+		       &trace);
+    ALLOCA_PARAM_VALUE(record->parsed_params_array[DEBUG_PARAM_TRACE_THRESHOLD_KEY_INDEX], 
+		       &threshold);
+    if ( trace ){
+	uint64_t ticks = threshold ? strtoull(threshold, NULL, 10) 
+	    : TRACE_DEFAULT_ZCALL_THRESHOLD;
+	ZRT_LOG(L_BASE, "trace enabled, channel=%s, zcall threshold=%llu ticks", 
+		trace, (unsigned long long)ticks);
+	trace_enable(trace, ticks);
+    }
 }
 
 struct MNvramObserver* get_debug_observer(){
@@ -66,6 +102,14 @@ struct MNvramObserver* get_debug_observer(){
     /*check parameters*/
     key_index = self->keys.add_key(&self->keys, DEBUG_PARAM_VERBOSITY_KEY);
     assert(DEBUG_PARAM_VERBOSITY_KEY_INDEX==key_index);
+    key_index = self->keys.add_key(&self->keys, DEBUG_PARAM_BINARY_KEY);
+    assert(DEBUG_PARAM_BINARY_KEY_INDEX==key_index);
+    key_index = self->keys.add_key(&self->keys, DEBUG_PARAM_ZCALLSTATS_KEY);
+    assert(DEBUG_PARAM_ZCALLSTATS_KEY_INDEX==key_index);
+    key_index = self->keys.add_key(&self->keys, DEBUG_PARAM_TRACE_KEY);
+    assert(DEBUG_PARAM_TRACE_KEY_INDEX==key_index);
+    key_index = self->keys.add_key(&self->keys, DEBUG_PARAM_TRACE_THRESHOLD_KEY);
+    assert(DEBUG_PARAM_TRACE_THRESHOLD_KEY_INDEX==key_index);
 
     /*setup functions*/
     s_debug_observer.handle_nvram_record = handle_debug_record;
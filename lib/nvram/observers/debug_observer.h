@@ -22,6 +22,10 @@
 
 #define DEBUG_SECTION_NAME         "debug"
 #define DEBUG_PARAM_VERBOSITY_KEY  "verbosity"
+#define DEBUG_PARAM_BINARY_KEY     "binary"
+#define DEBUG_PARAM_ZCALLSTATS_KEY "zcallstats"
+#define DEBUG_PARAM_TRACE_KEY      "trace"
+#define DEBUG_PARAM_TRACE_THRESHOLD_KEY "tracethreshold"
 
 #include "nvram_observer.h"
 
@@ -33,6 +33,7 @@
 #include "image_engine.h"
 #include "conf_parser.h"
 #include "conf_keys.h"
+#include "trace.h"
 
 
 #define FSTAB_PARAM_CHANNEL_KEY_INDEX    0
@@ -121,7 +122,9 @@ void handle_mount_export(struct FstabObserver* observer){
 
 	/*save files located at mount_path into tar archive*/
 	if ( !strcmp(access, FSTAB_VAL_ACCESS_WRITE) ){
+	    trace_begin("tar_export");
 	    int res = save_as_tar(mount_path, channel_alias);
+	    trace_end("tar_export");
 	    ZRT_LOG(L_SHORT, "save_as_tar res=%d, dirpath=%s, tar_path=%s", 
 		    res, mount_path, channel_alias);
 	}
@@ -153,6 +156,7 @@ void handle_mount_import(struct FstabObserver* observer, struct FstabRecordConta
 	    record->mount_status = EFstabMountProcessing;	    
 	    /*create mounts reader linked to tar archive that contains filesystem image,
 	      it call "read" from MountsPublicInterface and don't call "read" function from posix layer*/
+	    trace_begin("tar_import");
 	    struct MountsReader* mounts_reader =
 		alloc_mounts_reader( s_channels_mount, channel_alias );
 
@@ -182,7 +186,9 @@ void handle_mount_import(struct FstabObserver* observer, struct FstabRecordConta
 		free_unpacker_tar( tar_unpacker );
 		free_image_loader( image_loader );
 		free_mounts_reader( mounts_reader );
+		trace_counter("tar_import_files", inject_res);
 	    }
+	    trace_end("tar_import");
 	}
     }
 }
@@ -0,0 +1,89 @@
+/*
+ *
+ * Copyright (c) 2013, LiteStack, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <assert.h>
+
+#include "zrt_defines.h"
+
+#include "zrtlog.h"
+#include "random_observer.h"
+#include "nvram.h"
+#include "conf_parser.h"
+#include "conf_keys.h"
+#include "channels_mount.h"
+
+
+#define RANDOM_PARAM_SEED_KEY_INDEX    0
+
+static struct MNvramObserver s_random_observer;
+static struct ChannelsModeUpdaterPublicInterface *s_nvram_random_setting_updater;
+
+void handle_random_record(struct MNvramObserver* observer,
+			  struct ParsedRecord* record,
+			  void* obj1, void* obj2, void* obj3){
+    assert(record);
+
+    /*get param seed*/
+    char* seed = NULL;
+    ALLOCA_PARAM_VALUE(record->parsed_params_array[RANDOM_PARAM_SEED_KEY_INDEX], 
+		       &seed);
+    ZRT_LOG(L_SHORT, "random record: seed=%s", seed);
+
+    /*the same seed gives reproducible output of random devices*/
+    if ( seed != NULL && seed[0] != '\0' ){
+	char* endptr;
+	uint64_t seed_value = strtoull(seed, &endptr, 0);
+	assert(s_nvram_random_setting_updater);
+	if ( *endptr == '\0' ){
+	    s_nvram_random_setting_updater->set_random_seed(s_nvram_random_setting_updater, 
+							    seed_value);
+	    ZRT_LOG(L_BASE, "random devices seed=%llu", seed_value );
+	}
+	else{
+	    ZRT_LOG(L_ERROR, "invalid seed=%s ignored", seed );
+	}
+    }
+}
+
+void set_random_channels_settings_updater( struct ChannelsModeUpdaterPublicInterface 
+					   *nvram_random_setting_updater ){
+    s_nvram_random_setting_updater = nvram_random_setting_updater;
+}
+
+struct MNvramObserver* get_random_observer(){
+    struct MNvramObserver* self = &s_random_observer;
+    ZRT_LOG(L_INFO, "Create observer for section: %s", RANDOM_SECTION_NAME);
+    /*setup section name*/
+    strncpy(self->observed_section_name, RANDOM_SECTION_NAME, NVRAM_MAX_SECTION_NAME_LEN);
+    /*setup section keys*/
+    keys_construct(&self->keys);
+    /*add keys and check returned key indexes that are the same as expected*/
+    int key_index;
+    /*check parameters*/
+    key_index = self->keys.add_key(&self->keys, RANDOM_PARAM_SEED_KEY);
+    assert(RANDOM_PARAM_SEED_KEY_INDEX==key_index);
+
+    /*setup functions*/
+    s_random_observer.handle_nvram_record = handle_random_record;
+    ZRT_LOG(L_SHORT, "OK observer for section: %s", RANDOM_SECTION_NAME);
+    return &s_random_observer;
+}
@@ -0,0 +1,37 @@
+/*
+ *
+ * Copyright (c) 2013, LiteStack, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef RANDOM_OBSERVER_H_
+#define RANDOM_OBSERVER_H_
+
+#define HANDLE_ONLY_RANDOM_SECTION get_random_observer()
+
+#define RANDOM_SECTION_NAME         "random"
+#define RANDOM_PARAM_SEED_KEY       "seed"
+
+#include "nvram_observer.h"
+
+struct ChannelsModeUpdaterPublicInterface;
+
+void set_random_channels_settings_updater( struct ChannelsModeUpdaterPublicInterface 
+					   *nvram_random_setting_updater );
+
+/*get static interface, object not intended to destroy after using*/
+struct MNvramObserver* get_random_observer();
+
+#endif /* RANDOM_OBSERVER_H_ */
@@ -26,6 +26,7 @@
 struct stat;
 struct dirent;
 struct timeval;
+struct iovec;
 
 struct NvramLoader;
 
@@ -157,6 +158,15 @@ int zrt_zcall_ftruncate(int fd, off_t length);
 int zrt_zcall_stat_realpath(const char *abspathname, struct stat *stat);
 int zrt_zcall_get_phys_pages(void);
 int zrt_zcall_get_avphys_pages(void);
+ssize_t zrt_zcall_readv(int fd, const struct iovec *iov, int iovcnt);
+ssize_t zrt_zcall_writev(int fd, const struct iovec *iov, int iovcnt);
+ssize_t zrt_zcall_preadv(int fd, const struct iovec *iov, int iovcnt, off_t offset);
+ssize_t zrt_zcall_pwritev(int fd, const struct iovec *iov, int iovcnt, off_t offset);
+ssize_t zrt_zcall_sendfile(int out_fd, int in_fd, off_t *offset, size_t count);
+ssize_t zrt_zcall_copy_file_range(int fd_in, off_t *off_in, int fd_out, off_t *off_out,
+				  size_t len, unsigned int flags);
+int zrt_zcall_fadvise(int fd, off_t offset, off_t len, int advice);
+int zrt_zcall_mremap(void **addr, size_t old_size, size_t new_size, int flags);
 
 #endif //__ZCALLS_H__
 
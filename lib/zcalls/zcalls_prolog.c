@@ -27,6 +27,7 @@
 #include "zvm.h"
 #include "zcalls.h"
 #include "zcalls_zrt.h" //nvram()
+#include "trace.h"
 #include "nvram_loader.h"
 #include "fstab_observer.h"
 #include "settime_observer.h"
@@ -89,6 +90,7 @@ void zrt_zcall_prolog_init(){
     strcpy(__curr_dir_path, "/\0" );
 
     __zrt_log_init( DEV_DEBUG );
+    trace_begin("prolog_init");
     ZRT_LOG(L_BASE, P_TEXT, "prolog init");
     ZRT_LOG_LOW_LEVEL(FUNC_NAME);
     s_prolog_doing_now = 1;
@@ -111,6 +113,9 @@ void zrt_zcall_prolog_init(){
 	    nvram->handle(nvram, HANDLE_ONLY_TIME_SECTION, &s_cached_timeval, NULL, NULL);
 	}
     }
+    trace_end("prolog_init");
+    /*from now it's known if tracing enabled by nvram*/
+    trace_prolog_done();
 }
 
 void zrt_zcall_prolog_exit(int status){
@@ -0,0 +1,113 @@
+/*
+ * zcalls_stats.c
+ * Per zcall counters and latency histograms
+ *
+ * Copyright (c) 2013, LiteStack, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "zrtlog.h"
+#include "zrt_helper_macros.h"
+#include "zcalls_stats.h"
+
+#define ZCALL_STATS_LINE_MAX 1024
+#define ZCALL_STATS_HEADER \
+    "#zcall calls errors bytes ticks avg_ticks log2(ticks):calls...\n"
+
+static const char* s_zcall_names[EZcallsCount] = {
+    "gettod", "clock", "nanosleep", "sched_yield", "sysconf",
+    "close", "dup", "dup2", "read", "write", "seek",
+    "fstat", "getdents", "open", "stat",
+    "sysbrk", "mmap", "munmap",
+    "getres", "gettime", "chdir",
+    "fcntl", "link", "unlink", "rmdir", "mkdir",
+    "chmod", "fchmod", "chown", "fchown", "ftruncate",
+    "stat_realpath", "get_phys_pages", "get_avphys_pages",
+    "readv", "writev", "preadv", "pwritev",
+    "sendfile", "copy_file_range", "fadvise", "mremap"
+};
+
+static int s_zcall_stats_enabled;
+static struct ZcallStatsItem s_zcall_stats[EZcallsCount];
+
+void zcall_stats_enable(int status){
+    s_zcall_stats_enabled = status;
+}
+
+int zcall_stats_is_enabled(){
+    return s_zcall_stats_enabled;
+}
+
+void zcall_stats_update(ZcallId id, int is_error, uint64_t bytes, uint64_t start_ticks){
+    struct ZcallStatsItem* item = &s_zcall_stats[id];
+    uint64_t end_ticks = cpu_ticks();
+    uint64_t ticks = end_ticks - start_ticks;
+    int bucket = ticks != 0 ? 63 - __builtin_clzll(ticks) : 0;
+    if ( trace_is_enabled() )
+	trace_zcall(s_zcall_names[id], start_ticks, end_ticks);
+    if ( !s_zcall_stats_enabled ) return;
+    ++item->calls;
+    if ( is_error ) ++item->errors;
+    item->bytes += bytes;
+    item->ticks += ticks;
+    ++item->histogram[MIN(bucket, ZCALL_STATS_HISTOGRAM_SIZE-1)];
+}
+
+const struct ZcallStatsItem* zcall_stats_get(ZcallId id){
+    return &s_zcall_stats[id];
+}
+
+/*@return formatted length of zcall line, unused zcalls are skipped*/
+static int zcall_stats_format_line(char* buf, int size, ZcallId id){
+    const struct ZcallStatsItem* item = &s_zcall_stats[id];
+    int i, len, res;
+    if ( item->calls == 0 ) return 0;
+    len = snprintf(buf, size, "%s %llu %llu %llu %llu %llu", s_zcall_names[id],
+		   (unsigned long long)item->calls, (unsigned long long)item->errors, 
+		   (unsigned long long)item->bytes, (unsigned long long)item->ticks,
+		   (unsigned long long)(item->ticks / item->calls) );
+    for ( i=0; i < ZCALL_STATS_HISTOGRAM_SIZE; i++ ){
+	if ( item->histogram[i] == 0 ) continue;
+	res = snprintf(buf+MIN(len, size), size > len ? size-len : 0, 
+		       " %d:%u", i, item->histogram[i]);
+	if ( res > 0 ) len += res;
+    }
+    res = snprintf(buf+MIN(len, size), size > len ? size-len : 0, "\n");
+    if ( res > 0 ) len += res;
+    return len;
+}
+
+int zcall_stats_report(char* buf, int size){
+    int id, len;
+    len = snprintf(buf, size, ZCALL_STATS_HEADER);
+    for ( id=0; id < EZcallsCount; id++ ){
+	len += zcall_stats_format_line(buf+MIN(len, size), size > len ? size-len : 0, id);
+    }
+    return len;
+}
+
+void zcall_stats_log_report(){
+    char line[ZCALL_STATS_LINE_MAX];
+    int id;
+    if ( !s_zcall_stats_enabled ) return;
+    ZRT_LOG(L_BASE, "%s", "zcalls statistics " ZCALL_STATS_HEADER);
+    for ( id=0; id < EZcallsCount; id++ ){
+	if ( zcall_stats_format_line(line, sizeof(line), id) > 0 ){
+	    ZRT_LOG(L_BASE, "%s", line);
+	}
+    }
+}
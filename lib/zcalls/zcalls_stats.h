@@ -0,0 +1,88 @@
+/*
+ * zcalls_stats.h
+ * Per zcall counters and latency histograms
+ *
+ * Copyright (c) 2013, LiteStack, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __ZCALLS_STATS_H__
+#define __ZCALLS_STATS_H__
+
+#include <stdint.h>
+#include "ticks.h" /*cpu_ticks*/
+#include "trace.h"
+
+/*Statistics are collected only if enabled by nvram, time is measured
+ *in cpu ticks like I/O statistics do, because zrt clock is synthetic*/
+
+typedef enum { 
+    /*zcalls_init_t*/
+    EZcallGettod=0, EZcallClock, EZcallNanosleep, EZcallSchedYield, EZcallSysconf,
+    EZcallClose, EZcallDup, EZcallDup2, EZcallRead, EZcallWrite, EZcallSeek, 
+    EZcallFstat, EZcallGetdents, EZcallOpen, EZcallStat, 
+    EZcallSysbrk, EZcallMmap, EZcallMunmap, 
+    EZcallGetres, EZcallGettime, EZcallChdir,
+    /*zcalls_nonsyscalls_t*/
+    EZcallFcntl, EZcallLink, EZcallUnlink, EZcallRmdir, EZcallMkdir, 
+    EZcallChmod, EZcallFchmod, EZcallChown, EZcallFchown, EZcallFtruncate, 
+    EZcallStatRealpath, EZcallGetPhysPages, EZcallGetAvphysPages,
+    EZcallReadv, EZcallWritev, EZcallPreadv, EZcallPwritev, 
+    EZcallSendfile, EZcallCopyFileRange, EZcallFadvise, EZcallMremap,
+    EZcallsCount 
+} ZcallId;
+
+/*bucket i is counting calls took [2^i, 2^(i+1)) ticks, last one
+ *is counting all longer calls*/
+#define ZCALL_STATS_HISTOGRAM_SIZE 40
+
+struct ZcallStatsItem{
+    uint64_t calls;
+    uint64_t errors;
+    uint64_t bytes;
+    uint64_t ticks;
+    uint32_t histogram[ZCALL_STATS_HISTOGRAM_SIZE];
+};
+
+/*Measure zcall, put ZCALL_STATS_START before call and
+ *ZCALL_STATS_FINISH after it in the same scope; measured zcall is
+ *also traced if tracing is enabled*/
+#define ZCALL_STATS_START						\
+    uint64_t zcall_stats_start_123 =					\
+	zcall_stats_is_enabled() || trace_is_enabled() ? cpu_ticks() : 0
+
+#define ZCALL_STATS_FINISH(id, is_error, bytes)				\
+    if ( zcall_stats_start_123 != 0 ){					\
+	zcall_stats_update(id, is_error, bytes, zcall_stats_start_123);	\
+    }
+
+/* 1 switch on statistics
+ * 0 switch off statistics*/
+void zcall_stats_enable(int status);
+int  zcall_stats_is_enabled();
+
+void zcall_stats_update(ZcallId id, int is_error, uint64_t bytes, uint64_t start_ticks);
+
+/*get statistics of zcall*/
+const struct ZcallStatsItem* zcall_stats_get(ZcallId id);
+
+/*format table of used zcalls
+ *@return length of whole report, if it's bigger than size then
+ *report was truncated, like snprintf does*/
+int zcall_stats_report(char* buf, int size);
+
+/*write report into debug log, if statistics enabled*/
+void zcall_stats_log_report();
+
+#endif //__ZCALLS_STATS_H__
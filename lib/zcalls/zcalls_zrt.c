@@ -56,6 +56,7 @@
 #include "mapping_observer.h"
 #include "precache_observer.h"
 #include "debug_observer.h"
+#include "random_observer.h"
 #include "nvram_loader.h"
 #include "mounts_manager.h"
 #include "mem_mount_wraper.h"
@@ -64,6 +65,11 @@
 #include "enum_strings.h"
 #include "channels_reserved.h"
 #include "channels_mount.h"
+#include "random_generator.h" /*random_session_seed*/
+#include "io_stats.h"
+#include "meminfo.h"
+#include "zcalls_stats.h"
+#include "trace.h"
 
 extern char **environ;
 
@@ -75,12 +81,15 @@ static struct ZVMChannel s_emu_channels[]
     {{CHANNEL_OPS_LIMIT, CHANNEL_SIZE_LIMIT,CHANNEL_OPS_LIMIT, CHANNEL_SIZE_LIMIT},0,SGetSPut,"/dev/full"},
     {{CHANNEL_OPS_LIMIT, CHANNEL_SIZE_LIMIT,CHANNEL_OPS_LIMIT, CHANNEL_SIZE_LIMIT},0,SGetSPut,"/dev/zero"},
     {{CHANNEL_OPS_LIMIT, CHANNEL_SIZE_LIMIT,CHANNEL_OPS_LIMIT, CHANNEL_SIZE_LIMIT},0,SGetSPut,"/dev/random"},
-    {{CHANNEL_OPS_LIMIT, CHANNEL_SIZE_LIMIT,CHANNEL_OPS_LIMIT, CHANNEL_SIZE_LIMIT},0,SGetSPut,"/dev/urandom"}};
+    {{CHANNEL_OPS_LIMIT, CHANNEL_SIZE_LIMIT,CHANNEL_OPS_LIMIT, CHANNEL_SIZE_LIMIT},0,SGetSPut,"/dev/urandom"},
+    {{CHANNEL_OPS_LIMIT, CHANNEL_SIZE_LIMIT,0, 0},0,SGetSPut,DEV_ZRTSTAT},
+    {{CHANNEL_OPS_LIMIT, CHANNEL_SIZE_LIMIT,0, 0},0,SGetSPut,DEV_MEMINFO}};
 
 struct MountsPublicInterface*        s_channels_mount=NULL;
 struct MountsPublicInterface*        s_mem_mount=NULL;
 static struct MountsManager*   s_mounts_manager = NULL;
 static struct MountsPublicInterface* s_transparent_mount = NULL;
+static struct ChannelsModeUpdaterPublicInterface* s_channels_mode_updater = NULL;
 static int                     s_zrt_ready=0;
 /****************** */
 
@@ -103,6 +112,11 @@ void zrt_internal_init( const struct UserManifest const* manifest );
 void zrt_zcall_enhanced_exit(int status){
     ZRT_LOG(L_SHORT, "status %d exiting...", status);
     get_fstab_observer()->mount_export(HANDLE_ONLY_FSTAB_SECTION);
+    io_stats_log_report();
+    meminfo_log_report();
+    zcall_stats_log_report();
+    trace_write(s_transparent_mount);
+    __zrt_log_binary_flush();
     zvm_exit(status); /*get controls into zerovm*/
     /* unreachable code*/
     return; 
@@ -144,11 +158,8 @@ int  zrt_zcall_enhanced_read(int handle, void *buf, size_t count, size_t *nread)
 
 int  zrt_zcall_enhanced_write(int handle, const void *buf, size_t count, size_t *nwrote){
     int ret=-1;
-    int log_state = __zrt_log_is_enabled();
-    /*disable logging while writing to stdout and stderr channel */
-    if ( handle <= 2 && log_state ){
-	__zrt_log_enable(0);
-    }
+    int log_state;
+    DISABLE_LOG_FOR_STD_HANDLES(handle, &log_state);
 
     LOG_SYSCALL_START("handle=%d buf=%p count=%u", handle, buf, count);
     VALIDATE_SYSCALL_PTR(buf);
@@ -161,8 +172,7 @@ int  zrt_zcall_enhanced_write(int handle, const void *buf, size_t count, size_t
     }
     LOG_INFO_SYSCALL_FINISH( ret, "bytes_wrote=%d, handle=%d count=%u", 
 			     bytes_wrote, handle, count);
-    if ( log_state )
-	__zrt_log_enable(log_state); /*restore log state*/
+    RESTORE_LOG_STATE(log_state);
     return ret;
 }
 
@@ -366,11 +376,15 @@ void zrt_internal_session_info( const struct UserManifest const* manifest ){
 /*Basic zrt initializer*/
 void zrt_zcall_enhanced_zrt_setup(void){
     struct NvramLoaderPublicInterface* nvram = INSTANCE_L(NVRAM_LOADER)();
+    trace_begin("zrt_setup");
     zrt_internal_init(MANIFEST);
 
     if ( NULL != nvram->section_by_name( nvram, MAPPING_SECTION_NAME ) ){
 	nvram->handle(nvram, HANDLE_ONLY_MAPPING_SECTION, NULL, NULL, NULL);
     }
+    if ( NULL != nvram->section_by_name( nvram, RANDOM_SECTION_NAME ) ){
+	nvram->handle(nvram, HANDLE_ONLY_RANDOM_SECTION, NULL, NULL, NULL);
+    }
     if ( NULL != nvram->section_by_name( nvram, FSTAB_SECTION_NAME ) ){
 	nvram->handle(nvram, (struct MNvramObserver*)HANDLE_ONLY_FSTAB_SECTION, 
 		      s_channels_mount, s_transparent_mount, NULL );
@@ -384,13 +398,16 @@ void zrt_zcall_enhanced_zrt_setup(void){
 	    zfork();
 	}
     }
+    trace_end("zrt_setup");
 }
 
 
 void zrt_zcall_enhanced_premain(void){
+    trace_begin("premain");
     zrt_internal_session_info(MANIFEST);
     ZRT_LOG(L_INFO, P_TEXT, "zrt startup finished!");
     ZRT_LOG_DELIMETER;
+    trace_end("premain");
 }
 
 
@@ -419,6 +436,8 @@ void zrt_internal_init( const struct UserManifest const* manifest ){
 					  s_emu_channels, 
 					  sizeof(s_emu_channels)/sizeof(struct ZVMChannel));
     set_mapping_channels_settings_updater( nvram_mode_setting_updater ); 
+    set_random_channels_settings_updater( nvram_mode_setting_updater ); 
+    s_channels_mode_updater = nvram_mode_setting_updater;
 
     /*alloc main filesystem that combines all filesystems mounts*/
     s_transparent_mount = alloc_transparent_mount( s_mounts_manager );
@@ -451,13 +470,25 @@ int is_zrt_ready(){
 }
 
 
+int zrt_trace_write(){
+    return trace_write(s_transparent_mount);
+}
+
 int zfork(){
     ZRT_LOG(L_INFO, P_TEXT, "call zvm_fork");
+    /*records buffered by binary log belong to session being forked*/
+    __zrt_log_binary_flush();
     /*zvm fork syscall here
       ...*/
     int res = zvm_fork();
+    __zrt_log_binary_sites_reset();
     ZRT_LOG(L_INFO, "zvm_fork res=%d", res);
 
+    /*every forked session must get its own output of random devices,
+      seed from nvram random section, if any, overrides it below*/
+    s_channels_mode_updater->set_random_seed(s_channels_mode_updater, 
+					     random_session_seed());
+
     /*update state for removable mounts, all removable mounts needs to be refreshed*/
     get_fstab_observer()->reset_removable(HANDLE_ONLY_FSTAB_SECTION);
 
@@ -477,6 +508,10 @@ int zfork(){
 	if ( NULL != nvram->section_by_name( nvram, TIME_SECTION_NAME ) ){
 	    nvram->handle(nvram, HANDLE_ONLY_TIME_SECTION, static_timeval(), NULL, NULL);
 	}
+	/*handle random section, seed can be changed for forked session*/
+	if ( NULL != nvram->section_by_name( nvram, RANDOM_SECTION_NAME ) ){
+	    nvram->handle(nvram, HANDLE_ONLY_RANDOM_SECTION, NULL, NULL, NULL);
+	}
     }
     ZRT_LOG(L_SHORT, "zfork() res=%d ", res);
     return res;
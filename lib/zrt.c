@@ -24,33 +24,164 @@
 
 
 #ifndef ZLIBC_STUB
+#  include <stdarg.h>
+#  include <fcntl.h> //F_SETLK
+#  include <sys/uio.h>
 #  include "zrt.h"
 #  include "zcalls.h"
+#  include "zcalls_stats.h"
+
+/*Wrapper of zcall collecting statistics, see zcalls_stats.h; 
+ *is_error, bytes are expressions evaluated after call, they can
+ *use ret and params*/
+#define ZCALL_STATS_WRAPPER(rettype, func, id, is_error, bytes, params, args) \
+    static rettype func##_stats params {				\
+	ZCALL_STATS_START;						\
+	rettype ret = func args;					\
+	ZCALL_STATS_FINISH(id, is_error, bytes);			\
+	return ret;							\
+    }
+
+/*zcalls_init_t functions return 0 on success*/
+ZCALL_STATS_WRAPPER(int, zrt_zcall_prolog_gettod, EZcallGettod, ret!=0, 0,
+		    (struct timeval *tv), (tv))
+ZCALL_STATS_WRAPPER(int, zrt_zcall_prolog_clock, EZcallClock, ret!=0, 0,
+		    (clock_t *ticks), (ticks))
+ZCALL_STATS_WRAPPER(int, zrt_zcall_prolog_nanosleep, EZcallNanosleep, ret!=0, 0,
+		    (const struct timespec *req, struct timespec *rem), (req, rem))
+ZCALL_STATS_WRAPPER(int, zrt_zcall_prolog_sched_yield, EZcallSchedYield, ret!=0, 0,
+		    (void), ())
+ZCALL_STATS_WRAPPER(int, zrt_zcall_prolog_sysconf, EZcallSysconf, ret!=0, 0,
+		    (int name, int *value), (name, value))
+ZCALL_STATS_WRAPPER(int, zrt_zcall_prolog_close, EZcallClose, ret!=0, 0,
+		    (int fd), (fd))
+ZCALL_STATS_WRAPPER(int, zrt_zcall_prolog_dup, EZcallDup, ret!=0, 0,
+		    (int fd, int *newfd), (fd, newfd))
+ZCALL_STATS_WRAPPER(int, zrt_zcall_prolog_dup2, EZcallDup2, ret!=0, 0,
+		    (int fd, int newfd), (fd, newfd))
+ZCALL_STATS_WRAPPER(int, zrt_zcall_prolog_read, EZcallRead, ret!=0, ret==0 ? *nread : 0,
+		    (int fd, void *buf, size_t count, size_t *nread), (fd, buf, count, nread))
+ZCALL_STATS_WRAPPER(int, zrt_zcall_prolog_write, EZcallWrite, ret!=0, ret==0 ? *nwrote : 0,
+		    (int fd, const void *buf, size_t count, size_t *nwrote), 
+		    (fd, buf, count, nwrote))
+ZCALL_STATS_WRAPPER(int, zrt_zcall_prolog_seek, EZcallSeek, ret!=0, 0,
+		    (int fd, off_t offset, int whence, off_t *new_offset), 
+		    (fd, offset, whence, new_offset))
+ZCALL_STATS_WRAPPER(int, zrt_zcall_prolog_fstat, EZcallFstat, ret!=0, 0,
+		    (int fd, struct stat *st), (fd, st))
+ZCALL_STATS_WRAPPER(int, zrt_zcall_prolog_getdents, EZcallGetdents, ret!=0, ret==0 ? *nread : 0,
+		    (int fd, struct dirent *dirent_buf, size_t count, size_t *nread), 
+		    (fd, dirent_buf, count, nread))
+ZCALL_STATS_WRAPPER(int, zrt_zcall_prolog_open, EZcallOpen, ret!=0, 0,
+		    (const char *pathname, int oflag, mode_t cmode, int *newfd), 
+		    (pathname, oflag, cmode, newfd))
+ZCALL_STATS_WRAPPER(int, zrt_zcall_prolog_stat, EZcallStat, ret!=0, 0,
+		    (const char *pathname, struct stat *st), (pathname, st))
+ZCALL_STATS_WRAPPER(int, zrt_zcall_prolog_sysbrk, EZcallSysbrk, ret!=0, 0,
+		    (void **newbrk), (newbrk))
+ZCALL_STATS_WRAPPER(int, zrt_zcall_prolog_mmap, EZcallMmap, ret!=0, ret==0 ? len : 0,
+		    (void **addr, size_t len, int prot, int flags, int fd, off_t off), 
+		    (addr, len, prot, flags, fd, off))
+ZCALL_STATS_WRAPPER(int, zrt_zcall_prolog_munmap, EZcallMunmap, ret!=0, ret==0 ? len : 0,
+		    (void *addr, size_t len), (addr, len))
+ZCALL_STATS_WRAPPER(int, zrt_zcall_prolog_getres, EZcallGetres, ret!=0, 0,
+		    (clockid_t clk_id, struct timespec *res), (clk_id, res))
+ZCALL_STATS_WRAPPER(int, zrt_zcall_prolog_gettime, EZcallGettime, ret!=0, 0,
+		    (clockid_t clk_id, struct timespec *tp), (clk_id, tp))
+ZCALL_STATS_WRAPPER(int, zrt_zcall_prolog_chdir, EZcallChdir, ret!=0, 0,
+		    (const char *path), (path))
+
+/*nonsyscalls return -1 on error*/
+ZCALL_STATS_WRAPPER(int, zrt_zcall_link, EZcallLink, ret<0, 0,
+		    (const char *oldpath, const char *newpath), (oldpath, newpath))
+ZCALL_STATS_WRAPPER(int, zrt_zcall_unlink, EZcallUnlink, ret<0, 0,
+		    (const char *pathname), (pathname))
+ZCALL_STATS_WRAPPER(int, zrt_zcall_rmdir, EZcallRmdir, ret<0, 0,
+		    (const char *pathdir), (pathdir))
+ZCALL_STATS_WRAPPER(int, zrt_zcall_mkdir, EZcallMkdir, ret<0, 0,
+		    (const char *pathdir, mode_t mode), (pathdir, mode))
+ZCALL_STATS_WRAPPER(int, zrt_zcall_chmod, EZcallChmod, ret<0, 0,
+		    (const char *path, mode_t mode), (path, mode))
+ZCALL_STATS_WRAPPER(int, zrt_zcall_fchmod, EZcallFchmod, ret<0, 0,
+		    (int fd, mode_t mode), (fd, mode))
+ZCALL_STATS_WRAPPER(int, zrt_zcall_chown, EZcallChown, ret<0, 0,
+		    (const char *path, uid_t owner, gid_t group), (path, owner, group))
+ZCALL_STATS_WRAPPER(int, zrt_zcall_fchown, EZcallFchown, ret<0, 0,
+		    (int fd, uid_t owner, gid_t group), (fd, owner, group))
+ZCALL_STATS_WRAPPER(int, zrt_zcall_ftruncate, EZcallFtruncate, ret<0, 0,
+		    (int fd, off_t length), (fd, length))
+ZCALL_STATS_WRAPPER(int, zrt_zcall_stat_realpath, EZcallStatRealpath, ret<0, 0,
+		    (const char *abspathname, struct stat *st), (abspathname, st))
+ZCALL_STATS_WRAPPER(int, zrt_zcall_get_phys_pages, EZcallGetPhysPages, ret<0, 0,
+		    (void), ())
+ZCALL_STATS_WRAPPER(int, zrt_zcall_get_avphys_pages, EZcallGetAvphysPages, ret<0, 0,
+		    (void), ())
+ZCALL_STATS_WRAPPER(ssize_t, zrt_zcall_readv, EZcallReadv, ret<0, ret>0 ? ret : 0,
+		    (int fd, const struct iovec *iov, int iovcnt), (fd, iov, iovcnt))
+ZCALL_STATS_WRAPPER(ssize_t, zrt_zcall_writev, EZcallWritev, ret<0, ret>0 ? ret : 0,
+		    (int fd, const struct iovec *iov, int iovcnt), (fd, iov, iovcnt))
+ZCALL_STATS_WRAPPER(ssize_t, zrt_zcall_preadv, EZcallPreadv, ret<0, ret>0 ? ret : 0,
+		    (int fd, const struct iovec *iov, int iovcnt, off_t offset), 
+		    (fd, iov, iovcnt, offset))
+ZCALL_STATS_WRAPPER(ssize_t, zrt_zcall_pwritev, EZcallPwritev, ret<0, ret>0 ? ret : 0,
+		    (int fd, const struct iovec *iov, int iovcnt, off_t offset), 
+		    (fd, iov, iovcnt, offset))
+ZCALL_STATS_WRAPPER(ssize_t, zrt_zcall_sendfile, EZcallSendfile, ret<0, ret>0 ? ret : 0,
+		    (int out_fd, int in_fd, off_t *offset, size_t count), 
+		    (out_fd, in_fd, offset, count))
+ZCALL_STATS_WRAPPER(ssize_t, zrt_zcall_copy_file_range, EZcallCopyFileRange, ret<0, 
+		    ret>0 ? ret : 0,
+		    (int fd_in, off_t *off_in, int fd_out, off_t *off_out, 
+		     size_t len, unsigned int flags), 
+		    (fd_in, off_in, fd_out, off_out, len, flags))
+ZCALL_STATS_WRAPPER(int, zrt_zcall_fadvise, EZcallFadvise, ret<0, 0,
+		    (int fd, off_t offset, off_t len, int advice), (fd, offset, len, advice))
+ZCALL_STATS_WRAPPER(int, zrt_zcall_mremap, EZcallMremap, ret<0, 0,
+		    (void **addr, size_t old_size, size_t new_size, int flags), 
+		    (addr, old_size, new_size, flags))
+
+/*fcntl has single optional arg, it's read only for commands having
+ *it, the same way as zrt_zcall_fcntl does*/
+static int zrt_zcall_fcntl_stats(int fd, int cmd, ...){
+    int ret;
+    va_list args;
+    va_start(args, cmd);
+    ZCALL_STATS_START;
+    if ( cmd == F_SETLK || cmd == F_SETLKW || cmd == F_GETLK )
+	ret = zrt_zcall_fcntl(fd, cmd, va_arg(args, struct flock*));
+    else if ( cmd == F_SETFL )
+	ret = zrt_zcall_fcntl(fd, cmd, va_arg(args, long));
+    else
+	ret = zrt_zcall_fcntl(fd, cmd);
+    ZCALL_STATS_FINISH(EZcallFcntl, ret<0, 0);
+    va_end(args);
+    return ret;
+}
 
 static struct zcalls_init_t KZcalls_init = {
     zrt_zcall_prolog_init,
     zrt_zcall_prolog_exit,
-    zrt_zcall_prolog_gettod,
-    zrt_zcall_prolog_clock,
-    zrt_zcall_prolog_nanosleep,
-    zrt_zcall_prolog_sched_yield,
-    zrt_zcall_prolog_sysconf,
-
-    zrt_zcall_prolog_close,
-    zrt_zcall_prolog_dup,
-    zrt_zcall_prolog_dup2,
-    zrt_zcall_prolog_read,
-    zrt_zcall_prolog_write,
-    zrt_zcall_prolog_seek,
-    zrt_zcall_prolog_fstat,
-    zrt_zcall_prolog_getdents,
-
-    zrt_zcall_prolog_open,
-    zrt_zcall_prolog_stat,
-
-    zrt_zcall_prolog_sysbrk,
-    zrt_zcall_prolog_mmap,
-    zrt_zcall_prolog_munmap,
+    zrt_zcall_prolog_gettod_stats,
+    zrt_zcall_prolog_clock_stats,
+    zrt_zcall_prolog_nanosleep_stats,
+    zrt_zcall_prolog_sched_yield_stats,
+    zrt_zcall_prolog_sysconf_stats,
+
+    zrt_zcall_prolog_close_stats,
+    zrt_zcall_prolog_dup_stats,
+    zrt_zcall_prolog_dup2_stats,
+    zrt_zcall_prolog_read_stats,
+    zrt_zcall_prolog_write_stats,
+    zrt_zcall_prolog_seek_stats,
+    zrt_zcall_prolog_fstat_stats,
+    zrt_zcall_prolog_getdents_stats,
+
+    zrt_zcall_prolog_open_stats,
+    zrt_zcall_prolog_stat_stats,
+
+    zrt_zcall_prolog_sysbrk_stats,
+    zrt_zcall_prolog_mmap_stats,
+    zrt_zcall_prolog_munmap_stats,
 
     zrt_zcall_prolog_dyncode_create,
     zrt_zcall_prolog_dyncode_modify,
@@ -78,10 +209,10 @@ static struct zcalls_init_t KZcalls_init = {
 
     zrt_zcall_prolog_open_resource,
 
-    zrt_zcall_prolog_getres,
-    zrt_zcall_prolog_gettime,
+    zrt_zcall_prolog_getres_stats,
+    zrt_zcall_prolog_gettime_stats,
 
-    zrt_zcall_prolog_chdir
+    zrt_zcall_prolog_chdir_stats
 };
 
 static struct zcalls_zrt_t KZcalls_zrt = {
@@ -95,19 +226,27 @@ static struct zcalls_env_args_init_t KZcalls_env_args_init = {
 };
 
 static struct zcalls_nonsyscalls_t KZcalls_nonsyscalls = {
-    zrt_zcall_fcntl,
-    zrt_zcall_link,
-    zrt_zcall_unlink,
-    zrt_zcall_rmdir,
-    zrt_zcall_mkdir,
-    zrt_zcall_chmod,
-    zrt_zcall_fchmod,
-    zrt_zcall_chown,
-    zrt_zcall_fchown,
-    zrt_zcall_ftruncate,
-    zrt_zcall_stat_realpath,
-    zrt_zcall_get_phys_pages,
-    zrt_zcall_get_avphys_pages
+    zrt_zcall_fcntl_stats,
+    zrt_zcall_link_stats,
+    zrt_zcall_unlink_stats,
+    zrt_zcall_rmdir_stats,
+    zrt_zcall_mkdir_stats,
+    zrt_zcall_chmod_stats,
+    zrt_zcall_fchmod_stats,
+    zrt_zcall_chown_stats,
+    zrt_zcall_fchown_stats,
+    zrt_zcall_ftruncate_stats,
+    zrt_zcall_stat_realpath_stats,
+    zrt_zcall_get_phys_pages_stats,
+    zrt_zcall_get_avphys_pages_stats,
+    zrt_zcall_readv_stats,
+    zrt_zcall_writev_stats,
+    zrt_zcall_preadv_stats,
+    zrt_zcall_pwritev_stats,
+    zrt_zcall_sendfile_stats,
+    zrt_zcall_copy_file_range_stats,
+    zrt_zcall_fadvise_stats,
+    zrt_zcall_mremap_stats
 };
 #endif //ZLIBC_STUB
 
@@ -32,6 +32,7 @@ struct dirent;
 struct timeval;
 struct timespec;
 struct NvramLoader;
+struct iovec;
 
 
 #define ZCALLS_INIT 1   /*use as type param in __query_zcalls*/
@@ -116,6 +117,15 @@ struct zcalls_nonsyscalls_t{
     int  (*stat_realpath) (const char *abspathname, struct stat *stat);
     int (*get_phys_pages)(void);
     int (*get_avphys_pages)(void);
+    ssize_t (*readv)(int fd, const struct iovec *iov, int iovcnt);
+    ssize_t (*writev)(int fd, const struct iovec *iov, int iovcnt);
+    ssize_t (*preadv)(int fd, const struct iovec *iov, int iovcnt, off_t offset);
+    ssize_t (*pwritev)(int fd, const struct iovec *iov, int iovcnt, off_t offset);
+    ssize_t (*sendfile)(int out_fd, int in_fd, off_t *offset, size_t count);
+    ssize_t (*copy_file_range)(int fd_in, off_t *off_in, int fd_out, off_t *off_out,
+			       size_t len, unsigned int flags);
+    int (*fadvise)(int fd, off_t offset, off_t len, int advice);
+    int (*mremap)(void **addr, size_t old_size, size_t new_size, int flags);
 };
 
 #define ZCALLS_ENV_ARGS_INIT 4         /*use as type param in __query_zcalls*/
@@ -19,9 +19,25 @@
 #ifndef __ZRT_API_H__
 #define __ZRT_API_H__
 
+#include <stdint.h>
+
 /*call zvm_fork() and then reread nvram file and remount removable tar images
  *@return zvm_fork result*/
 int zfork();
 
+/*Trace spans and counters, recorded in memory and written at exit as
+ *Chrome trace event JSON into channel set by nvram [debug] trace key;
+ *calls do nothing if tracing is not enabled. Names are not copied and
+ *must stay valid until exit, string literals are fine.
+ *Spans can be nested, every zrt_trace_begin must be paired with
+ *zrt_trace_end in the same order.*/
+void zrt_trace_begin(const char* name);
+void zrt_trace_end(const char* name);
+void zrt_trace_counter(const char* name, int64_t value);
+
+/*write recorded trace events now instead of at exit and stop tracing
+ *@return 0 if OK or tracing is not enabled, -1 if can't be written*/
+int zrt_trace_write();
+
 
 #endif //__ZRT_API_H__
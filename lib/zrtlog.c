@@ -18,10 +18,14 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <stdarg.h>
+#include <stddef.h> //ptrdiff_t
 #include <assert.h>
 
 #include "zvm.h"
 #include "zrtlog.h"
+#include "zrtlog_binary.h"
+#include "ticks.h" /*cpu_ticks*/
 
 #ifdef DEBUG
 #define MAX_NESTED_SYSCALLS_LOG 5
@@ -35,6 +39,17 @@ static char s_logbuf[LOG_BUFFER_SIZE];
 
 static char s_nested_syscalls_str[MAX_NESTED_SYSCALL_LEN] = "\0";
 
+/*binary log, see zrtlog_binary.h; buffer starts with chunk header*/
+#define LOG_BINARY_BUFFER_SIZE 0x40000
+static int  s_log_binary_enabled;
+static int  s_log_binary_sites_count;
+static int  s_log_binary_len = sizeof(struct LogBinaryChunkHeader);
+static char s_log_binary_buf[LOG_BINARY_BUFFER_SIZE];
+/*site is defined once per log, sites with bigger ids are defined on
+ *every use*/
+#define LOG_BINARY_MAX_DEFINED_SITES 0x1000
+static uint8_t s_log_binary_site_defined[LOG_BINARY_MAX_DEFINED_SITES/8];
+
 /*it's accessing from zrtlogbase.h*/
 LOG_BASE_ENABLE;
 
@@ -121,6 +136,9 @@ void __zrt_log_pop_name( const char* expected_name ) {
 }
 
 int32_t __zrt_log_write( int handle, const char* buf, int32_t size, int64_t offset){
+    /*keep order of text and binary records*/
+    if ( s_log_binary_len > sizeof(struct LogBinaryChunkHeader) ) 
+	__zrt_log_binary_flush();
     if ( s_log_prolog_mode_enabled ){ 
 	if ( s_buffered_len ){
 	    /*write to log buffer, that is using internally by tfp_printf*/
@@ -139,4 +157,178 @@ int __zrt_log_debug_get_buf(char **buf){
     return __zrt_log_fd();
 }
 
+void __zrt_log_binary_enable(int status){
+    s_log_binary_enabled = status;
+}
+
+int __zrt_log_binary_is_enabled(){
+    return s_log_binary_enabled;
+}
+
+void __zrt_log_binary_flush(){
+    struct LogBinaryChunkHeader* header = (struct LogBinaryChunkHeader*)s_log_binary_buf;
+    if ( s_log_binary_len == sizeof(struct LogBinaryChunkHeader) ) return;
+    header->magic = LOG_BINARY_MAGIC;
+    header->length = s_log_binary_len - sizeof(struct LogBinaryChunkHeader);
+    zvm_pwrite(__zrt_log_fd(), s_log_binary_buf, s_log_binary_len, 0);
+    s_log_binary_len = sizeof(struct LogBinaryChunkHeader);
+}
+
+void __zrt_log_binary_sites_reset(){
+    memset(s_log_binary_site_defined, '\0', sizeof(s_log_binary_site_defined));
+}
+
+/*@return 1 if site was defined and then marks it as defined*/
+static int log_binary_site_defined(int site){
+    int defined;
+    if ( site >= LOG_BINARY_MAX_DEFINED_SITES ) return 0;
+    defined = s_log_binary_site_defined[site/8] & (1 << site%8);
+    s_log_binary_site_defined[site/8] |= 1 << site%8;
+    return defined != 0;
+}
+
+/*@return new length or -1 if no space*/
+static int log_binary_put_int(char* args, int len, uint64_t value){
+    if ( len < 0 || len + sizeof(value) > LOG_BINARY_MAX_ARGS ) return -1;
+    memcpy(args+len, &value, sizeof(value));
+    return len + sizeof(value);
+}
+
+/*string is truncated to fit into maxlen and record*/
+static int log_binary_put_string(char* args, int len, const char* str, int maxlen){
+    uint16_t slen;
+    if ( len < 0 || len + sizeof(slen) > LOG_BINARY_MAX_ARGS ) return -1;
+    if ( str == NULL ){
+	slen = LOG_BINARY_NULL_STRING;
+    }
+    else{
+	slen = strnlen(str, maxlen);
+	if ( len + sizeof(slen) + slen > LOG_BINARY_MAX_ARGS )
+	    slen = LOG_BINARY_MAX_ARGS - len - sizeof(slen);
+    }
+    memcpy(args+len, &slen, sizeof(slen));
+    len += sizeof(slen);
+    if ( str != NULL ){
+	memcpy(args+len, str, slen);
+	len += slen;
+    }
+    return len;
+}
+
+/*pick args by conversions of format without formatting them
+ *@return length of encoded args*/
+static int log_binary_encode_args(char* args, const char* fmt, va_list args_list){
+    struct LogFmtSpec spec;
+    int offset=0, len=0, i, prev_len;
+    int precision;
+    while ( log_binary_next_spec(fmt, offset, &spec) ){
+	offset = spec.offset + spec.length;
+	precision = spec.precision;
+	/*length of args of previous conversions*/
+	prev_len = len;
+	for ( i=0; i < spec.stars; i++ ){
+	    precision = va_arg(args_list, int);
+	    len = log_binary_put_int(args, len, (int64_t)precision);
+	}
+	switch ( spec.type ){
+	case ELogArgInt:{
+	    int64_t value;
+	    switch ( spec.size ){
+	    case ELogSizeChar: value = (signed char)va_arg(args_list, int); break;
+	    case ELogSizeShort: value = (short)va_arg(args_list, int); break;
+	    case ELogSizeLong: value = va_arg(args_list, long); break;
+	    case ELogSizeLongLong: value = va_arg(args_list, long long); break;
+	    case ELogSizeIntmax: value = va_arg(args_list, intmax_t); break;
+	    case ELogSizeSizeT: value = va_arg(args_list, ssize_t); break;
+	    case ELogSizePtrdiff: value = va_arg(args_list, ptrdiff_t); break;
+	    default: value = va_arg(args_list, int); break;
+	    }
+	    len = log_binary_put_int(args, len, value);
+	    break;
+	}
+	case ELogArgUint:{
+	    uint64_t value;
+	    switch ( spec.size ){
+	    case ELogSizeChar: value = (unsigned char)va_arg(args_list, unsigned); break;
+	    case ELogSizeShort: value = (unsigned short)va_arg(args_list, unsigned); break;
+	    case ELogSizeLong: value = va_arg(args_list, unsigned long); break;
+	    case ELogSizeLongLong: value = va_arg(args_list, unsigned long long); break;
+	    case ELogSizeIntmax: value = va_arg(args_list, uintmax_t); break;
+	    case ELogSizeSizeT: value = va_arg(args_list, size_t); break;
+	    case ELogSizePtrdiff: value = va_arg(args_list, ptrdiff_t); break;
+	    default: value = va_arg(args_list, unsigned); break;
+	    }
+	    len = log_binary_put_int(args, len, value);
+	    break;
+	}
+	case ELogArgDouble:{
+	    double value = spec.size == ELogSizeLongDouble ? 
+		(double)va_arg(args_list, long double) : va_arg(args_list, double);
+	    uint64_t raw;
+	    memcpy(&raw, &value, sizeof(raw));
+	    len = log_binary_put_int(args, len, raw);
+	    break;
+	}
+	case ELogArgChar:
+	    len = log_binary_put_int(args, len, (unsigned char)va_arg(args_list, int));
+	    break;
+	case ELogArgPtr:
+	    len = log_binary_put_int(args, len, (uintptr_t)va_arg(args_list, void*));
+	    break;
+	case ELogArgStr:
+	    len = log_binary_put_string(args, len, va_arg(args_list, const char*), 
+					precision >= 0 && precision < LOG_BINARY_MAX_STRING ? 
+					precision : LOG_BINARY_MAX_STRING);
+	    break;
+	case ELogArgCount:
+	    /*nothing is written by binary log, arg is not recorded*/
+	    (void)va_arg(args_list, void*);
+	    break;
+	default:
+	    break;
+	}
+	/*args not fitting into record are lost, decoder shows them as missing*/
+	if ( len < 0 ) return prev_len;
+    }
+    return len;
+}
+
+static void log_binary_append(uint32_t site, const char* args, int len){
+    struct LogBinaryRecord record;
+    if ( s_log_binary_len + sizeof(record) + len > LOG_BINARY_BUFFER_SIZE )
+	__zrt_log_binary_flush();
+    record.site = site;
+    record.length = len;
+    record.ticks = cpu_ticks();
+    memcpy(s_log_binary_buf+s_log_binary_len, &record, sizeof(record));
+    memcpy(s_log_binary_buf+s_log_binary_len+sizeof(record), args, len);
+    s_log_binary_len += sizeof(record) + len;
+}
+
+void __zrt_log_binary_record(int* site, int verbosity, const char* level, 
+			     const char* file, int line, const char* fmt, ...){
+    char args[LOG_BINARY_MAX_ARGS];
+    int len;
+    va_list args_list;
+    if ( *site == 0 ){
+	*site = ++s_log_binary_sites_count;
+    }
+    if ( !log_binary_site_defined(*site) ){
+	/*first use of log site, describe it*/
+	len = log_binary_put_int(args, 0, *site);
+	len = log_binary_put_int(args, len, line);
+	len = log_binary_put_string(args, len, level, LOG_BINARY_MAX_STRING);
+	len = log_binary_put_string(args, len, file, LOG_BINARY_MAX_STRING);
+	len = log_binary_put_string(args, len, fmt, LOG_BINARY_MAX_ARGS);
+	log_binary_append(LOG_BINARY_SITE_DEFINITION, args, len);
+    }
+    va_start(args_list, fmt);
+    len = log_binary_encode_args(args, fmt, args_list);
+    va_end(args_list);
+    log_binary_append(*site, args, len);
+    /*errors are written immediately, it's can be last record before crash*/
+    if ( verbosity <= L_ERROR ) 
+	__zrt_log_binary_flush();
+}
+
 #endif
@@ -43,8 +43,20 @@
 #define P_UINT  "%u"
 #define P_LONGINT  "%lld"
 
-#define LOG_FUNCTION_STACK_NAMES
-//#undef  LOG_FUNCTION_STACK_NAMES
+/* Release build is made with -DZRT_RELEASE (make RELEASE=1): log
+ * messages with verbosity greater than ZRT_LOG_MAX_VERBOSITY are
+ * compiled out and stack of nested syscall names isn't maintained.
+ * ZRT_LOG_MAX_VERBOSITY can be also set explicitly for any build.*/
+#ifdef ZRT_RELEASE
+#  ifndef ZRT_LOG_MAX_VERBOSITY
+#    define ZRT_LOG_MAX_VERBOSITY L_BASE
+#  endif
+#else
+#  define LOG_FUNCTION_STACK_NAMES
+#  ifndef ZRT_LOG_MAX_VERBOSITY
+#    define ZRT_LOG_MAX_VERBOSITY L_EXTRA
+#  endif
+#endif
 
 #ifndef DEBUG
 #define DEBUG
@@ -62,7 +74,8 @@
 /*ZRT_LOG
   v_123 verbosity param, fmt_123 format string, ... arguments*/
 #define ZRT_LOG(v_123, fmt_123, ...)					\
-    if ( __zrt_log_is_enabled() && __zrt_log_fd() > 0 ){		\
+    if ( (v_123) <= ZRT_LOG_MAX_VERBOSITY &&				\
+	 __zrt_log_is_enabled() && __zrt_log_fd() > 0 ){		\
 	if ( __zrt_log_prolog_mode_is_enabled() ){			\
 	    if ( DEFAULT_VERBOSITY_FOR_PROLOG_LOG >= v_123 ){		\
 		/*write directly into channel always if logfile defined*/ \
@@ -72,6 +85,13 @@
 		__zrt_log_write(__zrt_log_fd(), NULL, 0, 0);		\
 	    }								\
 	}								\
+	else if ( __zrt_log_binary_is_enabled() ){			\
+	    /*id of log site assigned at first use*/			\
+	    static int site_123;					\
+	    if( __zrt_log_verbosity() >= v_123 )			\
+		__zrt_log_binary_record(&site_123, v_123, #v_123,	\
+					__FILE__, __LINE__, fmt_123, __VA_ARGS__); \
+	}								\
 	else{								\
 	    int debug_handle_123;					\
 	    char *buf__123;						\
@@ -87,7 +107,7 @@
     }									\
 
 
-#define ZRT_LOG_DELIMETER  if( __zrt_log_is_enabled() ){ 		\
+#define ZRT_LOG_DELIMETER  if( L_SHORT <= ZRT_LOG_MAX_VERBOSITY && __zrt_log_is_enabled() ){ \
 	char *buf__123;							\
 	int debug_handle = __zrt_log_debug_get_buf(&buf__123);		\
 	int len;							\
@@ -100,10 +120,18 @@
 /* ******************************************************************************
  * Syscallbacks debug macros*/
 
+#ifdef LOG_FUNCTION_STACK_NAMES
+#define LOG_PUSH_NAME(name_123) __zrt_log_push_name(name_123)
+#define LOG_POP_NAME(name_123)  __zrt_log_pop_name(name_123)
+#else
+#define LOG_PUSH_NAME(name_123)
+#define LOG_POP_NAME(name_123)
+#endif
+
 /* Push current NACL syscall into logging stack that printing for every log invocation.
  * Enable logging for NACL syscall, and printing arguments*/
 #define LOG_SYSCALL_START(fmt_123, ...) {	\
-	__zrt_log_push_name(__func__);		\
+	LOG_PUSH_NAME(__func__);		\
 	ZRT_LOG(L_INFO, fmt_123, __VA_ARGS__);	\
     }
 
@@ -116,7 +144,7 @@
 	    ZRT_LOG(L_SHORT, "ret=0x%x " fmt_123 "",		\
 		    (int)ret, __VA_ARGS__);			\
 	}							\
-        __zrt_log_pop_name(__func__);				\
+        LOG_POP_NAME(__func__);					\
     }
 
 
@@ -131,7 +159,23 @@
 	    ZRT_LOG(L_INFO, "ret=0x%x " fmt_123 "",		\
 		    (int)ret, __VA_ARGS__);			\
 	}							\
-        __zrt_log_pop_name(__func__);				\
+        LOG_POP_NAME(__func__);					\
+    }
+
+
+/* Disable logging while writing to stdout and stderr channel, log
+ * messages would be mixed with user data otherwise.
+ * log_state_p gets previous log state for RESTORE_LOG_STATE*/
+#define DISABLE_LOG_FOR_STD_HANDLES(fd, log_state_p){		\
+	*(log_state_p) = __zrt_log_is_enabled();		\
+	if ( (fd) <= 2 && *(log_state_p) ){			\
+	    __zrt_log_enable(0);				\
+	}							\
+    }
+
+#define RESTORE_LOG_STATE(log_state){				\
+	if ( log_state )					\
+	    __zrt_log_enable(log_state);			\
     }
 
 
@@ -171,6 +215,20 @@ int  __zrt_log_prolog_mode_is_enabled();
 int __zrt_log_debug_get_buf(char **buf);
 int32_t __zrt_log_write( int handle, const char* buf, int32_t size, int64_t offset);
 
+/* 1 switch on binary log, messages are not formatted but recorded into
+ * memory buffer and written into log by big chunks, see zrtlog_binary.h
+ * 0 switch off binary log*/
+void __zrt_log_binary_enable(int status);
+int  __zrt_log_binary_is_enabled();
+/*record log message, site points to static id of log site*/
+void __zrt_log_binary_record(int* site, int verbosity, const char* level, 
+			     const char* file, int line, const char* fmt, ...);
+/*write buffered binary records into log*/
+void __zrt_log_binary_flush();
+/*forked session writes into another log, so sites must be described
+ *there again*/
+void __zrt_log_binary_sites_reset();
+
 #else
 #define LOG_SYSCALL_START(fmt_123, ...)
 #define LOG_SYSCALL_FINISH()
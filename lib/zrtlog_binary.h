@@ -0,0 +1,140 @@
+/*
+ *
+ * Copyright (c) 2013, LiteStack, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ZRTLOG_BINARY_H_
+#define ZRTLOG_BINARY_H_
+
+/* Binary log format, it's shared by zrt and host side decoder
+ * tools/zrtlog_decode.c, so only standard headers can be used here.
+ *
+ * In binary mode ZRT_LOG doesn't format message, it's recording log
+ * site id, cpu ticks and raw arguments into memory buffer, that is
+ * written into debug channel by big chunks. Every chunk starts with
+ * LogBinaryChunkHeader and contains records: LogBinaryRecord followed
+ * by length bytes of arguments. Site is described by record with site
+ * LOG_BINARY_SITE_DEFINITION before first use. Text written into debug
+ * channel before binary mode switched on (prolog) is left between
+ * chunks as is.
+ *
+ * Arguments are encoded in order of format conversions: integers,
+ * pointers and '*' width/precision as 8 bytes; doubles as 8 bytes
+ * double; strings as uint16 length and bytes without terminating zero,
+ * NULL string has length LOG_BINARY_NULL_STRING. Little endian.
+ * Site definition arguments are: site, line, level name, file name,
+ * format string.*/
+
+#include <stdint.h>
+
+#define LOG_BINARY_MAGIC 0x474c425aU /*"ZBLG" in little endian*/
+#define LOG_BINARY_SITE_DEFINITION 0
+#define LOG_BINARY_NULL_STRING 0xFFFF
+#define LOG_BINARY_MAX_STRING  256  /*longer string args are truncated*/
+#define LOG_BINARY_MAX_ARGS    1024 /*max arguments bytes of single record*/
+
+struct LogBinaryChunkHeader{
+    uint32_t magic;
+    uint32_t length;  /*bytes of records following header*/
+};
+
+struct LogBinaryRecord{
+    uint32_t site;
+    uint32_t length;  /*bytes of arguments following record*/
+    uint64_t ticks;
+};
+
+/*argument types*/
+enum { ELogArgNone=0, /*"%%"*/
+       ELogArgInt, ELogArgUint, ELogArgDouble, ELogArgPtr, ELogArgChar, ELogArgStr,
+       ELogArgCount /*"%n"*/ };
+
+/*length modifiers*/
+enum { ELogSizeDefault=0, ELogSizeChar, ELogSizeShort, ELogSizeLong, ELogSizeLongLong,
+       ELogSizeIntmax, ELogSizeSizeT, ELogSizePtrdiff, ELogSizeLongDouble };
+
+/*single conversion of format string*/
+struct LogFmtSpec{
+    int offset;     /*offset of '%' in format*/
+    int length;     /*length of conversion including '%'*/
+    int stars;      /*count of '*' width/precision args preceding value*/
+    int precision;  /*-1 if not set, -2 if taken from '*' arg*/
+    int size;       /*length modifier*/
+    int type;       /*argument type*/
+    char conv;      /*conversion character*/
+};
+
+/*Find next conversion in format string starting at offset
+ *@return 1 if found and spec filled, 0 if end of format reached*/
+static inline int log_binary_next_spec(const char* fmt, int offset, struct LogFmtSpec* spec){
+    const char* p;
+    const char* s = fmt+offset;
+    while ( *s && *s != '%' ) ++s;
+    if ( !*s ) return 0;
+    p = s+1;
+    spec->offset = s - fmt;
+    spec->stars = 0;
+    spec->precision = -1;
+    spec->size = ELogSizeDefault;
+    /*flags and width*/
+    while ( *p == '-' || *p == '+' || *p == ' ' || *p == '#' || *p == '0' ) ++p;
+    if ( *p == '*' ){ ++spec->stars; ++p; }
+    while ( *p >= '0' && *p <= '9' ) ++p;
+    /*precision*/
+    if ( *p == '.' ){
+	++p;
+	if ( *p == '*' ){ ++spec->stars; spec->precision = -2; ++p; }
+	else{
+	    spec->precision = 0;
+	    while ( *p >= '0' && *p <= '9' ) spec->precision = spec->precision*10 + (*p++ - '0');
+	}
+    }
+    /*length modifier*/
+    switch ( *p ){
+    case 'h': ++p;
+	if ( *p == 'h' ){ spec->size = ELogSizeChar; ++p; } else spec->size = ELogSizeShort;
+	break;
+    case 'l': ++p;
+	if ( *p == 'l' ){ spec->size = ELogSizeLongLong; ++p; } else spec->size = ELogSizeLong;
+	break;
+    case 'q': ++p; spec->size = ELogSizeLongLong; break;
+    case 'j': ++p; spec->size = ELogSizeIntmax; break;
+    case 'z': ++p; spec->size = ELogSizeSizeT; break;
+    case 't': ++p; spec->size = ELogSizePtrdiff; break;
+    case 'L': ++p; spec->size = ELogSizeLongDouble; break;
+    default: break;
+    }
+    spec->conv = *p;
+    switch ( *p ){
+    case 'd': case 'i': spec->type = ELogArgInt; break;
+    case 'u': case 'x': case 'X': case 'o': spec->type = ELogArgUint; break;
+    case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+	spec->type = ELogArgDouble; break;
+    case 'p': spec->type = ELogArgPtr; break;
+    case 'c': spec->type = ELogArgChar; break;
+    case 's': spec->type = ELogArgStr; break;
+    case 'n': spec->type = ELogArgCount; break;
+    case '%': spec->type = ELogArgNone; break;
+    default:
+	/*unknown conversion or end of string, treat it as text*/
+	spec->type = ELogArgNone;
+	spec->length = p - s;
+	return 1;
+    }
+    spec->length = p+1 - s;
+    return 1;
+}
+
+#endif /* ZRTLOG_BINARY_H_ */
@@ -32,7 +32,7 @@ extern int   s_log_items_count;
     int s_log_items_count = 0
 
 #define LOG_DEBUG(item_id, value, comment)				\
-    if( __zrt_log_is_enabled() ){					\
+    if( L_EXTRA <= ZRT_LOG_MAX_VERBOSITY && __zrt_log_is_enabled() ){	\
 	char *buf__123;							\
 	int debug_handle = __zrt_log_debug_get_buf(&buf__123);		\
 	int len;							\
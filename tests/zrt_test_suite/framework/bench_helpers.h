@@ -0,0 +1,95 @@
+/*
+ * Helpers shared by autotests and benchmarks
+ *
+ * Copyright (c) 2013, LiteStack, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef __BENCH_HELPERS_H__
+#define __BENCH_HELPERS_H__
+
+#include <stdint.h>
+#include <stddef.h> //offsetof
+#include <stdlib.h> //rand
+#include <string.h>
+#include <assert.h>
+#include <alloca.h>
+
+/*cpu ticks, benchmarks can't use zrt time because it's synthetic*/
+#if defined(__x86_64__) || defined(__i386__)
+static inline uint64_t ticks(){
+    uint32_t lo, hi;
+    __asm__ __volatile__ ("rdtsc" : "=a"(lo), "=d"(hi));
+    return ((uint64_t)hi << 32) | lo;
+}
+#else
+static inline uint64_t ticks(){ return 0; }
+#endif
+
+/*map-reduce items helpers, available if buffer.h is included before*/
+#ifdef __BUFFER_H_
+
+#include "elastic_mr_item.h"
+
+/*size of item with hash of given size, aligned by 8 bytes*/
+#define HASHED_ITEM_SIZE(hash_size)					\
+    ((offsetof(ElasticBufItemData, key_hash)+(hash_size)+7) & ~7)
+
+/*alloc buffer and fill it by items with random hashes, value is an
+ *item number
+ *@param distinct_bytes values of every hash byte are in [0, distinct_bytes)*/
+static inline void
+FillBufferRandomHashes(Buffer* buf, int hash_size, int count, int distinct_bytes){
+    ElasticBufItemData* item = alloca( HASHED_ITEM_SIZE(hash_size) );
+    int ret, i, j;
+    ret = AllocBuffer( buf, HASHED_ITEM_SIZE(hash_size), count );
+    assert(!ret);
+    for ( i=0; i < count; i++ ){
+	memset( item, '\0', HASHED_ITEM_SIZE(hash_size) );
+	item->value.addr = i;
+	for ( j=0; j < hash_size; j++ ){
+	    (&item->key_hash)[j] = rand() % distinct_bytes;
+	}
+	AddBufferItem( buf, item );
+    }
+}
+
+/*add to existing buffer items having 4 bytes hashes in [0, distinct),
+ *value is an item number*/
+static inline void
+AddBufferItemsHash32(Buffer* buf, int count, int distinct){
+    ElasticBufItemData* item = alloca( buf->header.item_size );
+    uint32_t hash;
+    int i;
+    for ( i=0; i < count; i++ ){
+	memset( item, '\0', buf->header.item_size );
+	hash = rand() % distinct;
+	memcpy( &item->key_hash, &hash, sizeof(hash) );
+	item->value.addr = i;
+	AddBufferItem( buf, item );
+    }
+}
+
+/*4 bytes hash of item, it is not aligned*/
+static inline uint32_t
+ItemHash32( const ElasticBufItemData *item ){
+    uint32_t hash;
+    memcpy( &hash, &item->key_hash, sizeof(hash) );
+    return hash;
+}
+
+#endif //__BUFFER_H_
+
+#endif //__BENCH_HELPERS_H__
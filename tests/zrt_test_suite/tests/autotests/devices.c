@@ -18,14 +18,17 @@
 
 
 #include <unistd.h>
+#include <string.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <stdio.h>
 #include <fcntl.h>
 #include <error.h>
 #include <errno.h>
+#include <sys/mman.h>
 
 #include "macro_tests.h"
+#include "helpers/random_generator.h"
 
 #define SEQUENTIAL_CHANNEL S_IFIFO
 
@@ -34,14 +37,23 @@ void test_writeonly_channel(const char* name);
 
 void test_emu_devices_for_reading();
 void test_emu_devices_for_writing();
+void test_random_devices_sequence(const char* name);
+void test_random_generator_reseed();
+void test_zrtstat_device();
+void test_meminfo_device();
 
 #define BUFFER_LEN 0x1000
 char s_buffer[BUFFER_LEN];
 
 int main(int argc, char**argv){
     test_emu_devices_for_reading();
+    test_random_devices_sequence("/dev/random");
+    test_random_devices_sequence("/dev/urandom");
+    test_random_generator_reseed();
     test_readonly_channel(CHANNEL_NAME_READONLY);
     test_writeonly_channel(CHANNEL_NAME_WRITEONLY);
+    test_zrtstat_device();
+    test_meminfo_device();
     return 0;
 }
 
@@ -183,6 +195,146 @@ void test_emu_devices_for_reading(){
 			  &ret, ret != -1 );
 }
 
+/*consecutive reads must not repeat data*/
+void test_random_devices_sequence(const char* name){
+    int ret;
+    int fd;
+    char buf1[1000];
+    char buf2[1000];
+    fprintf(stderr, "testing random device %s\n", name);
+    TEST_OPERATION_RESULT(
+			  open(name, O_RDONLY), 
+			  &ret, ret != -1 );
+    fd = ret;
+    TEST_OPERATION_RESULT(
+			  read(fd, buf1, sizeof(buf1)), 
+			  &ret, ret == sizeof(buf1) );
+    TEST_OPERATION_RESULT(
+			  read(fd, buf2, sizeof(buf2)), 
+			  &ret, ret == sizeof(buf2) );
+    TEST_OPERATION_RESULT(
+			  memcmp(buf1, buf2, sizeof(buf1)), 
+			  &ret, ret != 0 );
+    /*odd sized read*/
+    TEST_OPERATION_RESULT(
+			  read(fd, buf1, 13), 
+			  &ret, ret == 13 );
+    TEST_OPERATION_RESULT(
+			  close(fd), 
+			  &ret, ret != -1 );
+}
+
+/*reseeding by session seed, as zfork does, must change output, while
+ *the same seed must reproduce it*/
+void test_random_generator_reseed(){
+    int ret;
+    struct RandomGenerator generator;
+    struct RandomGeneratorPublicInterface* random;
+    char buf1[1000];
+    char buf2[1000];
+    char buf3[1000];
+    fprintf(stderr, "testing reseed of random generator\n");
+    random = CONSTRUCT_L(RANDOM_GENERATOR)( 12345, &generator );
+    random->fill(random, buf1, sizeof(buf1));
+    random->seed(random, random_session_seed());
+    random->fill(random, buf2, sizeof(buf2));
+    TEST_OPERATION_RESULT(
+			  memcmp(buf1, buf2, sizeof(buf1)), 
+			  &ret, ret != 0 );
+    /*session seeds are unique even if taken one by one*/
+    random->seed(random, random_session_seed());
+    random->fill(random, buf3, sizeof(buf3));
+    TEST_OPERATION_RESULT(
+			  memcmp(buf2, buf3, sizeof(buf2)), 
+			  &ret, ret != 0 );
+    random->seed(random, 12345);
+    random->fill(random, buf3, sizeof(buf3));
+    TEST_OPERATION_RESULT(
+			  memcmp(buf1, buf3, sizeof(buf1)), 
+			  &ret, ret == 0 );
+}
+
+/*statistics report is not empty and contains mounts and used channels*/
+void test_zrtstat_device(){
+    int ret;
+    int fd;
+    fprintf(stderr, "testing statistics device %s\n", "/dev/zrtstat");
+    TEST_OPERATION_RESULT(
+			  open("/dev/zrtstat", O_WRONLY), 
+			  &ret, ret == -1 );
+    TEST_OPERATION_RESULT(
+			  open("/dev/zrtstat", O_RDONLY), 
+			  &ret, ret != -1 );
+    fd = ret;
+    TEST_OPERATION_RESULT(
+			  read(fd, s_buffer, BUFFER_LEN-1), 
+			  &ret, ret > 0 );
+    s_buffer[ret] = '\0';
+    TEST_OPERATION_RESULT(
+			  strstr(s_buffer, "mount channels read") != NULL, 
+			  &ret, ret == 1 );
+    TEST_OPERATION_RESULT(
+			  strstr(s_buffer, "mount memfs write") != NULL, 
+			  &ret, ret == 1 );
+    TEST_OPERATION_RESULT(
+			  strstr(s_buffer, "channel /dev/zero read") != NULL, 
+			  &ret, ret == 1 );
+    TEST_OPERATION_RESULT(
+			  close(fd), 
+			  &ret, ret != -1 );
+}
+
+/*memory report contains heap and memfs lines, available pages
+ *reflect mmap usage*/
+void test_meminfo_device(){
+    int ret;
+    int fd;
+    long int avphys_pages;
+    void* addr;
+    fprintf(stderr, "testing memory usage device %s\n", "/dev/meminfo");
+    TEST_OPERATION_RESULT(
+			  open("/dev/meminfo", O_WRONLY), 
+			  &ret, ret == -1 );
+    TEST_OPERATION_RESULT(
+			  open("/dev/meminfo", O_RDONLY), 
+			  &ret, ret != -1 );
+    fd = ret;
+    TEST_OPERATION_RESULT(
+			  read(fd, s_buffer, BUFFER_LEN-1), 
+			  &ret, ret > 0 );
+    s_buffer[ret] = '\0';
+    TEST_OPERATION_RESULT(
+			  strstr(s_buffer, "MemAvailable:") != NULL, 
+			  &ret, ret == 1 );
+    TEST_OPERATION_RESULT(
+			  strstr(s_buffer, "BrkUsed:") != NULL, 
+			  &ret, ret == 1 );
+    TEST_OPERATION_RESULT(
+			  strstr(s_buffer, "MmapUsed:") != NULL, 
+			  &ret, ret == 1 );
+    TEST_OPERATION_RESULT(
+			  strstr(s_buffer, "MemfsData:") != NULL, 
+			  &ret, ret == 1 );
+    TEST_OPERATION_RESULT(
+			  close(fd), 
+			  &ret, ret != -1 );
+
+    /*available pages are less than total and decreased by mapping*/
+    avphys_pages = sysconf(_SC_AVPHYS_PAGES);
+    TEST_OPERATION_RESULT(
+			  avphys_pages > 0 && avphys_pages < sysconf(_SC_PHYS_PAGES), 
+			  &ret, ret == 1 );
+    addr = mmap(NULL, 16*sysconf(_SC_PAGESIZE), PROT_READ|PROT_WRITE, 
+		MAP_ANONYMOUS|MAP_PRIVATE, -1, 0);
+    TEST_OPERATION_RESULT( addr != MAP_FAILED, &ret, ret == 1 );
+    TEST_OPERATION_RESULT(
+			  avphys_pages - sysconf(_SC_AVPHYS_PAGES) >= 16, 
+			  &ret, ret == 1 );
+    TEST_OPERATION_RESULT(
+			  munmap(addr, 16*sysconf(_SC_PAGESIZE)), 
+			  &ret, ret == 0 );
+}
+
 void test_readonly_channel(const char* name){
     int ret;
     int ret2;
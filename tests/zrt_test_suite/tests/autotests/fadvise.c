@@ -0,0 +1,86 @@
+/*
+ * posix_fadvise testing for memory filesystem and channels
+ *
+ * Copyright (c) 2013, LiteStack, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <string.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <error.h>
+#include <errno.h>
+
+#include "macro_tests.h"
+
+#define FILENAME "/fadvise_file"
+#define TEXT "data should stay unchanged after advice"
+
+void test_memfs_fadvise();
+void test_channels_fadvise();
+
+int main(int argc, char**argv){
+    test_memfs_fadvise();
+    test_channels_fadvise();
+    return 0;
+}
+
+void test_memfs_fadvise(){
+    int fd, ret, i;
+    char buf[sizeof(TEXT)];
+    TEST_OPERATION_RESULT( open(FILENAME, O_RDWR|O_CREAT, S_IRWXU), &fd, fd!=-1);
+    /*write by small pieces to get file capacity bigger than size*/
+    for ( i=0; i < sizeof(TEXT)-1; i++ ){
+	TEST_OPERATION_RESULT( write(fd, TEXT+i, 1), &ret, ret==1);
+    }
+    TEST_OPERATION_RESULT( posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL), &ret, ret==0);
+    TEST_OPERATION_RESULT( posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED), &ret, ret==0);
+    TEST_OPERATION_RESULT( posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED), &ret, ret==0);
+    TEST_OPERATION_RESULT( pread(fd, buf, sizeof(buf), 0), &ret, ret==sizeof(TEXT)-1);
+    CMP_MEM_DATA(buf, TEXT, sizeof(TEXT)-1);
+    /*file is still writable after memory release*/
+    TEST_OPERATION_RESULT( write(fd, TEXT, sizeof(TEXT)-1), &ret, ret==sizeof(TEXT)-1);
+    TEST_OPERATION_RESULT( pread(fd, buf, sizeof(buf), sizeof(TEXT)-1), &ret, ret==sizeof(TEXT)-1);
+    CMP_MEM_DATA(buf, TEXT, sizeof(TEXT)-1);
+
+    /*wrong params*/
+    TEST_OPERATION_RESULT( posix_fadvise(fd, 0, -1, POSIX_FADV_NORMAL), &ret, ret==EINVAL);
+    TEST_OPERATION_RESULT( posix_fadvise(fd, 0, 0, 100), &ret, ret==EINVAL);
+    TEST_OPERATION_RESULT( close(fd), &ret, ret==0);
+    TEST_OPERATION_RESULT( posix_fadvise(fd, 0, 0, POSIX_FADV_NORMAL), &ret, ret==EBADF);
+    remove(FILENAME);
+}
+
+void test_channels_fadvise(){
+    int fd, ret;
+    char buf[5];
+    /*read-ahead on sequential channel, small reads still get requested size*/
+    TEST_OPERATION_RESULT( open(CHANNEL_NAME_READONLY, O_RDONLY), &fd, fd!=-1);
+    TEST_OPERATION_RESULT( posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL), &ret, ret==0);
+    TEST_OPERATION_RESULT( read(fd, buf, sizeof(buf)), &ret, ret==sizeof(buf));
+    TEST_OPERATION_RESULT( read(fd, buf, sizeof(buf)), &ret, ret==sizeof(buf));
+    TEST_OPERATION_RESULT( lseek(fd, 0, SEEK_CUR), &ret, ret==sizeof(buf)*2);
+    TEST_OPERATION_RESULT( posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED), &ret, ret==0);
+    TEST_OPERATION_RESULT( close(fd), &ret, ret==0);
+
+    /*emulated channels are accepting advice*/
+    TEST_OPERATION_RESULT( open("/dev/zero", O_RDONLY), &fd, fd!=-1);
+    TEST_OPERATION_RESULT( posix_fadvise(fd, 0, 100, POSIX_FADV_WILLNEED), &ret, ret==0);
+    TEST_OPERATION_RESULT( read(fd, buf, sizeof(buf)), &ret, ret==sizeof(buf));
+    TEST_OPERATION_RESULT( close(fd), &ret, ret==0);
+}
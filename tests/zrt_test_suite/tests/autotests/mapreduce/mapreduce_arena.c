@@ -0,0 +1,129 @@
+/*
+ * mapreduce library test, arena for keys and values of map items and
+ * freeing of owned item data
+ *
+ * Copyright (c) 2013, LiteStack, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <error.h>
+#include <errno.h>
+#include <assert.h>
+#include <alloca.h>
+
+#include "macro_tests.h"
+#include "map_arena.h"
+#include "elastic_mr_item.h"
+
+#define KEYS_COUNT 200000
+
+/*keys are written into arena, then checked, so blocks are not overlapped*/
+static void
+TestArenaKeys( int count ){
+    char **keys = malloc( count*sizeof(char*) );
+    char key[32];
+    size_t size = 0;
+    int ret, i, len;
+
+    fprintf(stderr, "arena keys count=%d\n", count);
+    for ( i=0; i < count; i++ ){
+	len = sprintf( key, "key%d", i );
+	keys[i] = MapArenaDup( key, len );
+	size += len+1;
+    }
+    TEST_OPERATION_RESULT( MapArenaUsed()==size, &ret, ret==1 );
+    for ( i=0; i < count; i++ ){
+	sprintf( key, "key%d", i );
+	TEST_OPERATION_RESULT( strcmp( keys[i], key ), &ret, ret==0 );
+    }
+    MapArenaReset();
+    TEST_OPERATION_RESULT( MapArenaUsed()==0, &ret, ret==1 );
+    free(keys);
+}
+
+static void
+TestArenaAlign(){
+    char *small, *next, *big;
+    int ret;
+    small = MapArenaDup( "a", 1 );
+    next = MapArenaAlloc( sizeof(uint64_t) );
+    TEST_OPERATION_RESULT( (uintptr_t)next % MAP_ARENA_ALIGN, &ret, ret==0 );
+    TEST_OPERATION_RESULT( next > small, &ret, ret==1 );
+    /*big allocation doesn't waste rest of current block*/
+    big = MapArenaAlloc( MAP_ARENA_BLOCK_SIZE*2 );
+    memset( big, 0xff, MAP_ARENA_BLOCK_SIZE*2 );
+    TEST_OPERATION_RESULT( (uintptr_t)big % MAP_ARENA_ALIGN, &ret, ret==0 );
+    small = MapArenaAlloc( 1 );
+    TEST_OPERATION_RESULT( small==next+sizeof(uint64_t), &ret, ret==1 );
+    TEST_OPERATION_RESULT( MapArenaUsed() >= MAP_ARENA_BLOCK_SIZE*2, &ret, ret==1 );
+    /*single block kept after reset is reused*/
+    MapArenaReset();
+    next = MapArenaAlloc( 1 );
+    TEST_OPERATION_RESULT( next==small-sizeof(uint64_t)-MAP_ARENA_ALIGN, &ret, ret==1 );
+    MapArenaFree();
+    TEST_OPERATION_RESULT( MapArenaUsed()==0, &ret, ret==1 );
+}
+
+/*big allocation into empty arena is counted once*/
+static void
+TestArenaBigFirst(){
+    int ret;
+    MapArenaFree();
+    MapArenaAlloc( MAP_ARENA_BLOCK_SIZE );
+    TEST_OPERATION_RESULT( MapArenaUsed()==MAP_ARENA_BLOCK_SIZE, &ret, ret==1 );
+    MapArenaAlloc( 1 );
+    TEST_OPERATION_RESULT( MapArenaUsed()==MAP_ARENA_BLOCK_SIZE+1, &ret, ret==1 );
+    MapArenaFree();
+    TEST_OPERATION_RESULT( MapArenaUsed()==0, &ret, ret==1 );
+}
+
+/*owned key and value both are freed, not owned are left*/
+static void
+TestFreeItemData(){
+    ElasticBufItemData* item = alloca( sizeof(ElasticBufItemData) );
+    char *not_owned = MapArenaDup( "value", 5 );
+    int ret;
+    memset( item, '\0', sizeof(ElasticBufItemData) );
+    item->key_data.addr = (uintptr_t)strdup("key");
+    item->own_key = EDataOwned;
+    item->value.addr = (uintptr_t)strdup("value");
+    item->own_value = EDataOwned;
+    TRY_FREE_MRITEM_DATA( item );
+    TEST_OPERATION_RESULT( item->key_data.addr==0 && item->value.addr==0, &ret, ret==1 );
+
+    item->key_data.addr = (uintptr_t)strdup("key");
+    item->own_key = EDataOwned;
+    item->value.addr = (uintptr_t)not_owned;
+    item->own_value = EDataNotOwned;
+    TRY_FREE_MRITEM_DATA( item );
+    TEST_OPERATION_RESULT( item->key_data.addr==0 && item->value.addr!=0, &ret, ret==1 );
+    MapArenaFree();
+}
+
+int main(int argc, char** argv){
+    TestArenaKeys( 0 );
+    TestArenaKeys( 1 );
+    TestArenaKeys( KEYS_COUNT );
+    /*blocks kept after reset are reused*/
+    TestArenaKeys( KEYS_COUNT );
+    TestArenaAlign();
+    TestArenaBigFirst();
+    TestFreeItemData();
+    return 0;
+}
@@ -0,0 +1,206 @@
+/*
+ * mapreduce library test, map side aggregation: items with equal hashes
+ * are folded by user Fold function, result must be the same as sort and
+ * Combine give
+ *
+ * Copyright (c) 2013, LiteStack, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <error.h>
+#include <errno.h>
+#include <assert.h>
+#include <alloca.h>
+
+#include "macro_tests.h"
+#include "map_reduce_lib.h"
+#include "hash_fold.h"
+#include "elastic_mr_item.h"
+#include "mr_defines.h"
+#include "buffer.h"
+#include "bench_helpers.h"
+
+#define HASH_TYPE  uint32_t
+#define ITEM_SIZE sizeof(				\
+			 struct{			\
+			     BinaryData     key_data;	\
+			     BinaryData     value;	\
+			     uint8_t        own_key;	\
+			     uint8_t        own_value;  \
+			     HASH_TYPE      key_hash;	\
+			 })
+#define ITEMS_COUNT 10000
+
+/*items emitted by Map*/
+static int s_map_count;
+static int s_map_distinct;
+
+/*input data are ignored, the same items are generated for every call*/
+static int
+Map( const char *data, size_t size, int last_chunk, Buffer *map_buffer ){
+    srand(s_map_distinct);
+    AddBufferItemsHash32( map_buffer, s_map_count, s_map_distinct );
+    return size;
+}
+
+static int
+Fold( ElasticBufItemData *accumulated, const ElasticBufItemData *item ){
+    accumulated->value.addr += item->value.addr;
+    return 0;
+}
+
+/*sum values of items with equal hashes*/
+static int
+Combine( const Buffer *map_buffer, Buffer *reduce_buffer ){
+    ElasticBufItemData *current, *combine = alloca(map_buffer->header.item_size);
+    int i;
+    for ( i=0; i < map_buffer->header.count; i++ ){
+	current = (ElasticBufItemData*)BufferItemPointer( map_buffer, i );
+	if ( i == 0 ){
+	    memcpy( combine, current, map_buffer->header.item_size );
+	}
+	else if ( ItemHash32(current) != ItemHash32(combine) ){
+	    AddBufferItem( reduce_buffer, combine );
+	    memcpy( combine, current, map_buffer->header.item_size );
+	}
+	else{
+	    combine->value.addr += current->value.addr;
+	}
+    }
+    if ( map_buffer->header.count ){
+	AddBufferItem( reduce_buffer, combine );
+    }
+    return 0;
+}
+
+static void
+PrepareMif( struct MapReduceUserIf *mif, int combine, int fold ){
+    PREPARE_MAPREDUCE( mif, Map, combine ? Combine : NULL, NULL,
+		       NULL, /*default mritem comparator*/
+		       NULL, /*default hash comparator*/
+		       NULL, 1, ITEM_SIZE, sizeof(HASH_TYPE) );
+    if ( fold ) mif->Fold = Fold;
+}
+
+static uint64_t
+ValuesSum( const Buffer *buf ){
+    uint64_t sum = 0;
+    int i;
+    for ( i=0; i < buf->header.count; i++ ){
+	sum += ((const ElasticBufItemData*)BufferItemPointer(buf, i))->value.addr;
+    }
+    return sum;
+}
+
+/*folded items have distinct hashes, values sum is kept*/
+static void
+TestFoldByHash( int count, int distinct, int max_items ){
+    struct MapReduceUserIf mif;
+    Buffer map, result;
+    HASH_TYPE hash;
+    uint8_t *seen = calloc( distinct, 1 );
+    int ret, res, i, expected_res;
+
+    fprintf(stderr, "fold count=%d, distinct=%d, max_items=%d\n", count, distinct, max_items);
+    PrepareMif( &mif, 1, 1 );
+    srand(distinct);
+    ret = AllocBuffer( &map, ITEM_SIZE, count+1 );
+    assert(!ret);
+    AddBufferItemsHash32( &map, count, distinct );
+    for ( i=0, res=0; i < count; i++ ){
+	hash = ItemHash32( (const ElasticBufItemData*)BufferItemPointer(&map, i) );
+	if ( !seen[hash] ) ++res;
+	seen[hash] = 1;
+    }
+    /*folding is stopped only if table can't hold all distinct hashes*/
+    expected_res = res > max_items ? -1 : 0;
+    memset( seen, '\0', distinct );
+
+    ret = AllocBuffer( &result, ITEM_SIZE, 16 );
+    assert(!ret);
+    TEST_OPERATION_RESULT( FoldByHash( &mif, &map, &result, max_items ), &ret, ret==expected_res );
+    TEST_OPERATION_RESULT( ValuesSum(&result)==ValuesSum(&map), &ret, ret==1 );
+    if ( expected_res == 0 ){
+	TEST_OPERATION_RESULT( result.header.count==res, &ret, ret==1 );
+	for ( i=0; i < result.header.count; i++ ){
+	    hash = ItemHash32( (const ElasticBufItemData*)BufferItemPointer(&result, i) );
+	    TEST_OPERATION_RESULT( seen[hash], &ret, ret==0 );
+	    seen[hash] = 1;
+	}
+    }
+    else{
+	/*first max_items items of result are distinct, the rest copied as is*/
+	TEST_OPERATION_RESULT( result.header.count > max_items, &ret, ret==1 );
+	TEST_OPERATION_RESULT( result.header.count <= count, &ret, ret==1 );
+    }
+    FreeBufferData(&map);
+    FreeBufferData(&result);
+    free(seen);
+}
+
+/*map chunk processing with Fold gives the same as with Combine*/
+static void
+TestLocalProcessing( int count, int distinct ){
+    struct MapReduceUserIf mif_combine, mif_fold;
+    Buffer combined, folded;
+    const ElasticBufItemData *item1, *item2;
+    int ret, i;
+
+    fprintf(stderr, "map processing count=%d, distinct=%d\n", count, distinct);
+    s_map_count = count;
+    s_map_distinct = distinct;
+    PrepareMif( &mif_combine, 1, 0 );
+    PrepareMif( &mif_fold, 1, 1 );
+    TEST_OPERATION_RESULT( MapInputDataLocalProcessing( &mif_combine, "", 0, 1, &combined ),
+			   &ret, ret==0 );
+    TEST_OPERATION_RESULT( MapInputDataLocalProcessing( &mif_fold, "", 0, 1, &folded ),
+			   &ret, ret==0 );
+    TEST_OPERATION_RESULT( combined.header.count==folded.header.count, &ret, ret==1 );
+    for ( i=0; i < combined.header.count; i++ ){
+	item1 = (const ElasticBufItemData*)BufferItemPointer(&combined, i);
+	item2 = (const ElasticBufItemData*)BufferItemPointer(&folded, i);
+	TEST_OPERATION_RESULT( ItemHash32(item1)==ItemHash32(item2), &ret, ret==1 );
+	TEST_OPERATION_RESULT( item1->value.addr==item2->value.addr, &ret, ret==1 );
+    }
+    FreeBufferData(&combined);
+    FreeBufferData(&folded);
+}
+
+int main(int argc, char** argv){
+    TestFoldByHash( 0, 1, DEFAULT_MAP_FOLD_TABLE_ITEMS );
+    TestFoldByHash( 1, 1, DEFAULT_MAP_FOLD_TABLE_ITEMS );
+    TestFoldByHash( ITEMS_COUNT, 1, DEFAULT_MAP_FOLD_TABLE_ITEMS );
+    TestFoldByHash( ITEMS_COUNT, 100, DEFAULT_MAP_FOLD_TABLE_ITEMS );
+    TestFoldByHash( ITEMS_COUNT, 1000000, DEFAULT_MAP_FOLD_TABLE_ITEMS );
+    /*too many distinct hashes*/
+    TestFoldByHash( ITEMS_COUNT, 1000, 100 );
+    TestFoldByHash( ITEMS_COUNT, 1000, 0 );
+
+    TestLocalProcessing( 0, 1 );
+    TestLocalProcessing( ITEMS_COUNT, 100 );
+    TestLocalProcessing( ITEMS_COUNT, 1000000 );
+    /*Combine is used instead of Fold for the rest of chunk*/
+    setenv( MAP_FOLD_TABLE_ITEMS_ENV, "100", 1 );
+    TestLocalProcessing( ITEMS_COUNT, 1000 );
+    /*wrong value is replaced by default*/
+    setenv( MAP_FOLD_TABLE_ITEMS_ENV, "-1", 1 );
+    TestLocalProcessing( ITEMS_COUNT, 1000 );
+    unsetenv( MAP_FOLD_TABLE_ITEMS_ENV );
+    return 0;
+}
@@ -340,6 +340,105 @@ TestMerge(struct MapReduceUserIf *mif){
     return dest;
 }
 
+/*Merge many sorted buffers, every buffer has its own items count and
+ *hashes range, some buffers are empty*/
+static void
+TestMergeManyBuffers(struct MapReduceUserIf *mif, int count){
+    int ret, i, j;
+    Buffer* array_of_buffers = malloc(sizeof(Buffer)*count);
+    Buffer dest;
+    uint64_t values_sum=0, merged_values_sum=0;
+    int all_items_count=0;
+    struct ElasticBufItemData* item = alloca(ITEM_SIZE);
+
+    fprintf(stderr, "merge %d buffers\n", count);
+    for(i=0; i < count; i++){
+	ret = AllocBuffer( &array_of_buffers[i], ITEM_SIZE, GRANULARITY );
+	assert(!ret);
+	int items_count = (i % 7 == 3) ? 0 : rand() % 200;
+	for(j=0; j < items_count; j++){
+	    memset(item, '\0', ITEM_SIZE);
+	    item->value.addr = i*1000+j;
+	    SET_KEY_HASH( &item->key_hash, rand() % (1+i*50), HASH_TYPE);
+	    AddBufferItem( &array_of_buffers[i], item );
+	    values_sum += item->value.addr;
+	}
+	all_items_count += items_count;
+	LocalSort( mif, &array_of_buffers[i] );
+    }
+
+    MergeBuffersToNew( mif, &dest, array_of_buffers, count);
+    TEST_OPERATION_RESULT( dest.header.count==all_items_count, &ret, ret==1);
+
+    /*Test items sorted by hash and no items lost*/
+    ElasticBufItemData* currentitem;
+    for(j=0; j < dest.header.count; j++ ){
+	currentitem = (ElasticBufItemData*)BufferItemPointer(&dest, j);
+	merged_values_sum += currentitem->value.addr;
+	if ( j > 0 ){
+	    ElasticBufItemData* previtem = (ElasticBufItemData*)BufferItemPointer(&dest, j-1);
+	    assert( HASH_CMP(mif, &previtem->key_hash, &currentitem->key_hash ) <= 0 );
+	}
+    }
+    TEST_OPERATION_RESULT( merged_values_sum==values_sum, &ret, ret==1);
+
+    for(i=0; i < count; i++){
+    	FreeBufferData(&array_of_buffers[i]);
+    }
+    FreeBufferData(&dest);
+    free(array_of_buffers);
+}
+
+/*Reducer runs: add combined runs of rounds, check that runs sizes are
+ *decreasing and final merge gives combined sorted items*/
+static void
+TestReduceRuns(struct MapReduceUserIf *mif, int rounds){
+    int ret, i, j;
+    struct ReduceRuns runs = {NULL, 0};
+    Buffer sort, run, all;
+    uint64_t values_sum=0, reduced_values_sum=0;
+    struct ElasticBufItemData* item = alloca(ITEM_SIZE);
+
+    fprintf(stderr, "reduce runs of %d rounds\n", rounds);
+    for(i=0; i < rounds; i++){
+	ret = AllocBuffer( &sort, ITEM_SIZE, GRANULARITY );
+	assert(!ret);
+	int items_count = (i % 5 == 2) ? 0 : rand() % 300;
+	for(j=0; j < items_count; j++){
+	    memset(item, '\0', ITEM_SIZE);
+	    item->value.addr = rand() % 1000;
+	    SET_KEY_HASH( &item->key_hash, rand() % 500, HASH_TYPE);
+	    AddBufferItem( &sort, item );
+	    values_sum += item->value.addr;
+	}
+	LocalSort( mif, &sort );
+	ret = AllocBuffer( &run, ITEM_SIZE, GRANULARITY );
+	assert(!ret);
+	mif->Combine( &sort, &run );
+	FreeBufferData(&sort);
+	AddReduceRun( mif, &runs, &run );
+	for(j=1; j < runs.count; j++){
+	    TEST_OPERATION_RESULT( runs.runs[j-1].header.count > runs.runs[j].header.count, 
+				   &ret, ret==1);
+	}
+    }
+
+    MergeReduceRuns( mif, &runs, &all );
+    TEST_OPERATION_RESULT( runs.count==0 && runs.runs==NULL, &ret, ret==1);
+    ElasticBufItemData* currentitem;
+    for(j=0; j < all.header.count; j++ ){
+	currentitem = (ElasticBufItemData*)BufferItemPointer(&all, j);
+	reduced_values_sum += currentitem->value.addr;
+	if ( j > 0 ){
+	    ElasticBufItemData* previtem = (ElasticBufItemData*)BufferItemPointer(&all, j-1);
+	    /*combined items have unique hashes*/
+	    assert( HASH_CMP(mif, &previtem->key_hash, &currentitem->key_hash ) < 0 );
+	}
+    }
+    TEST_OPERATION_RESULT( reduced_values_sum==values_sum, &ret, ret==1);
+    FreeBufferData(&all);
+}
+
 struct MapReduceUserIf* AllocMapReduce()
 {
     struct MapReduceUserIf* mif = malloc(sizeof(struct MapReduceUserIf));
@@ -390,6 +489,22 @@ int main(int argc, char** argv){
     free(merged);
     free(mif);
 
+    /*Merge of buffers count used by two way merge and by heap merge*/
+    mif = AllocMapReduce();
+    int merge_counts[] = {1, 2, 3, 4, 17, 300};
+    for(int i=0; i < sizeof(merge_counts)/sizeof(*merge_counts); i++){
+	TestMergeManyBuffers(mif, merge_counts[i]);
+    }
+    free(mif);
+
+    /*Reducer runs merged incrementally*/
+    mif = AllocMapReduce();
+    int rounds[] = {0, 1, 2, 7, 64, 1000};
+    for(int i=0; i < sizeof(rounds)/sizeof(*rounds); i++){
+	TestReduceRuns(mif, rounds[i]);
+    }
+    free(mif);
+
     (void)ret;
     return 0;
 }
@@ -0,0 +1,111 @@
+/*
+ * mapreduce library test, map input provider: records are handled by
+ * simulated Map which takes only complete lines, some lines are longer
+ * than chunk, input must be passed into Map without loss
+ *
+ * Copyright (c) 2013, LiteStack, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <error.h>
+#include <errno.h>
+#include <assert.h>
+
+#include "macro_tests.h"
+#include "map_reduce_lib.h"
+
+#define FILENAME "/map_input"
+
+/*write lines of given lengths, returns file contents*/
+static char*
+CreateInput( const int *line_sizes, int count, size_t *size ){
+    char *contents;
+    int fd, ret, i, j;
+    *size = 0;
+    for ( i=0; i < count; i++ ) *size += line_sizes[i]+1;
+    contents = malloc(*size+1);
+    char *cursor = contents;
+    for ( i=0; i < count; i++ ){
+	for ( j=0; j < line_sizes[i]; j++ ) *cursor++ = 'a' + (i+j)%26;
+	*cursor++ = '\n';
+    }
+    TEST_OPERATION_RESULT( open(FILENAME, O_CREAT|O_WRONLY|O_TRUNC, S_IRWXU), &fd, fd!=-1 );
+    TEST_OPERATION_RESULT( write(fd, contents, *size), &ret, ret==*size );
+    close(fd);
+    return contents;
+}
+
+/*Map handles complete lines only, or all data for last chunk*/
+static size_t
+HandledLinesPos( const char *data, size_t size, int last_chunk ){
+    size_t pos = size;
+    if ( last_chunk ) return size;
+    while ( pos > 0 && data[pos-1] != '\n' ) --pos;
+    return pos;
+}
+
+static void
+TestInput( const int *line_sizes, int count, size_t chunk_size ){
+    struct MapInputBuffer input;
+    size_t size, handled_size=0, data_size, unhandled_pos=0;
+    char *contents = CreateInput( line_sizes, count, &size );
+    int fd, ret, chunks=0;
+
+    fprintf(stderr, "map input lines=%d, chunk_size=%u\n", count, (unsigned)chunk_size );
+    memset( &input, '\0', sizeof(input) );
+    input.chunk_size = chunk_size;
+    TEST_OPERATION_RESULT( open(FILENAME, O_RDONLY), &fd, fd!=-1 );
+    do{
+	data_size = MapInputDataProvider( fd, &input, unhandled_pos );
+	TEST_OPERATION_RESULT( input.data[data_size]=='\0', &ret, ret==1 );
+	unhandled_pos = HandledLinesPos( input.data, data_size, input.eof );
+	/*handled data is exactly the next part of input*/
+	TEST_OPERATION_RESULT( handled_size+unhandled_pos <= size, &ret, ret==1 );
+	TEST_OPERATION_RESULT( memcmp(input.data, contents+handled_size, unhandled_pos), 
+			       &ret, ret==0 );
+	handled_size += unhandled_pos;
+	++chunks;
+    }while( !input.eof );
+    TEST_OPERATION_RESULT( handled_size==size, &ret, ret==1 );
+    /*buffer grows only for lines longer than chunk*/
+    if ( chunk_size > 2 ){
+	TEST_OPERATION_RESULT( input.size <= 2*chunk_size+size, &ret, ret==1 );
+    }
+    close(fd);
+    unlink(FILENAME);
+    free(input.data);
+    free(contents);
+}
+
+int main(int argc, char** argv){
+    int short_lines[] = {10, 20, 5, 0, 30, 7, 12, 1, 40};
+    int long_lines[]  = {10, 500, 3, 2000, 64, 63, 65, 1, 128, 7000, 2};
+    int one_line[]    = {5000};
+    TestInput( short_lines, sizeof(short_lines)/sizeof(*short_lines), 64 );
+    TestInput( short_lines, sizeof(short_lines)/sizeof(*short_lines), 1 );
+    TestInput( long_lines, sizeof(long_lines)/sizeof(*long_lines), 64 );
+    TestInput( long_lines, sizeof(long_lines)/sizeof(*long_lines), 1000 );
+    TestInput( one_line, 1, 100 );
+    /*input size is multiple of chunk size*/
+    TestInput( one_line, 1, 5001 );
+    TestInput( one_line, 1, 0x100000 );
+    return 0;
+}
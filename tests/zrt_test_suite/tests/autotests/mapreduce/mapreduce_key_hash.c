@@ -0,0 +1,182 @@
+/*
+ * mapreduce library test, built-in hash of keys: hash of every width,
+ * distribution of hashes, hashing of map items keys and default hash
+ * printing
+ *
+ * Copyright (c) 2013, LiteStack, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <error.h>
+#include <errno.h>
+#include <assert.h>
+#include <alloca.h>
+
+#include "macro_tests.h"
+#include "map_reduce_lib.h"
+#include "key_hash.h"
+#include "elastic_mr_item.h"
+#include "mr_defines.h"
+#include "buffer.h"
+#include "bench_helpers.h"
+
+#define MAX_HASH_SIZE 20
+#define KEYS_COUNT 100000
+#define BUCKETS_COUNT 64
+
+static int
+ComparatorUint64(const void *p1, const void *p2){
+    uint64_t v1 = *(const uint64_t*)p1, v2 = *(const uint64_t*)p2;
+    return v1 < v2 ? -1 : v1 > v2;
+}
+
+/*hash of every key length, hash depends on every byte and on seed*/
+static void
+TestKeyLengths(){
+    uint8_t key[200];
+    uint64_t hash;
+    int ret, size, i;
+    fprintf(stderr, "key lengths\n");
+    for ( i=0; i < sizeof(key); i++ ){
+	key[i] = i*7;
+    }
+    for ( size=0; size < sizeof(key)-1; size++ ){
+	/*unaligned key is hashed the same*/
+	memmove( key+1, key, size );
+	hash = KeyHash64( key+1, size, 0 );
+	memmove( key, key+1, size );
+	TEST_OPERATION_RESULT( KeyHash64( key, size, 0 )==hash, &ret, ret==1 );
+	TEST_OPERATION_RESULT( KeyHash64( key, size, 1 )!=hash, &ret, ret==1 );
+	/*size is hashed too*/
+	TEST_OPERATION_RESULT( KeyHash64( key, size+1, 0 )!=hash, &ret, ret==1 );
+	for ( i=0; i < size; i++ ){
+	    key[i] ^= 1;
+	    if ( KeyHash64( key, size, 0 )==hash ){
+		TEST_OPERATION_RESULT( i, &ret, ret==-1 );
+	    }
+	    key[i] ^= 1;
+	}
+    }
+}
+
+/*sequential keys give no collisions and even buckets by low and high bytes*/
+static void
+TestDistribution(){
+    uint64_t *hashes = malloc( KEYS_COUNT*sizeof(uint64_t) );
+    int low[BUCKETS_COUNT], high[BUCKETS_COUNT];
+    char key[32];
+    int ret, i, collisions = 0;
+    fprintf(stderr, "distribution\n");
+    memset( low, '\0', sizeof(low) );
+    memset( high, '\0', sizeof(high) );
+    for ( i=0; i < KEYS_COUNT; i++ ){
+	hashes[i] = KeyHash64( key, sprintf( key, "word%d", i ), 0 );
+	++low[ hashes[i] % BUCKETS_COUNT ];
+	++high[ hashes[i] >> 58 ];
+    }
+    for ( i=0; i < BUCKETS_COUNT; i++ ){
+	TEST_OPERATION_RESULT( low[i] > KEYS_COUNT/BUCKETS_COUNT*8/10 &&
+			       low[i] < KEYS_COUNT/BUCKETS_COUNT*12/10, &ret, ret==1 );
+	TEST_OPERATION_RESULT( high[i] > KEYS_COUNT/BUCKETS_COUNT*8/10 &&
+			       high[i] < KEYS_COUNT/BUCKETS_COUNT*12/10, &ret, ret==1 );
+    }
+    qsort( hashes, KEYS_COUNT, sizeof(uint64_t), ComparatorUint64 );
+    for ( i=1; i < KEYS_COUNT; i++ ){
+	collisions += hashes[i]==hashes[i-1];
+    }
+    TEST_OPERATION_RESULT( collisions, &ret, ret==0 );
+    free(hashes);
+}
+
+/*hash up to 8 bytes is the low part of 64bit hash, longer hash has
+ *independent words*/
+static void
+TestHashWidth(int hash_size){
+    uint8_t hash[MAX_HASH_SIZE+2];
+    uint64_t word;
+    int ret, i;
+    fprintf(stderr, "hash width %d\n", hash_size);
+    memset( hash, 0xcc, sizeof(hash) );
+    KeyHash( "key", 3, hash+1, hash_size );
+    TEST_OPERATION_RESULT( hash[0]==0xcc && hash[hash_size+1]==0xcc, &ret, ret==1 );
+    for ( i=0; i < hash_size; i++ ){
+	word = KeyHash64( "key", 3, i/8 );
+	TEST_OPERATION_RESULT( hash[i+1]==(uint8_t)(word >> 8*(i%8)), &ret, ret==1 );
+    }
+}
+
+/*key_hash of items is set by the same hash as KeyHash gives*/
+static void
+TestBufferItems(int hash_size){
+    struct MapReduceUserIf mif;
+    ElasticBufItemData* item = alloca( HASHED_ITEM_SIZE(hash_size) );
+    uint8_t hash[MAX_HASH_SIZE];
+    char *keys = malloc( KEYS_COUNT*16 );
+    Buffer map;
+    int ret, i;
+    fprintf(stderr, "buffer items hash_size=%d\n", hash_size);
+    PREPARE_MAPREDUCE( &mif, NULL, NULL, NULL, NULL, NULL,
+		       NULL, 1, HASHED_ITEM_SIZE(hash_size), hash_size );
+    ret = AllocBuffer( &map, HASHED_ITEM_SIZE(hash_size), KEYS_COUNT );
+    assert(!ret);
+    for ( i=0; i < KEYS_COUNT; i++ ){
+	memset( item, 0xcc, HASHED_ITEM_SIZE(hash_size) );
+	item->key_data.addr = (uintptr_t)&keys[i*16];
+	item->key_data.size = sprintf( &keys[i*16], "key%d", i );
+	AddBufferItem( &map, item );
+    }
+    /*first item keeps its hash*/
+    KeyHashBufferItems( &mif, &map, 1 );
+    for ( i=0; i < KEYS_COUNT; i++ ){
+	item = (ElasticBufItemData*)BufferItemPointer( &map, i );
+	if ( i == 0 ) memset( hash, 0xcc, hash_size );
+	else KeyHash( (const void*)item->key_data.addr, item->key_data.size, hash, hash_size );
+	if ( memcmp( &item->key_hash, hash, hash_size ) ){
+	    TEST_OPERATION_RESULT( i, &ret, ret==-1 );
+	}
+    }
+    FreeBufferData(&map);
+    free(keys);
+}
+
+static void
+TestHashAsString(){
+    struct MapReduceUserIf mif;
+    uint8_t hash[] = {0x01, 0xab, 0x0f};
+    char str[sizeof(hash)*2+1];
+    int ret;
+    PREPARE_MAPREDUCE( &mif, NULL, NULL, NULL, NULL, NULL,
+		       NULL, 1, HASHED_ITEM_SIZE(sizeof(hash)), sizeof(hash) );
+    TEST_OPERATION_RESULT( mif.DebugHashAsString==HashAsStringDefault, &ret, ret==1 );
+    TEST_OPERATION_RESULT( strcmp( mif.DebugHashAsString( str, hash, sizeof(hash) ), "0fab01" ),
+			   &ret, ret==0 );
+}
+
+int main(int argc, char** argv){
+    int hash_sizes[] = {1, 2, 4, 8, 16, MAX_HASH_SIZE};
+    int i;
+    TestKeyLengths();
+    TestDistribution();
+    for ( i=0; i < sizeof(hash_sizes)/sizeof(*hash_sizes); i++ ){
+	TestHashWidth( hash_sizes[i] );
+	TestBufferItems( hash_sizes[i] );
+    }
+    TestHashAsString();
+    return 0;
+}
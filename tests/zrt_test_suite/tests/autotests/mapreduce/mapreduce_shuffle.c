@@ -0,0 +1,196 @@
+/*
+ * mapreduce library test, items sending from map into reduce node:
+ * packets written by WriteDataToReduce into file and received back by
+ * RecvDataFromSingleMap
+ *
+ * Copyright (c) 2013, LiteStack, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <error.h>
+#include <errno.h>
+#include <assert.h>
+#include <alloca.h>
+
+#include "macro_tests.h"
+#include "map_reduce_lib.h"
+#include "elastic_mr_item.h"
+#include "mr_defines.h"
+#include "buffer.h"
+
+#define FILENAME "/shuffle_packets"
+#define HASH_TYPE  uint32_t
+#define ITEM_SIZE sizeof(				\
+			 struct{			\
+			     BinaryData     key_data;	\
+			     BinaryData     value;	\
+			     uint8_t        own_key;	\
+			     uint8_t        own_value;  \
+			     HASH_TYPE      key_hash;	\
+			 })
+/*values of this size are written directly from memory*/
+#define BIG_VALUE_SIZE (SHUFFLE_DIRECT_WRITE_MIN+100)
+
+/*hash in item is not aligned*/
+static int
+ComparatorHash(const void *h1, const void *h2){
+    HASH_TYPE hash1, hash2;
+    memcpy( &hash1, h1, sizeof(HASH_TYPE) );
+    memcpy( &hash2, h2, sizeof(HASH_TYPE) );
+    if      ( hash1 < hash2 ) return -1;
+    else if ( hash1 > hash2 ) return 1;
+    else return 0;
+}
+
+/*Fill map buffer, keys are packed in arena or allocated separately,
+ *every third value is big if values are not stored in address*/
+static char*
+FillMap( struct MapReduceUserIf *mif, Buffer *map, int count, int arena_keys ){
+    ElasticBufItemData* item = alloca(ITEM_SIZE);
+    char *arena = malloc(count*16+1);
+    char *cursor = arena;
+    int ret, i;
+    ret = AllocBuffer( map, ITEM_SIZE, count+1 );
+    assert(!ret);
+    for ( i=0; i < count; i++ ){
+	memset( item, '\0', ITEM_SIZE );
+	if ( arena_keys ){
+	    item->key_data.size = sprintf( cursor, "key%d", i );
+	    item->key_data.addr = (uintptr_t)cursor;
+	    cursor += item->key_data.size;
+	}
+	else{
+	    char temp[16];
+	    item->key_data.size = sprintf( temp, "key%d", i );
+	    item->key_data.addr = (uintptr_t)strdup(temp);
+	    item->own_key = EDataOwned;
+	}
+	if ( mif->data.value_addr_is_data ){
+	    item->value.addr = i*3;
+	}
+	else{
+	    item->value.size = i%3 == 1 ? BIG_VALUE_SIZE : i%5;
+	    item->value.addr = (uintptr_t)malloc(item->value.size+1);
+	    memset( (void*)item->value.addr, 'a'+i%26, item->value.size );
+	    item->own_value = EDataOwned;
+	}
+	HASH_TYPE hash = i;
+	memcpy( &item->key_hash, &hash, sizeof(HASH_TYPE) );
+	AddBufferItem( map, item );
+    }
+    return arena;
+}
+
+static void
+FreeMap( Buffer *map, char *arena ){
+    ElasticBufItemData* item;
+    for ( int i=0; i < map->header.count; i++ ){
+	item = (ElasticBufItemData*)BufferItemPointer(map, i);
+	if ( item->own_key == EDataOwned ) free((void*)item->key_data.addr);
+	if ( item->own_value == EDataOwned ) free((void*)item->value.addr);
+    }
+    FreeBufferData(map);
+    free(arena);
+}
+
+static void
+CheckReceived( struct MapReduceUserIf *mif, const Buffer *map, int start, 
+	       const Buffer *received ){
+    const ElasticBufItemData *sent, *recv;
+    int ret;
+    for ( int i=0; i < received->header.count; i++ ){
+	sent = (const ElasticBufItemData*)BufferItemPointer(map, start+i);
+	recv = (const ElasticBufItemData*)BufferItemPointer(received, i);
+	TEST_OPERATION_RESULT( recv->key_data.size == sent->key_data.size 
+			       && !memcmp( (void*)recv->key_data.addr, 
+					   (void*)sent->key_data.addr, sent->key_data.size),
+			       &ret, ret==1 );
+	if ( mif->data.value_addr_is_data ){
+	    TEST_OPERATION_RESULT( recv->value.addr==sent->value.addr, &ret, ret==1 );
+	}
+	else{
+	    TEST_OPERATION_RESULT( recv->value.size == sent->value.size 
+				   && !memcmp( (void*)recv->value.addr, 
+					       (void*)sent->value.addr, sent->value.size),
+				   &ret, ret==1 );
+	}
+	TEST_OPERATION_RESULT( HASH_CMP(mif, &recv->key_hash, &sent->key_hash), 
+			       &ret, ret==0 );
+	TEST_OPERATION_RESULT( recv->own_key==EDataNotOwned && recv->own_value==EDataNotOwned,
+			       &ret, ret==1 );
+    }
+}
+
+/*send map buffer as some packets of different size, last one is empty*/
+static void
+TestShuffle( int value_addr_is_data, int count, int arena_keys, size_t staging_size ){
+    struct MapReduceUserIf mif;
+    struct ShuffleWriter writer;
+    Buffer map, received;
+    char *arena, *packet;
+    int ranges[][2] = { {0, count/3}, {count/3, count-count/3}, {count, 0} };
+    int fd, ret, i;
+
+    fprintf(stderr, "shuffle value_addr_is_data=%d count=%d arena_keys=%d staging=%u\n",
+	    value_addr_is_data, count, arena_keys, (unsigned)staging_size );
+    PREPARE_MAPREDUCE( &mif, NULL, NULL, NULL, NULL, ComparatorHash, NULL,
+		       value_addr_is_data, ITEM_SIZE, sizeof(HASH_TYPE) );
+    arena = FillMap( &mif, &map, count, arena_keys );
+
+    TEST_OPERATION_RESULT( open(FILENAME, O_CREAT|O_RDWR|O_TRUNC, S_IRWXU), &fd, fd!=-1 );
+    SHUFFLE_WRITER_INIT( &writer, malloc(staging_size), staging_size );
+    for ( i=0; i < sizeof(ranges)/sizeof(*ranges); i++ ){
+	WriteDataToReduce( &mif, &writer, fd, &map, ranges[i][0], ranges[i][1], 
+			   i == sizeof(ranges)/sizeof(*ranges)-1 ? MAP_NODE_EXCLUDE : MAP_NODE_NO_EXCLUDE );
+    }
+    free(writer.staging);
+    TEST_OPERATION_RESULT( lseek(fd, 0, SEEK_SET), &ret, ret==0 );
+
+    for ( i=0; i < sizeof(ranges)/sizeof(*ranges); i++ ){
+	int flag = RecvDataFromSingleMap( &mif, fd, &received, &packet );
+	TEST_OPERATION_RESULT( flag, &ret, 
+			       ret==(i == sizeof(ranges)/sizeof(*ranges)-1 ? 
+				     MAP_NODE_EXCLUDE : MAP_NODE_NO_EXCLUDE) );
+	TEST_OPERATION_RESULT( received.header.count==ranges[i][1], &ret, ret==1 );
+	CheckReceived( &mif, &map, ranges[i][0], &received );
+	FreeBufferData(&received);
+	free(packet);
+    }
+    /*everything read*/
+    char c;
+    TEST_OPERATION_RESULT( read(fd, &c, 1), &ret, ret==0 );
+    close(fd);
+    unlink(FILENAME);
+    FreeMap( &map, arena );
+}
+
+int main(int argc, char** argv){
+    int value_addr_is_data, arena_keys;
+    for ( value_addr_is_data=0; value_addr_is_data <= 1; value_addr_is_data++ ){
+	for ( arena_keys=0; arena_keys <= 1; arena_keys++ ){
+	    TestShuffle( value_addr_is_data, 1, arena_keys, SEND_BUFFER_SIZE );
+	    TestShuffle( value_addr_is_data, 1000, arena_keys, SEND_BUFFER_SIZE );
+	    /*staging buffer is flushed many times, iovecs are exhausted*/
+	    TestShuffle( value_addr_is_data, 1000, arena_keys, SHUFFLE_DIRECT_WRITE_MIN );
+	}
+    }
+    return 0;
+}
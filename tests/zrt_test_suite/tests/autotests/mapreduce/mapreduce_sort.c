@@ -0,0 +1,255 @@
+/*
+ * mapreduce library test, sorting of map items by hash without
+ * user comparators
+ *
+ * Copyright (c) 2013, LiteStack, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <error.h>
+#include <errno.h>
+#include <assert.h>
+#include <alloca.h>
+
+#include "macro_tests.h"
+#include "map_reduce_lib.h"
+#include "elastic_mr_item.h"
+#include "mr_defines.h"
+#include "buffer.h"
+#include "bench_helpers.h"
+
+#define MAX_HASH_SIZE 20
+#define ITEMS_COUNT 10000
+
+/*hash size for qsort comparator*/
+static int s_hash_size;
+
+static int
+ComparatorHashDefaultQSort(const void *p1, const void *p2){
+    return HashCompareDefault( &((ElasticBufItemData*)p1)->key_hash,
+			       &((ElasticBufItemData*)p2)->key_hash, s_hash_size );
+}
+
+static void
+CopyBuffer(Buffer* dest, const Buffer* src){
+    int ret = AllocBuffer( dest, src->header.item_size, src->header.count );
+    assert(!ret);
+    memcpy( dest->data, src->data, src->header.count*src->header.item_size );
+    dest->header.count = src->header.count;
+}
+
+/*sorted in default order, items with equal hashes keep order*/
+static void
+CheckSorted(const Buffer* sorted, const Buffer* control, int hash_size){
+    const ElasticBufItemData *prev, *current, *expected;
+    int ret, i, cmp;
+    TEST_OPERATION_RESULT( sorted->header.count==control->header.count, &ret, ret==1 );
+    for ( i=0; i < sorted->header.count; i++ ){
+	current = (const ElasticBufItemData*)BufferItemPointer(sorted, i);
+	expected = (const ElasticBufItemData*)BufferItemPointer(control, i);
+	/*the same hashes as qsort gives*/
+	cmp = HashCompareDefault( &current->key_hash, &expected->key_hash, hash_size );
+	if ( cmp != 0 ){
+	    TEST_OPERATION_RESULT( cmp, &ret, ret==0 );
+	}
+	if ( i > 0 ){
+	    prev = (const ElasticBufItemData*)BufferItemPointer(sorted, i-1);
+	    cmp = HashCompareDefault( &prev->key_hash, &current->key_hash, hash_size );
+	    if ( cmp == 0 && prev->value.addr > current->value.addr ){
+		TEST_OPERATION_RESULT( "radix sort is not stable" == NULL, &ret, ret==1 );
+	    }
+	}
+    }
+}
+
+static void
+TestRadixSort(int hash_size, int count, int distinct_bytes){
+    Buffer radix, control;
+    int ret;
+    fprintf(stderr, "radix sort hash_size=%d, count=%d, distinct_bytes=%d\n",
+	    hash_size, count, distinct_bytes);
+    FillBufferRandomHashes( &radix, hash_size, count, distinct_bytes );
+    CopyBuffer( &control, &radix );
+
+    s_hash_size = hash_size;
+    qsort( control.data, control.header.count, control.header.item_size,
+	   ComparatorHashDefaultQSort );
+    TEST_OPERATION_RESULT( RadixSortByHash( &radix, hash_size ), &ret, ret==0 );
+    CheckSorted( &radix, &control, hash_size );
+
+    FreeBufferData(&radix);
+    FreeBufferData(&control);
+}
+
+/*LocalSort must use radix sort if item comparator is not provided*/
+static void
+TestLocalSortDefaultComparator(){
+    struct MapReduceUserIf mif;
+    Buffer sort, control;
+    uint32_t h1 = 0x100, h2 = 0xff;
+    int ret;
+    PREPARE_MAPREDUCE( &mif, NULL, NULL, NULL,
+		       NULL, /*default mritem comparator*/
+		       NULL, /*default hash comparator*/
+		       NULL, 1, HASHED_ITEM_SIZE(sizeof(uint32_t)), sizeof(uint32_t) );
+    /*default hash order is the same as uint32 comparison*/
+    TEST_OPERATION_RESULT( HASH_CMP(&mif, &h1, &h2), &ret, ret > 0 );
+    TEST_OPERATION_RESULT( HASH_CMP(&mif, &h2, &h1), &ret, ret < 0 );
+    TEST_OPERATION_RESULT( HASH_CMP(&mif, &h1, &h1), &ret, ret == 0 );
+
+    FillBufferRandomHashes( &sort, sizeof(uint32_t), ITEMS_COUNT, 256 );
+    CopyBuffer( &control, &sort );
+    s_hash_size = sizeof(uint32_t);
+    qsort( control.data, control.header.count, control.header.item_size,
+	   ComparatorHashDefaultQSort );
+    LocalSort( &mif, &sort );
+    CheckSorted( &sort, &control, sizeof(uint32_t) );
+    FreeBufferData(&sort);
+    FreeBufferData(&control);
+}
+
+static int
+ComparatorHashReversed(const void *h1, const void *h2){
+    return HashCompareDefault( h2, h1, sizeof(uint32_t) );
+}
+
+static void
+CheckSortedByHashCmp(struct MapReduceUserIf *mif, const Buffer* sorted){
+    const ElasticBufItemData *prev, *current;
+    int ret, i;
+    for ( i=1; i < sorted->header.count; i++ ){
+	prev = (const ElasticBufItemData*)BufferItemPointer(sorted, i-1);
+	current = (const ElasticBufItemData*)BufferItemPointer(sorted, i);
+	if ( HASH_CMP( mif, &prev->key_hash, &current->key_hash ) > 0 ){
+	    TEST_OPERATION_RESULT( "not sorted by hash comparator" == NULL, 
+				   &ret, ret==1 );
+	}
+    }
+}
+
+/*without item comparator LocalSort must give the same order as user
+ *hash comparator, merge and dividers are using it*/
+static void
+TestLocalSortUserHashComparator(){
+    struct MapReduceUserIf mif;
+    Buffer sources[2], merged;
+    int ret, i;
+    PREPARE_MAPREDUCE( &mif, NULL, NULL, NULL,
+		       NULL, /*default mritem comparator*/
+		       ComparatorHashReversed,
+		       NULL, 1, HASHED_ITEM_SIZE(sizeof(uint32_t)), sizeof(uint32_t) );
+    for ( i=0; i < 2; i++ ){
+	FillBufferRandomHashes( &sources[i], sizeof(uint32_t), ITEMS_COUNT, 256 );
+	LocalSort( &mif, &sources[i] );
+	CheckSortedByHashCmp( &mif, &sources[i] );
+    }
+    MergeBuffersToNew( &mif, &merged, sources, 2 );
+    TEST_OPERATION_RESULT( merged.header.count, &ret, ret==2*ITEMS_COUNT );
+    CheckSortedByHashCmp( &mif, &merged );
+    for ( i=0; i < 2; i++ ){
+	FreeBufferData(&sources[i]);
+    }
+    FreeBufferData(&merged);
+}
+
+/*built-in comparator for hash size gives the same order as default*/
+static void
+TestHashCompareSized(int hash_size){
+    uint8_t h1[MAX_HASH_SIZE+1], h2[MAX_HASH_SIZE+1];
+    int ret, i, j, cmp, sized_cmp;
+    fprintf(stderr, "sized hash comparison hash_size=%d\n", hash_size);
+    for ( i=0; i < ITEMS_COUNT; i++ ){
+	/*unaligned hashes differing in any byte*/
+	for ( j=0; j < hash_size; j++ ){
+	    h1[j+1] = rand() % 3;
+	    h2[j+1] = rand() % 3;
+	}
+	cmp = HashCompareDefault( h1+1, h2+1, hash_size );
+	sized_cmp = HashCompareSized( h1+1, h2+1, hash_size );
+	if ( (cmp > 0) != (sized_cmp > 0) || (cmp < 0) != (sized_cmp < 0) ){
+	    TEST_OPERATION_RESULT( sized_cmp, &ret, ret==cmp );
+	}
+    }
+}
+
+/*merge specialized by hash size gives the same as generic merge*/
+static void
+TestMergeSpecialized(int hash_size){
+    struct MapReduceUserIf mif;
+    Buffer sources[3], specialized, generic;
+    int ret, i, count;
+    fprintf(stderr, "specialized merge hash_size=%d\n", hash_size);
+    PREPARE_MAPREDUCE( &mif, NULL, NULL, NULL, NULL, NULL,
+		       NULL, 1, HASHED_ITEM_SIZE(hash_size), hash_size );
+    TEST_OPERATION_RESULT( mif.data.cmp_hash_size, &ret, 
+			   ret==(HASH_SIZE_SPECIALIZED(hash_size) ? hash_size : 0) );
+    for ( i=0; i < sizeof(sources)/sizeof(*sources); i++ ){
+	FillBufferRandomHashes( &sources[i], hash_size, ITEMS_COUNT/(i+1), 4 );
+	LocalSort( &mif, &sources[i] );
+    }
+    /*two way merge and heap merge*/
+    for ( count=2; count <= 3; count++ ){
+	mif.data.cmp_hash_size = HASH_SIZE_SPECIALIZED(hash_size) ? hash_size : 0;
+	MergeBuffersToNew( &mif, &specialized, sources, count );
+	mif.data.cmp_hash_size = 0;
+	MergeBuffersToNew( &mif, &generic, sources, count );
+	/*equal hashes are ordered by source in both cases*/
+	TEST_OPERATION_RESULT( memcmp( specialized.data, generic.data, 
+				       generic.header.count*generic.header.item_size ),
+			       &ret, ret==0 );
+	FreeBufferData(&specialized);
+	FreeBufferData(&generic);
+    }
+    for ( i=0; i < sizeof(sources)/sizeof(*sources); i++ ){
+	FreeBufferData(&sources[i]);
+    }
+}
+
+int main(int argc, char** argv){
+    int hash_sizes[] = {1, 2, 4, 8, 16, MAX_HASH_SIZE};
+    int i;
+    srand(12345);
+    for ( i=0; i < sizeof(hash_sizes)/sizeof(*hash_sizes); i++ ){
+	/*empty and single item buffers*/
+	TestRadixSort( hash_sizes[i], 0, 256 );
+	TestRadixSort( hash_sizes[i], 1, 256 );
+	/*less items than insertion sort threshold*/
+	TestRadixSort( hash_sizes[i], 20, 256 );
+	/*random hashes*/
+	TestRadixSort( hash_sizes[i], ITEMS_COUNT, 256 );
+	/*many duplicates and equal bytes*/
+	TestRadixSort( hash_sizes[i], ITEMS_COUNT, 2 );
+	TestRadixSort( hash_sizes[i], ITEMS_COUNT, 1 );
+    }
+    TestLocalSortDefaultComparator();
+    TestLocalSortUserHashComparator();
+    for ( i=0; i < sizeof(hash_sizes)/sizeof(*hash_sizes); i++ ){
+	TestHashCompareSized( hash_sizes[i] );
+	TestMergeSpecialized( hash_sizes[i] );
+    }
+    /*user comparator disables built-in one*/
+    {
+	struct MapReduceUserIf mif;
+	int ret;
+	PREPARE_MAPREDUCE( &mif, NULL, NULL, NULL, NULL, ComparatorHashDefaultQSort,
+			   NULL, 1, HASHED_ITEM_SIZE(4), 4 );
+	TEST_OPERATION_RESULT( mif.data.cmp_hash_size, &ret, ret==0 );
+    }
+    return 0;
+}
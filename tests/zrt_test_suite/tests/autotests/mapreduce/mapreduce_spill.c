@@ -0,0 +1,196 @@
+/*
+ * mapreduce library test, reducer spilled runs: sorted runs written into
+ * scratch file are merged with data in memory streaming into Combine and
+ * Reduce
+ *
+ * Copyright (c) 2013, LiteStack, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <error.h>
+#include <errno.h>
+#include <assert.h>
+#include <alloca.h>
+
+#include "macro_tests.h"
+#include "map_reduce_lib.h"
+#include "reduce_spill.h"
+#include "elastic_mr_item.h"
+#include "mr_defines.h"
+#include "buffer.h"
+#include "bench_helpers.h"
+
+#define SPILL_FILE "/spill_test"
+#define HASH_TYPE  uint32_t
+#define ITEM_SIZE sizeof(				\
+			 struct{			\
+			     BinaryData     key_data;	\
+			     BinaryData     value;	\
+			     uint8_t        own_key;	\
+			     uint8_t        own_value;  \
+			     HASH_TYPE      key_hash;	\
+			 })
+
+/*sum values of items with equal hashes*/
+static int 
+Combine( const Buffer *map_buffer, Buffer *reduce_buffer ){
+    ElasticBufItemData *current, *combine = alloca(map_buffer->header.item_size);
+    for ( int i=0; i < map_buffer->header.count; i++ ){
+	current = (ElasticBufItemData*)BufferItemPointer( map_buffer, i );
+	if ( i == 0 ){
+	    memcpy( combine, current, map_buffer->header.item_size );
+	}
+	else if ( ItemHash32(current) != ItemHash32(combine) ){
+	    AddBufferItem( reduce_buffer, combine );
+	    memcpy( combine, current, map_buffer->header.item_size );
+	}
+	else{
+	    combine->value.addr += current->value.addr;
+	}
+    }
+    if ( map_buffer->header.count ){
+	AddBufferItem( reduce_buffer, combine );
+    }
+    return 0;
+}
+
+/*Reduce results*/
+static int      s_combine;
+static int      s_reduce_calls;
+static int      s_items;
+static int      s_have_last;
+static HASH_TYPE s_last_hash;
+static uint64_t s_values_sum;
+
+static int 
+Reduce( const Buffer *reduce_buffer ){
+    const ElasticBufItemData *item;
+    char key[16];
+    int ret;
+    ++s_reduce_calls;
+    for ( int i=0; i < reduce_buffer->header.count; i++ ){
+	item = (const ElasticBufItemData*)BufferItemPointer( reduce_buffer, i );
+	if ( s_have_last ){
+	    /*sorted through all calls, items with equal hash are in single call*/
+	    TEST_OPERATION_RESULT( s_last_hash <= ItemHash32(item), &ret, ret==1 );
+	    if ( s_combine || i == 0 ){
+		TEST_OPERATION_RESULT( s_last_hash != ItemHash32(item), &ret, ret==1 );
+	    }
+	}
+	sprintf( key, "k%u", ItemHash32(item) );
+	TEST_OPERATION_RESULT( item->key_data.size == strlen(key)
+			       && !memcmp((void*)item->key_data.addr, key, strlen(key)),
+			       &ret, ret==1 );
+	s_last_hash = ItemHash32(item);
+	s_have_last = 1;
+	s_values_sum += item->value.addr;
+	++s_items;
+    }
+    return 0;
+}
+
+/*sorted run of random hashes, keys are owned*/
+static void
+CreateRun( struct MapReduceUserIf *mif, Buffer *run, int count, int hash_range, 
+	   uint64_t *values_sum ){
+    ElasticBufItemData *item = alloca(ITEM_SIZE);
+    Buffer sort;
+    char key[16];
+    int ret;
+    ret = AllocBuffer( &sort, ITEM_SIZE, count+1 );
+    assert(!ret);
+    for ( int i=0; i < count; i++ ){
+	HASH_TYPE hash = rand() % hash_range;
+	memset( item, '\0', ITEM_SIZE );
+	memcpy( &item->key_hash, &hash, sizeof(HASH_TYPE) );
+	item->key_data.size = sprintf( key, "k%u", hash );
+	item->key_data.addr = (uintptr_t)strdup(key);
+	item->own_key = EDataOwned;
+	item->value.addr = rand() % 100;
+	*values_sum += item->value.addr;
+	AddBufferItem( &sort, item );
+    }
+    LocalSort( mif, &sort );
+    if ( mif->Combine ){
+	ret = AllocBuffer( run, ITEM_SIZE, count+1 );
+	assert(!ret);
+	mif->Combine( &sort, run );
+	/*keys of combined out items are not needed*/
+	for ( int i=0, j=0; i < sort.header.count; i++ ){
+	    item = (ElasticBufItemData*)BufferItemPointer( &sort, i );
+	    const ElasticBufItemData *kept = j < run->header.count ?
+		(const ElasticBufItemData*)BufferItemPointer( run, j ) : NULL;
+	    if ( kept && kept->key_data.addr == item->key_data.addr ) ++j;
+	    else free( (void*)item->key_data.addr );
+	}
+	FreeBufferData( &sort );
+    }
+    else{
+	*run = sort;
+    }
+}
+
+static void
+TestSpill( int combine, int runs_count, int run_items, int hash_range ){
+    struct MapReduceUserIf mif;
+    struct ReduceSpill spill;
+    Buffer run;
+    uint64_t values_sum=0;
+    int ret;
+
+    fprintf(stderr, "spill combine=%d runs=%d run_items=%d hash_range=%d\n",
+	    combine, runs_count, run_items, hash_range );
+    PREPARE_MAPREDUCE( &mif, NULL, combine ? Combine : NULL, Reduce, NULL, NULL, NULL,
+		       1, ITEM_SIZE, sizeof(HASH_TYPE) );
+    s_combine = combine;
+    s_reduce_calls = s_items = s_have_last = 0;
+    s_values_sum = 0;
+
+    ReduceSpillOpen( &spill, SPILL_FILE );
+    for ( int i=0; i < runs_count; i++ ){
+	/*some runs are empty*/
+	CreateRun( &mif, &run, i%4 == 2 ? 0 : run_items, hash_range, &values_sum );
+	ReduceSpillWrite( &mif, &spill, &run );
+    }
+    CreateRun( &mif, &run, run_items, hash_range, &values_sum );
+    ReduceSpillMerge( &mif, &spill, &run );
+    TEST_OPERATION_RESULT( run.data==NULL && spill.count==0, &ret, ret==1 );
+    TEST_OPERATION_RESULT( access(SPILL_FILE, F_OK), &ret, ret==-1 );
+    TEST_OPERATION_RESULT( s_values_sum==values_sum, &ret, ret==1 );
+    TEST_OPERATION_RESULT( s_reduce_calls>=1, &ret, ret==1 );
+    if ( combine ){
+	TEST_OPERATION_RESULT( s_items<=hash_range, &ret, ret==1 );
+    }
+}
+
+int main(int argc, char** argv){
+    srand(1);
+    for ( int combine=0; combine <= 1; combine++ ){
+	/*nothing spilled*/
+	TestSpill( combine, 0, 100, 50 );
+	TestSpill( combine, 1, 1, 50 );
+	TestSpill( combine, 5, 1000, 300 );
+	/*runs of some packets, reduced by some batches*/
+	TestSpill( combine, 7, 3*SPILL_PACKET_ITEMS+5, 4*SPILL_REDUCE_BATCH_ITEMS );
+	/*many equal hashes in batch*/
+	TestSpill( combine, 3, 2*SPILL_PACKET_ITEMS, 3 );
+    }
+    return 0;
+}
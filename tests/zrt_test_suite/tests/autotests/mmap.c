@@ -45,9 +45,11 @@ void sbrk_mmap_test();
 void mmap_test_file_mapping(off_t offset);
 void mmap_test_unmap(void* unmap_addr, size_t length);
 void* mmap_test_align(size_t length, int result_expected);
+void mmap_test_best_fit();
 
 int main(int argc, char**argv){
     sbrk_mmap_test();
+    mmap_test_best_fit();
 
     int pagesize = sysconf(_SC_PAGE_SIZE);
     uint32_t rounded_up_heap_addr = ROUND_UP( (uint32_t)MANIFEST->heap_ptr, sysconf(_SC_PAGESIZE) );
@@ -95,7 +97,9 @@ int main(int argc, char**argv){
     mmap_test_align(pagesize, EXPECTED_TRUE);
 
     /*we need to free some memory to properly run some code inside of exit handler*/
-    mmap_test_unmap((void*)rounded_up_heap_addr, rounded_up_heap_size);
+    uint32_t mmap_region_addr = ROUND_UP( (uint32_t)sbrk(0), pagesize );
+    mmap_test_unmap((void*)mmap_region_addr, 
+		    rounded_up_heap_addr+rounded_up_heap_size - mmap_region_addr);
 
     return 0;
 }
@@ -151,6 +155,30 @@ void mmap_test_unmap(void* unmap_addr, size_t length){
 			  &ret, ret==0);
 }
 
+/*freed pages are reused by best fit and joined with free neighbours*/
+void mmap_test_best_fit(){
+    int pagesize = sysconf(_SC_PAGE_SIZE);
+    /*pages are going down from highest address*/
+    void* a = mmap_test_align(pagesize*5, EXPECTED_TRUE);
+    void* b = mmap_test_align(pagesize, EXPECTED_TRUE);
+    void* c = mmap_test_align(pagesize*3, EXPECTED_TRUE);
+    void* d = mmap_test_align(pagesize, EXPECTED_TRUE);
+    void* addr;
+    int ret;
+    mmap_test_unmap(a, pagesize*5);
+    mmap_test_unmap(c, pagesize*3);
+    /*smallest free range is chosen*/
+    addr = mmap_test_align(pagesize*3, EXPECTED_TRUE);
+    TEST_OPERATION_RESULT( addr==c, &ret, ret==1 );
+    mmap_test_unmap(addr, pagesize*3);
+    /*a, b, c are joined into one range*/
+    mmap_test_unmap(b, pagesize);
+    addr = mmap_test_align(pagesize*9, EXPECTED_TRUE);
+    TEST_OPERATION_RESULT( addr==c, &ret, ret==1 );
+    mmap_test_unmap(addr, pagesize*9);
+    mmap_test_unmap(d, pagesize);
+}
+
 void sbrk_mmap_test(){
 #define MALLOC_SIZE 0x40000
 #define MMAP_SIZE 0x40000
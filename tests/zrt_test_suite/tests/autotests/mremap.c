@@ -0,0 +1,98 @@
+/*
+ * mremap and partial munmap test
+ *
+ * Copyright (c) 2013, LiteStack, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define _GNU_SOURCE
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <string.h>
+#include <stdio.h>
+#include <error.h>
+#include <errno.h>
+
+#include "macro_tests.h"
+
+#define MAP_ANON_RW(length) mmap(NULL, (length), PROT_READ|PROT_WRITE, MAP_ANONYMOUS, -1, 0)
+
+void test_mremap_in_place();
+void test_mremap_move();
+void test_munmap_invalid();
+
+int main(int argc, char**argv){
+    test_mremap_in_place();
+    test_mremap_move();
+    test_munmap_invalid();
+    return 0;
+}
+
+/*pages unmapped from the end of mapping are taken back by mremap*/
+void test_mremap_in_place(){
+    int ret;
+    int pagesize = sysconf(_SC_PAGE_SIZE);
+    char* addr;
+    char* addr2;
+    TEST_OPERATION_RESULT( (addr=MAP_ANON_RW(pagesize*4))!=MAP_FAILED, &ret, ret==1);
+    memset(addr, 'a', pagesize*4);
+    /*partial unmap*/
+    TEST_OPERATION_RESULT( munmap(addr+pagesize*2, pagesize*2), &ret, ret==0);
+    TEST_OPERATION_RESULT( (addr2=mremap(addr, pagesize*2, pagesize*4, 0))==addr, &ret, ret==1);
+    CMP_MEM_DATA(addr, addr+pagesize, pagesize);
+    memset(addr+pagesize*2, 'b', pagesize*2);
+    /*shrink and grow back*/
+    TEST_OPERATION_RESULT( (addr2=mremap(addr, pagesize*4, pagesize, 0))==addr, &ret, ret==1);
+    TEST_OPERATION_RESULT( (addr2=mremap(addr, pagesize, pagesize*3, 0))==addr, &ret, ret==1);
+    TEST_OPERATION_RESULT( addr[pagesize-1]=='a', &ret, ret==1);
+    TEST_OPERATION_RESULT( munmap(addr, pagesize*3), &ret, ret==0);
+}
+
+/*pages next to mapping are busy, so mapping can only be moved*/
+void test_mremap_move(){
+    int ret;
+    int pagesize = sysconf(_SC_PAGE_SIZE);
+    char* addr;
+    char* addr2;
+    TEST_OPERATION_RESULT( (addr=MAP_ANON_RW(pagesize*4))!=MAP_FAILED, &ret, ret==1);
+    memset(addr, 'c', pagesize*2);
+    /*last two pages are used as guard*/
+    TEST_OPERATION_RESULT( mremap(addr, pagesize*2, pagesize*3, 0)==MAP_FAILED, &ret, ret==1);
+    TEST_OPERATION_RESULT( errno==ENOMEM, &ret, ret==1);
+    TEST_OPERATION_RESULT( (addr2=mremap(addr, pagesize*2, pagesize*3, MREMAP_MAYMOVE))!=MAP_FAILED, 
+			   &ret, ret==1);
+    TEST_OPERATION_RESULT( addr2!=addr, &ret, ret==1);
+    TEST_OPERATION_RESULT( addr2[0]=='c' && addr2[pagesize*2-1]=='c', &ret, ret==1);
+    /*unsupported flags*/
+    TEST_OPERATION_RESULT( mremap(addr2, pagesize*3, pagesize*4, MREMAP_FIXED)==MAP_FAILED, &ret, ret==1);
+    TEST_OPERATION_RESULT( errno==EINVAL, &ret, ret==1);
+    TEST_OPERATION_RESULT( munmap(addr2, pagesize*3), &ret, ret==0);
+    TEST_OPERATION_RESULT( munmap(addr+pagesize*2, pagesize*2), &ret, ret==0);
+}
+
+/*unaligned address and address out of mmap region are rejected*/
+void test_munmap_invalid(){
+    int ret;
+    int pagesize = sysconf(_SC_PAGE_SIZE);
+    char* addr;
+    TEST_OPERATION_RESULT( (addr=MAP_ANON_RW(pagesize*3))!=MAP_FAILED, &ret, ret==1);
+    memset(addr, 'd', pagesize*3);
+    TEST_OPERATION_RESULT( munmap(addr+1, pagesize), &ret, ret==-1&&errno==EINVAL);
+    TEST_OPERATION_RESULT( munmap(addr, 0), &ret, ret==-1&&errno==EINVAL);
+    TEST_OPERATION_RESULT( munmap((void*)(intptr_t)pagesize, pagesize), &ret, ret==-1&&errno==EINVAL);
+    /*nothing was unmapped*/
+    TEST_OPERATION_RESULT( addr[0]=='d' && addr[pagesize*3-1]=='d', &ret, ret==1);
+    TEST_OPERATION_RESULT( munmap(addr, pagesize*3), &ret, ret==0);
+}
@@ -0,0 +1,169 @@
+/*
+ * vectored i/o functions testing: readv, writev, preadv, pwritev
+ *
+ * Copyright (c) 2013, LiteStack, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <string.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <error.h>
+#include <errno.h>
+
+#include "macro_tests.h"
+
+#define FILENAME "/readv_writev_file"
+#define PART1 "first part,"
+#define PART2 "second part,"
+#define PART3 "third part"
+#define ALL_PARTS PART1 PART2 PART3
+
+#define SET_IOVEC(iov_p, buf, size) (iov_p)->iov_base=(buf), (iov_p)->iov_len=(size)
+/*bigger than internal staging buffer of channels*/
+#define BIG_IOVEC_SIZE 0x100000
+
+void test_memfs_vectored_io();
+void test_channels_vectored_io();
+void test_channels_big_vectored_io();
+
+int main(int argc, char**argv){
+    test_memfs_vectored_io();
+    test_channels_vectored_io();
+    test_channels_big_vectored_io();
+    return 0;
+}
+
+void test_memfs_vectored_io(){
+    int fd, ret;
+    struct iovec iov[3];
+    char buf1[sizeof(PART1)-1];
+    char buf2[sizeof(PART2)-1];
+    char buf3[100];
+    struct stat st;
+
+    TEST_OPERATION_RESULT( open(FILENAME, O_RDWR|O_CREAT, S_IRWXU), &fd, fd!=-1);
+    SET_IOVEC(&iov[0], PART1, sizeof(PART1)-1);
+    SET_IOVEC(&iov[1], PART2, sizeof(PART2)-1);
+    SET_IOVEC(&iov[2], PART3, sizeof(PART3)-1);
+    TEST_OPERATION_RESULT( writev(fd, iov, 3), &ret, ret==sizeof(ALL_PARTS)-1);
+    TEST_OPERATION_RESULT( lseek(fd, 0, SEEK_CUR), &ret, ret==sizeof(ALL_PARTS)-1);
+    TEST_OPERATION_RESULT( fstat(fd, &st), &ret, ret==0&&st.st_size==sizeof(ALL_PARTS)-1);
+
+    /*read back file by parts, last buffer is bigger than rest of data*/
+    TEST_OPERATION_RESULT( lseek(fd, 0, SEEK_SET), &ret, ret==0);
+    memset(buf3, '\0', sizeof(buf3));
+    SET_IOVEC(&iov[0], buf1, sizeof(buf1));
+    SET_IOVEC(&iov[1], buf2, sizeof(buf2));
+    SET_IOVEC(&iov[2], buf3, sizeof(buf3));
+    TEST_OPERATION_RESULT( readv(fd, iov, 3), &ret, ret==sizeof(ALL_PARTS)-1);
+    CMP_MEM_DATA(buf1, PART1, sizeof(buf1));
+    CMP_MEM_DATA(buf2, PART2, sizeof(buf2));
+    CMP_MEM_DATA(buf3, PART3, sizeof(PART3));
+    TEST_OPERATION_RESULT( readv(fd, iov, 3), &ret, ret==0);
+
+    /*positional variants should not change file position*/
+    TEST_OPERATION_RESULT( lseek(fd, 5, SEEK_SET), &ret, ret==5);
+    SET_IOVEC(&iov[0], PART2, sizeof(PART2)-1);
+    TEST_OPERATION_RESULT( pwritev(fd, iov, 1, 0), &ret, ret==sizeof(PART2)-1);
+    TEST_OPERATION_RESULT( lseek(fd, 0, SEEK_CUR), &ret, ret==5);
+    SET_IOVEC(&iov[0], buf2, sizeof(buf2));
+    TEST_OPERATION_RESULT( preadv(fd, iov, 1, 0), &ret, ret==sizeof(buf2));
+    CMP_MEM_DATA(buf2, PART2, sizeof(buf2));
+    TEST_OPERATION_RESULT( lseek(fd, 0, SEEK_CUR), &ret, ret==5);
+
+    /*write beyond end of file pads gap by zeros*/
+    SET_IOVEC(&iov[0], PART1, sizeof(PART1)-1);
+    TEST_OPERATION_RESULT( pwritev(fd, iov, 1, 100), &ret, ret==sizeof(PART1)-1);
+    TEST_OPERATION_RESULT( fstat(fd, &st), &ret, ret==0&&st.st_size==100+sizeof(PART1)-1);
+
+    /*invalid params*/
+    TEST_OPERATION_RESULT( readv(fd, iov, -1), &ret, ret==-1&&errno==EINVAL);
+    TEST_OPERATION_RESULT( preadv(fd, iov, 1, -1), &ret, ret==-1&&errno==EINVAL);
+    CLOSE_FILE(fd);
+    TEST_OPERATION_RESULT( writev(fd, iov, 1), &ret, ret==-1&&errno==EBADF);
+    REMOVE_EXISTING_FILEPATH(FILENAME);
+}
+
+void test_channels_vectored_io(){
+    int fd, ret;
+    struct iovec iov[2];
+    char buf1[100];
+    char buf2[200];
+    char zeros[200];
+    memset(zeros, '\0', sizeof(zeros));
+
+    TEST_OPERATION_RESULT( open("/dev/zero", O_RDWR), &fd, fd!=-1);
+    memset(buf1, 'a', sizeof(buf1));
+    memset(buf2, 'b', sizeof(buf2));
+    SET_IOVEC(&iov[0], buf1, sizeof(buf1));
+    SET_IOVEC(&iov[1], buf2, sizeof(buf2));
+    TEST_OPERATION_RESULT( readv(fd, iov, 2), &ret, ret==sizeof(buf1)+sizeof(buf2));
+    CMP_MEM_DATA(buf1, zeros, sizeof(buf1));
+    CMP_MEM_DATA(buf2, zeros, sizeof(buf2));
+    /*sequential channel is not supporting positional access*/
+    TEST_OPERATION_RESULT( preadv(fd, iov, 2, 0), &ret, ret==-1&&errno==ESPIPE);
+    CLOSE_FILE(fd);
+
+    TEST_OPERATION_RESULT( open("/dev/null", O_WRONLY), &fd, fd!=-1);
+    TEST_OPERATION_RESULT( writev(fd, iov, 2), &ret, ret==sizeof(buf1)+sizeof(buf2));
+    TEST_OPERATION_RESULT( pwritev(fd, iov, 2, 0), &ret, ret==-1&&errno==ESPIPE);
+    CLOSE_FILE(fd);
+
+    TEST_OPERATION_RESULT( open("/dev/full", O_WRONLY), &fd, fd!=-1);
+    TEST_OPERATION_RESULT( writev(fd, iov, 2), &ret, ret==-1&&errno==ENOSPC);
+    CLOSE_FILE(fd);
+}
+
+/*small and big iovecs mixed, total size is bigger than staging buffer*/
+void test_channels_big_vectored_io(){
+    static char big1[BIG_IOVEC_SIZE];
+    static char big2[BIG_IOVEC_SIZE];
+    static char zeros[BIG_IOVEC_SIZE];
+    int fd, ret;
+    struct iovec iov[5];
+    char small1[10];
+    char small2[20];
+    char small3[30];
+    memset(big1, 'a', sizeof(big1));
+    memset(big2, 'b', sizeof(big2));
+    memset(small1, 'c', sizeof(small1));
+    memset(small2, 'd', sizeof(small2));
+    memset(small3, 'e', sizeof(small3));
+    SET_IOVEC(&iov[0], small1, sizeof(small1));
+    SET_IOVEC(&iov[1], big1, sizeof(big1));
+    SET_IOVEC(&iov[2], small2, sizeof(small2));
+    SET_IOVEC(&iov[3], small3, sizeof(small3));
+    SET_IOVEC(&iov[4], big2, sizeof(big2));
+
+    TEST_OPERATION_RESULT( open("/dev/zero", O_RDONLY), &fd, fd!=-1);
+    TEST_OPERATION_RESULT( readv(fd, iov, 5), &ret, 
+			   ret==sizeof(small1)+sizeof(small2)+sizeof(small3)+2*BIG_IOVEC_SIZE);
+    CMP_MEM_DATA(small1, zeros, sizeof(small1));
+    CMP_MEM_DATA(big1, zeros, sizeof(big1));
+    CMP_MEM_DATA(small2, zeros, sizeof(small2));
+    CMP_MEM_DATA(small3, zeros, sizeof(small3));
+    CMP_MEM_DATA(big2, zeros, sizeof(big2));
+    CLOSE_FILE(fd);
+
+    TEST_OPERATION_RESULT( open("/dev/null", O_WRONLY), &fd, fd!=-1);
+    TEST_OPERATION_RESULT( writev(fd, iov, 5), &ret, 
+			   ret==sizeof(small1)+sizeof(small2)+sizeof(small3)+2*BIG_IOVEC_SIZE);
+    CLOSE_FILE(fd);
+}
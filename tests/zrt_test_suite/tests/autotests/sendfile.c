@@ -0,0 +1,129 @@
+/*
+ * sendfile testing: channel to memfs, memfs to memfs, channel to channel,
+ * copy into hardlink of source
+ *
+ * Copyright (c) 2013, LiteStack, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/sendfile.h>
+#include <string.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <error.h>
+#include <errno.h>
+
+#include "macro_tests.h"
+
+#define FILENAME1 "/sendfile_file1"
+#define FILENAME2 "/sendfile_file2"
+#define HARDLINK "/sendfile_hardlink"
+#define TEXT "sendfile copies data without user buffers"
+#define ZEROES_COUNT 3000000 /*bigger than internal chunk*/
+
+void test_channel_to_memfs();
+void test_memfs_to_memfs();
+void test_channel_to_channel();
+void test_memfs_to_hardlink();
+
+int main(int argc, char**argv){
+    test_channel_to_memfs();
+    test_memfs_to_memfs();
+    test_channel_to_channel();
+    test_memfs_to_hardlink();
+    return 0;
+}
+
+void test_channel_to_memfs(){
+    int in, out, ret;
+    struct stat st;
+    char buf[100];
+    TEST_OPERATION_RESULT( open("/dev/zero", O_RDONLY), &in, in!=-1);
+    TEST_OPERATION_RESULT( open(FILENAME1, O_RDWR|O_CREAT, S_IRWXU), &out, out!=-1);
+    TEST_OPERATION_RESULT( write(out, TEXT, sizeof(TEXT)-1), &ret, ret==sizeof(TEXT)-1);
+    TEST_OPERATION_RESULT( sendfile(out, in, NULL, ZEROES_COUNT), &ret, ret==ZEROES_COUNT);
+    TEST_OPERATION_RESULT( lseek(out, 0, SEEK_CUR), &ret, ret==sizeof(TEXT)-1+ZEROES_COUNT);
+    TEST_OPERATION_RESULT( fstat(out, &st), &ret, ret==0&&st.st_size==sizeof(TEXT)-1+ZEROES_COUNT);
+    TEST_OPERATION_RESULT( pread(out, buf, sizeof(buf), 0), &ret, ret==sizeof(buf));
+    CMP_MEM_DATA(buf, TEXT, sizeof(TEXT)-1);
+    TEST_OPERATION_RESULT( buf[sizeof(TEXT)-1]=='\0', &ret, ret==1);
+    /*destination channel opened only for reading*/
+    TEST_OPERATION_RESULT( sendfile(in, out, NULL, 10), &ret, ret==-1);
+    TEST_OPERATION_RESULT( sendfile(out, -1, NULL, 10), &ret, ret==-1&&errno==EBADF);
+    close(in);
+    close(out);
+}
+
+void test_memfs_to_memfs(){
+    int in, out, ret;
+    off_t offset;
+    char buf[100];
+    TEST_OPERATION_RESULT( open(FILENAME1, O_RDONLY), &in, in!=-1);
+    TEST_OPERATION_RESULT( open(FILENAME2, O_RDWR|O_CREAT, S_IRWXU), &out, out!=-1);
+    /*copy starting from offset, input file position must stay unchanged*/
+    offset = 9;
+    TEST_OPERATION_RESULT( sendfile(out, in, &offset, sizeof(TEXT)-1-9), &ret, ret==sizeof(TEXT)-1-9);
+    TEST_OPERATION_RESULT( offset==sizeof(TEXT)-1, &ret, ret==1);
+    TEST_OPERATION_RESULT( lseek(in, 0, SEEK_CUR), &ret, ret==0);
+    TEST_OPERATION_RESULT( pread(out, buf, sizeof(buf), 0), &ret, ret==sizeof(TEXT)-1-9);
+    CMP_MEM_DATA(buf, TEXT+9, sizeof(TEXT)-1-9);
+    /*copy up to EOF of input*/
+    TEST_OPERATION_RESULT( lseek(in, -10, SEEK_END), &ret, ret!=-1);
+    TEST_OPERATION_RESULT( sendfile(out, in, NULL, 100), &ret, ret==10);
+    TEST_OPERATION_RESULT( sendfile(out, in, NULL, 100), &ret, ret==0);
+    /*the same file can't be both source and destination*/
+    TEST_OPERATION_RESULT( sendfile(out, out, NULL, 10), &ret, ret==-1&&errno==EINVAL);
+    close(in);
+    close(out);
+    remove(FILENAME1);
+    remove(FILENAME2);
+}
+
+void test_channel_to_channel(){
+    int in, out, ret;
+    TEST_OPERATION_RESULT( open("/dev/zero", O_RDONLY), &in, in!=-1);
+    TEST_OPERATION_RESULT( open("/dev/null", O_WRONLY), &out, out!=-1);
+    TEST_OPERATION_RESULT( sendfile(out, in, NULL, ZEROES_COUNT), &ret, ret==ZEROES_COUNT);
+    close(in);
+    close(out);
+}
+
+void test_memfs_to_hardlink(){
+    int in, out, ret;
+    struct stat in_st, out_st;
+    char buf[sizeof(TEXT)];
+    TEST_OPERATION_RESULT( open(FILENAME1, O_RDWR|O_CREAT, S_IRWXU), &in, in!=-1);
+    TEST_OPERATION_RESULT( write(in, TEXT, sizeof(TEXT)-1), &ret, ret==sizeof(TEXT)-1);
+    TEST_OPERATION_RESULT( link(FILENAME1, HARDLINK), &ret, ret==0);
+    TEST_OPERATION_RESULT( open(HARDLINK, O_RDWR), &out, out!=-1);
+    /*both hardlinks share the same data and the same inode*/
+    TEST_OPERATION_RESULT( fstat(in, &in_st), &ret, ret==0);
+    TEST_OPERATION_RESULT( fstat(out, &out_st), &ret, ret==0);
+    TEST_OPERATION_RESULT( in_st.st_ino==out_st.st_ino, &ret, ret==1);
+    /*source and destination are the same file*/
+    TEST_OPERATION_RESULT( lseek(out, 0, SEEK_END), &ret, ret==sizeof(TEXT)-1);
+    TEST_OPERATION_RESULT( lseek(in, 0, SEEK_SET), &ret, ret==0);
+    TEST_OPERATION_RESULT( sendfile(out, in, NULL, ZEROES_COUNT), &ret, ret==-1&&errno==EINVAL);
+    TEST_OPERATION_RESULT( fstat(in, &in_st), &ret, ret==0&&in_st.st_size==sizeof(TEXT)-1);
+    TEST_OPERATION_RESULT( pread(in, buf, sizeof(buf), 0), &ret, ret==sizeof(TEXT)-1);
+    CMP_MEM_DATA(buf, TEXT, sizeof(TEXT)-1);
+    close(in);
+    close(out);
+    remove(HARDLINK);
+    remove(FILENAME1);
+}
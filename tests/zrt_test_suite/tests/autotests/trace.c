@@ -0,0 +1,142 @@
+/*
+ * trace api testing, spans and counters should not affect
+ * program whether tracing enabled or not
+ *
+ * Copyright (c) 2013, LiteStack, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <string.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <error.h>
+#include <errno.h>
+#include <stdlib.h>
+
+#include <zrtapi.h>
+#include "macro_tests.h"
+#include "helpers/trace.h" /*TRACE_MAX_EVENTS*/
+
+#define FILENAME "/trace_file"
+#define TEXT "traced data"
+/*more than trace events buffer can keep*/
+#define SPANS_COUNT 0x4000
+/*set by nvram [debug] trace key*/
+#define TRACE_FILENAME "/trace.json"
+#define JSON_HEADER "{\"traceEvents\":["
+#define JSON_DROPPED "\"dropped_events\":"
+/*events recorded by test before trace is written, zcalls are not
+ *traced because of nvram tracethreshold, but some zcalls of prolog
+ *can be traced before nvram was handled*/
+#define USER_EVENTS_COUNT (1 + 7 + SPANS_COUNT*3)
+
+void test_nested_spans_around_zcalls();
+void test_spans_overflow();
+void test_trace_file();
+
+int main(int argc, char**argv){
+    zrt_trace_begin("test_main");
+    test_nested_spans_around_zcalls();
+    test_spans_overflow();
+    test_trace_file();
+    /*tracing is already stopped*/
+    zrt_trace_end("test_main");
+    return 0;
+}
+
+void test_nested_spans_around_zcalls(){
+    int fd, ret;
+    char buf[sizeof(TEXT)];
+    zrt_trace_begin("write_file");
+    TEST_OPERATION_RESULT( open(FILENAME, O_RDWR|O_CREAT, S_IRWXU), &fd, fd!=-1);
+    zrt_trace_begin("write");
+    TEST_OPERATION_RESULT( write(fd, TEXT, sizeof(TEXT)-1), &ret, ret==sizeof(TEXT)-1);
+    zrt_trace_end("write");
+    zrt_trace_counter("written_bytes", ret);
+    zrt_trace_end("write_file");
+
+    zrt_trace_begin("read \"quoted\" \\ name");
+    TEST_OPERATION_RESULT( pread(fd, buf, sizeof(buf), 0), &ret, ret==sizeof(TEXT)-1);
+    CMP_MEM_DATA(buf, TEXT, sizeof(TEXT)-1);
+    zrt_trace_end("read \"quoted\" \\ name");
+    TEST_OPERATION_RESULT( close(fd), &ret, ret==0);
+}
+
+void test_spans_overflow(){
+    int i, ret;
+    struct stat st;
+    /*events that doesn't fit are dropped and counted*/
+    for ( i=0; i < SPANS_COUNT; i++ ){
+	zrt_trace_begin("span");
+	zrt_trace_counter("counter", i);
+	zrt_trace_end("span");
+    }
+    /*zcalls are still working*/
+    TEST_OPERATION_RESULT( stat(FILENAME, &st), &ret, ret==0);
+    TEST_OPERATION_RESULT( st.st_size, &ret, ret==sizeof(TEXT)-1);
+}
+
+/*count not overlapped occurences of substring*/
+static int count_substr(const char* str, const char* substr){
+    int count=0;
+    while ( (str = strstr(str, substr)) != NULL ){
+	++count;
+	str += strlen(substr);
+    }
+    return count;
+}
+
+/*write trace, read it back and check JSON*/
+void test_trace_file(){
+    int fd, ret, events;
+    struct stat st;
+    char* json;
+    char* dropped_str;
+    unsigned long long dropped;
+    TEST_OPERATION_RESULT( zrt_trace_write(), &ret, ret==0);
+    TEST_OPERATION_RESULT( stat(TRACE_FILENAME, &st), &ret, ret==0);
+    TEST_OPERATION_RESULT( st.st_size > 0, &ret, ret==1);
+    json = malloc(st.st_size+1);
+    TEST_OPERATION_RESULT( json != NULL, &ret, ret==1);
+    TEST_OPERATION_RESULT( open(TRACE_FILENAME, O_RDONLY), &fd, fd!=-1);
+    TEST_OPERATION_RESULT( read(fd, json, st.st_size), &ret, ret==st.st_size);
+    TEST_OPERATION_RESULT( close(fd), &ret, ret==0);
+    json[st.st_size] = '\0';
+
+    /*shape of JSON*/
+    TEST_OPERATION_RESULT( strncmp(json, JSON_HEADER, strlen(JSON_HEADER)), &ret, ret==0);
+    TEST_OPERATION_RESULT( strcmp(json+st.st_size-3, "}}\n"), &ret, ret==0);
+    TEST_OPERATION_RESULT( strstr(json, "\"otherData\":{") != NULL, &ret, ret==1);
+    TEST_OPERATION_RESULT( strstr(json, "\"name\":\"read \\\"quoted\\\" \\\\ name\",\"ph\":\"B\"") 
+			   != NULL, &ret, ret==1);
+    TEST_OPERATION_RESULT( strstr(json, "\"name\":\"written_bytes\",\"ph\":\"C\"") 
+			   != NULL, &ret, ret==1);
+
+    /*buffer is full and the rest of events are counted as dropped*/
+    events = count_substr(json, "\"ph\":\"");
+    TEST_OPERATION_RESULT( events, &ret, ret==TRACE_MAX_EVENTS);
+    dropped_str = strstr(json, JSON_DROPPED);
+    TEST_OPERATION_RESULT( dropped_str != NULL, &ret, ret==1);
+    dropped = strtoull(dropped_str+strlen(JSON_DROPPED), NULL, 10);
+    TEST_OPERATION_RESULT( events + dropped >= USER_EVENTS_COUNT, &ret, ret==1);
+    TEST_OPERATION_RESULT( events + dropped < USER_EVENTS_COUNT + TRACE_MAX_EVENTS, &ret, ret==1);
+    free(json);
+
+    /*tracing is stopped, nothing to write again*/
+    TEST_OPERATION_RESULT( zrt_trace_write(), &ret, ret==0);
+}
@@ -0,0 +1,111 @@
+/*
+ * malloc microbenchmark: small objects churn, growing buffers, big blocks
+ *
+ * Copyright (c) 2013, LiteStack, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <unistd.h>
+#include <sys/types.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <error.h>
+#include <errno.h>
+
+#include "macro_tests.h"
+#include "bench_helpers.h"
+
+/*The same benchmark is linked with -lzrtmalloc as malloc_bench_slab.c
+ *(see LDFLAGS in tests Makefile) to compare it with default malloc*/
+
+#define OBJECTS_COUNT 4096
+#define ITERATIONS 1000000
+#define GROWING_BUFFERS 16
+#define GROWING_MAX_SIZE (1024*1024*4)
+#define BIG_BLOCK_SIZE (1024*512)
+
+static char* s_objects[OBJECTS_COUNT];
+
+/*random free/malloc of objects up to 256 bytes*/
+uint64_t bench_small_objects(){
+    int i, ret;
+    unsigned seed = 1;
+    uint64_t start = ticks();
+    for ( i=0; i < ITERATIONS; i++ ){
+	int index;
+	size_t size;
+	seed = seed*1103515245 + 12345;
+	index = (seed >> 8) % OBJECTS_COUNT;
+	size = (seed >> 20) % 256 + 1;
+	free(s_objects[index]);
+	s_objects[index] = malloc(size);
+	TEST_OPERATION_RESULT( s_objects[index] != NULL, &ret, ret==1 );
+	s_objects[index][size-1] = 1;
+    }
+    for ( i=0; i < OBJECTS_COUNT; i++ ){
+	free(s_objects[i]);
+	s_objects[i] = NULL;
+    }
+    return ticks() - start;
+}
+
+/*buffers growing by realloc like vectors*/
+uint64_t bench_growing_buffers(){
+    int i, ret;
+    char* buffers[GROWING_BUFFERS] = {NULL};
+    size_t size;
+    uint64_t start = ticks();
+    for ( size = 64; size <= GROWING_MAX_SIZE; size += size/2 ){
+	for ( i=0; i < GROWING_BUFFERS; i++ ){
+	    buffers[i] = realloc(buffers[i], size);
+	    TEST_OPERATION_RESULT( buffers[i] != NULL, &ret, ret==1 );
+	    buffers[i][size-1] = 1;
+	}
+    }
+    for ( i=0; i < GROWING_BUFFERS; i++ )
+	free(buffers[i]);
+    return ticks() - start;
+}
+
+uint64_t bench_big_blocks(){
+    int i, ret;
+    char* block;
+    uint64_t start = ticks();
+    for ( i=0; i < ITERATIONS/100; i++ ){
+	block = malloc(BIG_BLOCK_SIZE);
+	TEST_OPERATION_RESULT( block != NULL, &ret, ret==1 );
+	block[BIG_BLOCK_SIZE-1] = 1;
+	free(block);
+    }
+    return ticks() - start;
+}
+
+int main(int argc, char**argv){
+    int ret;
+    void* aligned;
+    /*check alignment contract*/
+    TEST_OPERATION_RESULT( posix_memalign(&aligned, 64, 100), &ret, ret==0 );
+    TEST_OPERATION_RESULT( (uintptr_t)aligned % 64, &ret, ret==0 );
+    free(aligned);
+
+    fprintf(stderr, "%s: small objects %llu ticks\n", argv[0],
+	    (unsigned long long)bench_small_objects());
+    fprintf(stderr, "%s: growing buffers %llu ticks\n", argv[0],
+	    (unsigned long long)bench_growing_buffers());
+    fprintf(stderr, "%s: big blocks %llu ticks\n", argv[0],
+	    (unsigned long long)bench_big_blocks());
+    return 0;
+}
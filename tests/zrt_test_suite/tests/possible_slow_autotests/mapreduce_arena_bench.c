@@ -0,0 +1,64 @@
+/*
+ * mapreduce microbenchmark: allocation of map keys by malloc and freeing
+ * every key against allocation from map arena freed at once, prints
+ * ticks spent
+ *
+ * Copyright (c) 2013, LiteStack, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "map_arena.h"
+#include "bench_helpers.h"
+
+#define KEYS_COUNT 1000000
+#define CHUNKS_COUNT 10
+
+int main(int argc, char**argv){
+    char **keys = malloc( KEYS_COUNT*sizeof(char*) );
+    char key[32];
+    uint64_t start, malloc_ticks = 0, arena_ticks = 0;
+    int chunk, i, len;
+
+    for ( chunk=0; chunk < CHUNKS_COUNT; chunk++ ){
+	start = ticks();
+	for ( i=0; i < KEYS_COUNT; i++ ){
+	    len = sprintf( key, "word%d", i );
+	    keys[i] = malloc( len+1 );
+	    memcpy( keys[i], key, len+1 );
+	}
+	for ( i=0; i < KEYS_COUNT; i++ ){
+	    free(keys[i]);
+	}
+	malloc_ticks += ticks() - start;
+
+	start = ticks();
+	for ( i=0; i < KEYS_COUNT; i++ ){
+	    len = sprintf( key, "word%d", i );
+	    keys[i] = MapArenaDup( key, len );
+	}
+	MapArenaReset();
+	arena_ticks += ticks() - start;
+    }
+    MapArenaFree();
+    free(keys);
+    fprintf(stderr, "%d chunks of %d keys: malloc %llu ticks, arena %llu ticks\n",
+	    CHUNKS_COUNT, KEYS_COUNT, (unsigned long long)malloc_ticks,
+	    (unsigned long long)arena_ticks);
+    return 0;
+}
@@ -0,0 +1,122 @@
+/*
+ * mapreduce microbenchmark: map chunk processing with sort and Combine
+ * against hash aggregation by Fold, prints ticks spent
+ *
+ * Copyright (c) 2013, LiteStack, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <error.h>
+#include <errno.h>
+#include <assert.h>
+#include <alloca.h>
+
+#include "macro_tests.h"
+#include "map_reduce_lib.h"
+#include "hash_fold.h"
+#include "elastic_mr_item.h"
+#include "mr_defines.h"
+#include "buffer.h"
+#include "bench_helpers.h"
+
+#define ITEMS_COUNT 1000000
+#define HASH_TYPE  uint32_t
+#define ITEM_SIZE sizeof(				\
+			 struct{			\
+			     BinaryData     key_data;	\
+			     BinaryData     value;	\
+			     uint8_t        own_key;	\
+			     uint8_t        own_value;  \
+			     HASH_TYPE      key_hash;	\
+			 })
+
+static int s_distinct;
+
+/*every call emits the same items, like word count with s_distinct words*/
+static int
+Map( const char *data, size_t size, int last_chunk, Buffer *map_buffer ){
+    srand(s_distinct);
+    AddBufferItemsHash32( map_buffer, ITEMS_COUNT, s_distinct );
+    return size;
+}
+
+static int
+Fold( ElasticBufItemData *accumulated, const ElasticBufItemData *item ){
+    accumulated->value.addr += item->value.addr;
+    return 0;
+}
+
+static int
+Combine( const Buffer *map_buffer, Buffer *reduce_buffer ){
+    ElasticBufItemData *current, *combine = alloca(map_buffer->header.item_size);
+    int i;
+    for ( i=0; i < map_buffer->header.count; i++ ){
+	current = (ElasticBufItemData*)BufferItemPointer( map_buffer, i );
+	if ( i == 0 ){
+	    memcpy( combine, current, map_buffer->header.item_size );
+	}
+	else if ( ItemHash32(current) != ItemHash32(combine) ){
+	    AddBufferItem( reduce_buffer, combine );
+	    memcpy( combine, current, map_buffer->header.item_size );
+	}
+	else{
+	    combine->value.addr += current->value.addr;
+	}
+    }
+    if ( map_buffer->header.count ){
+	AddBufferItem( reduce_buffer, combine );
+    }
+    return 0;
+}
+
+static uint64_t
+ProcessChunk( struct MapReduceUserIf *mif, int *count ){
+    Buffer result;
+    uint64_t start = ticks();
+    MapInputDataLocalProcessing( mif, "", 0, 1, &result );
+    start = ticks() - start;
+    *count = result.header.count;
+    FreeBufferData(&result);
+    return start;
+}
+
+static void
+Bench( int distinct ){
+    struct MapReduceUserIf mif;
+    uint64_t combine_ticks, fold_ticks;
+    int combine_count, fold_count;
+    s_distinct = distinct;
+    PREPARE_MAPREDUCE( &mif, Map, Combine, NULL,
+		       NULL, /*radix sort by default hash order*/
+		       NULL, NULL, 1, ITEM_SIZE, sizeof(HASH_TYPE) );
+    combine_ticks = ProcessChunk( &mif, &combine_count );
+    mif.Fold = Fold;
+    fold_ticks = ProcessChunk( &mif, &fold_count );
+    assert( combine_count == fold_count );
+    fprintf(stderr, "%d items, %d distinct: sort+combine %llu ticks, fold %llu ticks\n",
+	    ITEMS_COUNT, combine_count, (unsigned long long)combine_ticks,
+	    (unsigned long long)fold_ticks);
+}
+
+int main(int argc, char**argv){
+    Bench(100);
+    Bench(10000);
+    /*more distinct hashes than table holds, fold falls back to combine*/
+    Bench(1000000);
+    return 0;
+}
@@ -0,0 +1,123 @@
+/*
+ * mapreduce microbenchmark: merge and distribution of map items into
+ * reducers baskets with built-in comparators specialized by hash size
+ * against generic comparison, prints ticks spent
+ *
+ * Copyright (c) 2013, LiteStack, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <error.h>
+#include <errno.h>
+#include <assert.h>
+#include <alloca.h>
+
+#include "macro_tests.h"
+#include "map_reduce_lib.h"
+#include "elastic_mr_item.h"
+#include "mr_defines.h"
+#include "buffer.h"
+#include "bench_helpers.h"
+
+#define ITEMS_COUNT 1000000
+#define SOURCES_COUNT 16
+#define REDUCERS_COUNT 64
+#define REPEATS 5
+
+/*library internal*/
+struct BasketInfo*
+DistributeDataIntoBaskets(struct MapReduceUserIf *mif, const Buffer *map, int basket_count);
+
+/*get ticks of merge of two buffers, of all buffers and distribution*/
+static void
+Run(struct MapReduceUserIf *mif, Buffer *sources, uint64_t *merge2_ticks,
+    uint64_t *merge_ticks, uint64_t *distribute_ticks ){
+    Buffer merged;
+    uint64_t start;
+    start = ticks();
+    MergeBuffersToNew( mif, &merged, sources, 2 );
+    *merge2_ticks = ticks() - start;
+    FreeBufferData(&merged);
+
+    start = ticks();
+    MergeBuffersToNew( mif, &merged, sources, SOURCES_COUNT );
+    *merge_ticks = ticks() - start;
+
+    start = ticks();
+    free( DistributeDataIntoBaskets( mif, &merged, REDUCERS_COUNT ) );
+    *distribute_ticks = ticks() - start;
+    FreeBufferData(&merged);
+}
+
+static void
+Bench(int hash_size){
+    struct MapReduceUserIf mif;
+    Buffer sources[SOURCES_COUNT];
+    uint64_t merge2[2], merge[2], distribute[2];
+    uint64_t m2, m, d;
+    uint8_t *divider = alloca(hash_size);
+    int i, ret, cmp_hash_size;
+
+    PREPARE_MAPREDUCE( &mif, NULL, NULL, NULL, NULL, NULL, NULL,
+		       1, HASHED_ITEM_SIZE(hash_size), hash_size );
+    srand(hash_size);
+    for ( i=0; i < SOURCES_COUNT; i++ ){
+	FillBufferRandomHashes( &sources[i], hash_size, ITEMS_COUNT/SOURCES_COUNT, 256 );
+	LocalSort( &mif, &sources[i] );
+    }
+    /*dividers split hashes evenly by most significant byte*/
+    ret = AllocBuffer( &mif.data.dividers_list, hash_size, REDUCERS_COUNT );
+    assert(!ret);
+    for ( i=0; i < REDUCERS_COUNT; i++ ){
+	memset( divider, 0xff, hash_size );
+	divider[hash_size-1] = (i+1)*256/REDUCERS_COUNT-1;
+	AddBufferItem( &mif.data.dividers_list, divider );
+    }
+
+    /*minimal ticks of some runs, specialized and generic runs alternate*/
+    cmp_hash_size = mif.data.cmp_hash_size;
+    memset( merge2, 0xff, sizeof(merge2) );
+    memset( merge, 0xff, sizeof(merge) );
+    memset( distribute, 0xff, sizeof(distribute) );
+    for ( i=0; i < REPEATS*2; i++ ){
+	/*generic comparison for odd runs*/
+	mif.data.cmp_hash_size = i%2 ? 0 : cmp_hash_size;
+	Run( &mif, sources, &m2, &m, &d );
+	merge2[i%2] = MIN( merge2[i%2], m2 );
+	merge[i%2] = MIN( merge[i%2], m );
+	distribute[i%2] = MIN( distribute[i%2], d );
+    }
+
+    fprintf(stderr, "hash %d bytes, specialized/generic ticks: merge of 2 %llu/%llu, "
+	    "merge of %d %llu/%llu, distribute %llu/%llu\n", hash_size,
+	    (unsigned long long)merge2[0], (unsigned long long)merge2[1], SOURCES_COUNT,
+	    (unsigned long long)merge[0], (unsigned long long)merge[1],
+	    (unsigned long long)distribute[0], (unsigned long long)distribute[1]);
+    for ( i=0; i < SOURCES_COUNT; i++ ){
+	FreeBufferData(&sources[i]);
+    }
+    FreeBufferData(&mif.data.dividers_list);
+}
+
+int main(int argc, char**argv){
+    Bench(4);
+    Bench(8);
+    Bench(16);
+    Bench(20);
+    return 0;
+}
@@ -0,0 +1,74 @@
+/*
+ * mapreduce microbenchmark: hashing of map keys by library KeyHash
+ * against byte by byte FNV-1a hash often written in Map, prints ticks
+ * spent
+ *
+ * Copyright (c) 2013, LiteStack, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <assert.h>
+
+#include "key_hash.h"
+#include "bench_helpers.h"
+
+#define KEYS_COUNT 1000000
+
+static uint64_t
+Fnv1a64( const void *key, size_t size ){
+    const uint8_t *p = (const uint8_t*)key;
+    uint64_t h = 14695981039346656037ull;
+    size_t i;
+    for ( i=0; i < size; i++ ){
+	h = (h ^ p[i]) * 1099511628211ull;
+    }
+    return h;
+}
+
+static void
+Bench( int key_size ){
+    char *keys = malloc( KEYS_COUNT*key_size );
+    uint64_t start, fnv_ticks, key_hash_ticks, sum = 0;
+    int i;
+    for ( i=0; i < KEYS_COUNT*key_size; i++ ){
+	keys[i] = rand();
+    }
+    start = ticks();
+    for ( i=0; i < KEYS_COUNT; i++ ){
+	sum += Fnv1a64( keys+i*key_size, key_size );
+    }
+    fnv_ticks = ticks() - start;
+    start = ticks();
+    for ( i=0; i < KEYS_COUNT; i++ ){
+	sum += KeyHash64( keys+i*key_size, key_size, 0 );
+    }
+    key_hash_ticks = ticks() - start;
+    fprintf(stderr, "%d keys of %d bytes: fnv1a %llu ticks, KeyHash %llu ticks (%llx)\n",
+	    KEYS_COUNT, key_size, (unsigned long long)fnv_ticks,
+	    (unsigned long long)key_hash_ticks, (unsigned long long)sum);
+    free(keys);
+}
+
+int main(int argc, char**argv){
+    Bench(4);
+    Bench(8);
+    Bench(16);
+    Bench(64);
+    Bench(256);
+    return 0;
+}
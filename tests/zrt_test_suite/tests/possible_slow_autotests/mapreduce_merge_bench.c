@@ -0,0 +1,132 @@
+/*
+ * mapreduce microbenchmark: merge of many sorted buffers by library
+ * MergeBuffersToNew against merge scanning all buffers for minimum on
+ * every item, prints ticks spent
+ *
+ * Copyright (c) 2013, LiteStack, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <error.h>
+#include <errno.h>
+#include <assert.h>
+#include <alloca.h>
+
+#include "macro_tests.h"
+#include "map_reduce_lib.h"
+#include "elastic_mr_item.h"
+#include "mr_defines.h"
+#include "buffer.h"
+#include "bench_helpers.h"
+
+#define ALL_ITEMS_COUNT 1000000
+#define HASH_TYPE  uint32_t
+#define ITEM_SIZE sizeof(				\
+			 struct{			\
+			     BinaryData     key_data;	\
+			     BinaryData     value;	\
+			     uint8_t        own_key;	\
+			     uint8_t        own_value;  \
+			     HASH_TYPE      key_hash;	\
+			 })
+
+static int
+ComparatorHash(const void *h1, const void *h2){
+    if      ( *(HASH_TYPE*)h1 < *(HASH_TYPE*)h2 ) return -1;
+    else if ( *(HASH_TYPE*)h1 > *(HASH_TYPE*)h2 ) return 1;
+    else return 0;
+}
+
+/*merge scanning all buffers for minimal hash*/
+static void
+MergeByScan(struct MapReduceUserIf *mif, Buffer *dest, const Buffer *sources, int count){
+    int pos[count];
+    int i, min;
+    const ElasticBufItemData *item, *min_item;
+    int ret = AllocBuffer( dest, MRITEM_SIZE(mif), ALL_ITEMS_COUNT );
+    assert(!ret);
+    memset(pos, '\0', sizeof(pos));
+    do{
+	min = -1;
+	min_item = NULL;
+	for ( i=0; i < count; i++ ){
+	    if ( pos[i] >= sources[i].header.count ) continue;
+	    item = (const ElasticBufItemData*)BufferItemPointer(&sources[i], pos[i]);
+	    if ( min_item == NULL || HASH_CMP(mif, &item->key_hash, &min_item->key_hash) <= 0 ){
+		min = i;
+		min_item = item;
+	    }
+	}
+	if ( min != -1 ){
+	    AddBufferItem( dest, min_item );
+	    ++pos[min];
+	}
+    }while( min != -1 );
+}
+
+static void
+Bench(struct MapReduceUserIf *mif, int count){
+    Buffer* sources = malloc(sizeof(Buffer)*count);
+    Buffer dest;
+    ElasticBufItemData* item = alloca(ITEM_SIZE);
+    uint64_t start, merge_ticks, scan_ticks;
+    int i, j, ret;
+
+    srand(count);
+    for ( i=0; i < count; i++ ){
+	ret = AllocBuffer( &sources[i], ITEM_SIZE, ALL_ITEMS_COUNT/count );
+	assert(!ret);
+	for ( j=0; j < ALL_ITEMS_COUNT/count; j++ ){
+	    memset(item, '\0', ITEM_SIZE);
+	    *(HASH_TYPE*)&item->key_hash = rand();
+	    AddBufferItem( &sources[i], item );
+	}
+	LocalSort( mif, &sources[i] );
+    }
+
+    start = ticks();
+    MergeBuffersToNew( mif, &dest, sources, count );
+    merge_ticks = ticks() - start;
+    FreeBufferData(&dest);
+
+    start = ticks();
+    MergeByScan( mif, &dest, sources, count );
+    scan_ticks = ticks() - start;
+    FreeBufferData(&dest);
+
+    fprintf(stderr, "merge of %d buffers, %d items: heap %llu ticks, scan %llu ticks\n",
+	    count, ALL_ITEMS_COUNT, (unsigned long long)merge_ticks,
+	    (unsigned long long)scan_ticks);
+    for ( i=0; i < count; i++ ){
+	FreeBufferData(&sources[i]);
+    }
+    free(sources);
+}
+
+int main(int argc, char**argv){
+    struct MapReduceUserIf mif;
+    PREPARE_MAPREDUCE( &mif, NULL, NULL, NULL,
+		       NULL, /*radix sort by default hash order*/
+		       ComparatorHash,
+		       NULL, 1, ITEM_SIZE, sizeof(HASH_TYPE) );
+    Bench(&mif, 2);
+    Bench(&mif, 16);
+    Bench(&mif, 128);
+    Bench(&mif, 512);
+    return 0;
+}
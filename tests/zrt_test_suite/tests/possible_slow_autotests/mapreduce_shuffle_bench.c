@@ -0,0 +1,114 @@
+/*
+ * mapreduce microbenchmark: sending of map items into reducer by
+ * WriteDataToReduce and receiving by RecvDataFromSingleMap through file,
+ * keys are packed in arena or allocated separately, prints ticks spent
+ *
+ * Copyright (c) 2013, LiteStack, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <error.h>
+#include <errno.h>
+#include <assert.h>
+#include <alloca.h>
+
+#include "macro_tests.h"
+#include "map_reduce_lib.h"
+#include "elastic_mr_item.h"
+#include "mr_defines.h"
+#include "buffer.h"
+#include "bench_helpers.h"
+
+#define FILENAME "/shuffle_bench"
+#define ITEMS_COUNT 1000000
+#define HASH_TYPE  uint32_t
+#define ITEM_SIZE sizeof(				\
+			 struct{			\
+			     BinaryData     key_data;	\
+			     BinaryData     value;	\
+			     uint8_t        own_key;	\
+			     uint8_t        own_value;  \
+			     HASH_TYPE      key_hash;	\
+			 })
+
+static void
+Bench(int arena_keys){
+    struct MapReduceUserIf mif;
+    struct ShuffleWriter writer;
+    ElasticBufItemData* item = alloca(ITEM_SIZE);
+    Buffer map, received;
+    char *arena = malloc(ITEMS_COUNT*16);
+    char *cursor = arena;
+    char *packet;
+    uint64_t start, write_ticks, read_ticks;
+    int fd, ret, i;
+
+    PREPARE_MAPREDUCE( &mif, NULL, NULL, NULL, NULL, NULL, NULL,
+		       1, ITEM_SIZE, sizeof(HASH_TYPE) );
+    ret = AllocBuffer( &map, ITEM_SIZE, ITEMS_COUNT );
+    assert(!ret);
+    for ( i=0; i < ITEMS_COUNT; i++ ){
+	memset( item, '\0', ITEM_SIZE );
+	item->key_data.size = sprintf( cursor, "word%d", i );
+	if ( arena_keys ){
+	    item->key_data.addr = (uintptr_t)cursor;
+	    cursor += item->key_data.size;
+	}
+	else{
+	    item->key_data.addr = (uintptr_t)strdup(cursor);
+	}
+	item->value.addr = 1;
+	AddBufferItem( &map, item );
+    }
+
+    TEST_OPERATION_RESULT( open(FILENAME, O_CREAT|O_RDWR|O_TRUNC, S_IRWXU), &fd, fd!=-1 );
+    SHUFFLE_WRITER_INIT( &writer, malloc(SEND_BUFFER_SIZE), SEND_BUFFER_SIZE );
+    start = ticks();
+    WriteDataToReduce( &mif, &writer, fd, &map, 0, ITEMS_COUNT, MAP_NODE_EXCLUDE );
+    write_ticks = ticks() - start;
+    free(writer.staging);
+
+    lseek(fd, 0, SEEK_SET);
+    start = ticks();
+    RecvDataFromSingleMap( &mif, fd, &received, &packet );
+    read_ticks = ticks() - start;
+    TEST_OPERATION_RESULT( received.header.count==ITEMS_COUNT, &ret, ret==1 );
+
+    fprintf(stderr, "%d items, %s keys, %lld bytes: write %llu ticks, read %llu ticks\n",
+	    ITEMS_COUNT, arena_keys ? "arena" : "allocated", (long long)lseek(fd, 0, SEEK_END),
+	    (unsigned long long)write_ticks, (unsigned long long)read_ticks);
+    close(fd);
+    unlink(FILENAME);
+    FreeBufferData(&received);
+    free(packet);
+    if ( !arena_keys ){
+	for ( i=0; i < ITEMS_COUNT; i++ ){
+	    free( (void*)((ElasticBufItemData*)BufferItemPointer(&map, i))->key_data.addr );
+	}
+    }
+    FreeBufferData(&map);
+    free(arena);
+}
+
+int main(int argc, char**argv){
+    Bench(1);
+    Bench(0);
+    return 0;
+}
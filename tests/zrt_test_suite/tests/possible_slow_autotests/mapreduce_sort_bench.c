@@ -0,0 +1,77 @@
+/*
+ * mapreduce microbenchmark: sorting map items by hash using qsort with
+ * comparator against library radix sort, prints ticks spent
+ *
+ * Copyright (c) 2013, LiteStack, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <error.h>
+#include <errno.h>
+#include <assert.h>
+#include <alloca.h>
+
+#include "macro_tests.h"
+#include "map_reduce_lib.h"
+#include "elastic_mr_item.h"
+#include "buffer.h"
+#include "bench_helpers.h"
+
+#define ITEMS_COUNT 1000000
+
+static int s_hash_size;
+
+static int
+ComparatorMrItemQSort(const void *p1, const void *p2){
+    return HashCompareDefault( &((ElasticBufItemData*)p1)->key_hash,
+			       &((ElasticBufItemData*)p2)->key_hash, s_hash_size );
+}
+
+static void
+Bench(int hash_size){
+    Buffer buf;
+    uint64_t start, qsort_ticks, radix_ticks;
+    int ret;
+
+    srand(hash_size);
+    FillBufferRandomHashes( &buf, hash_size, ITEMS_COUNT, 256 );
+    s_hash_size = hash_size;
+    start = ticks();
+    qsort( buf.data, buf.header.count, buf.header.item_size, ComparatorMrItemQSort );
+    qsort_ticks = ticks() - start;
+    FreeBufferData(&buf);
+
+    srand(hash_size);
+    FillBufferRandomHashes( &buf, hash_size, ITEMS_COUNT, 256 );
+    start = ticks();
+    TEST_OPERATION_RESULT( RadixSortByHash( &buf, hash_size ), &ret, ret==0 );
+    radix_ticks = ticks() - start;
+    FreeBufferData(&buf);
+
+    fprintf(stderr, "%d items, hash %d bytes: qsort %llu ticks, radix %llu ticks\n",
+	    ITEMS_COUNT, hash_size, (unsigned long long)qsort_ticks,
+	    (unsigned long long)radix_ticks);
+}
+
+int main(int argc, char**argv){
+    Bench(4);
+    Bench(8);
+    Bench(16);
+    Bench(20);
+    return 0;
+}
@@ -0,0 +1,76 @@
+/*
+ * mmap microbenchmark: allocation of regions in fragmented mmap memory
+ *
+ * Copyright (c) 2013, LiteStack, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <error.h>
+#include <errno.h>
+
+#include "macro_tests.h"
+#include "bench_helpers.h"
+
+/*mapped pages count, every other of them unmapped to get fragmented memory*/
+#define PAGES_COUNT 1024
+#define ITERATIONS 2000
+
+static void* s_pages[PAGES_COUNT];
+
+/*map and unmap region of pages_count pages many times
+ *@return spent ticks*/
+uint64_t bench_map_unmap(int pages_count){
+    int i, ret;
+    size_t length = pages_count*sysconf(_SC_PAGE_SIZE);
+    void* addr;
+    uint64_t start = ticks();
+    for ( i=0; i < ITERATIONS; i++ ){
+	addr = mmap(NULL, length, PROT_READ|PROT_WRITE, MAP_ANONYMOUS|MAP_PRIVATE, -1, 0);
+	TEST_OPERATION_RESULT( addr != MAP_FAILED, &ret, ret==1 );
+	TEST_OPERATION_RESULT( munmap(addr, length), &ret, ret==0 );
+    }
+    return ticks() - start;
+}
+
+int main(int argc, char**argv){
+    int i, ret;
+    size_t pagesize = sysconf(_SC_PAGE_SIZE);
+    for ( i=0; i < PAGES_COUNT; i++ ){
+	s_pages[i] = mmap(NULL, pagesize, PROT_READ|PROT_WRITE, MAP_ANONYMOUS|MAP_PRIVATE, -1, 0);
+	TEST_OPERATION_RESULT( s_pages[i] != MAP_FAILED, &ret, ret==1 );
+    }
+    /*leave holes of single page*/
+    for ( i=0; i < PAGES_COUNT; i+=2 ){
+	TEST_OPERATION_RESULT( munmap(s_pages[i], pagesize), &ret, ret==0 );
+    }
+
+    /*single page fits into the first hole, bigger regions are placed
+      after fragmented area, so search has to pass all holes*/
+    fprintf(stderr, "fragmented mmap, 1 page: %llu ticks\n", 
+	    (unsigned long long)bench_map_unmap(1));
+    fprintf(stderr, "fragmented mmap, 2 pages: %llu ticks\n", 
+	    (unsigned long long)bench_map_unmap(2));
+    fprintf(stderr, "fragmented mmap, 16 pages: %llu ticks\n", 
+	    (unsigned long long)bench_map_unmap(16));
+
+    for ( i=1; i < PAGES_COUNT; i+=2 ){
+	TEST_OPERATION_RESULT( munmap(s_pages[i], pagesize), &ret, ret==0 );
+    }
+    return 0;
+}
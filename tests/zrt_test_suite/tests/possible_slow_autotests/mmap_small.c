@@ -0,0 +1,64 @@
+/*
+ * small anonymous mappings test, prints memory used by them
+ *
+ * Copyright (c) 2013, LiteStack, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <error.h>
+#include <errno.h>
+
+#include "macro_tests.h"
+
+/*typical sizes of thread stacks, allocator arenas and buffers*/
+static size_t s_sizes[] = { 4096, 8192, 12288, 20480, 32768, 100000 };
+#define SIZES_COUNT (sizeof(s_sizes)/sizeof(*s_sizes))
+#define MAPPINGS_COUNT 256
+
+static char* s_maps[SIZES_COUNT][MAPPINGS_COUNT];
+
+int main(int argc, char**argv){
+    int i, j, ret;
+    size_t pagesize = sysconf(_SC_PAGE_SIZE);
+    for ( i=0; i < SIZES_COUNT; i++ ){
+	size_t requested = 0;
+	char* lowest = (char*)UINTPTR_MAX;
+	char* highest = NULL;
+	for ( j=0; j < MAPPINGS_COUNT; j++ ){
+	    s_maps[i][j] = mmap(NULL, s_sizes[i], PROT_READ|PROT_WRITE, 
+				MAP_ANONYMOUS|MAP_PRIVATE, -1, 0);
+	    TEST_OPERATION_RESULT( s_maps[i][j] != MAP_FAILED, &ret, ret==1 );
+	    /*memory is usable*/
+	    s_maps[i][j][s_sizes[i]-1] = 1;
+	    requested += s_sizes[i];
+	    if ( s_maps[i][j] < lowest ) lowest = s_maps[i][j];
+	    if ( s_maps[i][j]+s_sizes[i] > highest ) highest = s_maps[i][j]+s_sizes[i];
+	}
+	/*mappings are placed one by one, so span is memory they took*/
+	fprintf(stderr, "%d mappings of %u bytes: requested %u, span %u, page granularity %u\n",
+		MAPPINGS_COUNT, s_sizes[i], requested, (size_t)(highest-lowest), 
+		MAPPINGS_COUNT*((s_sizes[i]+pagesize-1)/pagesize*pagesize) );
+    }
+    for ( i=0; i < SIZES_COUNT; i++ ){
+	for ( j=0; j < MAPPINGS_COUNT; j++ ){
+	    TEST_OPERATION_RESULT( munmap(s_maps[i][j], s_sizes[i]), &ret, ret==0 );
+	}
+    }
+    return 0;
+}
@@ -0,0 +1,79 @@
+/*
+ * syscalls microbenchmark: cost of cheap syscalls including zrt logging,
+ * compare results of regular and release (make RELEASE=1) zrt builds
+ *
+ * Copyright (c) 2013, LiteStack, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <error.h>
+#include <errno.h>
+
+#include "macro_tests.h"
+#include "bench_helpers.h"
+
+#define ITERATIONS 100000
+#define TEST_FILE "/syscall_overhead.tmp"
+
+static void report(const char* name, uint64_t spent){
+    fprintf(stderr, "%s: %llu ticks per call\n", name, 
+	    (unsigned long long)(spent/ITERATIONS));
+}
+
+int main(int argc, char**argv){
+    int i, ret, memfd, nullfd;
+    char byte = 0;
+    struct stat st;
+    uint64_t start;
+
+    TEST_OPERATION_RESULT( open(TEST_FILE, O_CREAT|O_RDWR, S_IRUSR|S_IWUSR), 
+			   &memfd, memfd!=-1 );
+    TEST_OPERATION_RESULT( write(memfd, &byte, 1), &ret, ret==1 );
+    TEST_OPERATION_RESULT( open("/dev/null", O_WRONLY), &nullfd, nullfd!=-1 );
+
+    start = ticks();
+    for ( i=0; i < ITERATIONS; i++ ){
+	lseek(memfd, 0, SEEK_CUR);
+    }
+    report("memfs lseek", ticks()-start);
+
+    start = ticks();
+    for ( i=0; i < ITERATIONS; i++ ){
+	fstat(memfd, &st);
+    }
+    report("memfs fstat", ticks()-start);
+
+    start = ticks();
+    for ( i=0; i < ITERATIONS; i++ ){
+	pread(memfd, &byte, 1, 0);
+    }
+    report("memfs pread 1 byte", ticks()-start);
+
+    start = ticks();
+    for ( i=0; i < ITERATIONS; i++ ){
+	write(nullfd, &byte, 1);
+    }
+    report("channel /dev/null write 1 byte", ticks()-start);
+
+    TEST_OPERATION_RESULT( close(nullfd), &ret, ret==0 );
+    TEST_OPERATION_RESULT( close(memfd), &ret, ret==0 );
+    TEST_OPERATION_RESULT( unlink(TEST_FILE), &ret, ret==0 );
+    return 0;
+}
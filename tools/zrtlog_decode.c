@@ -0,0 +1,240 @@
+/*
+ * Host side decoder of zrt binary log, see lib/zrtlog_binary.h
+ * build: make tools/zrtlog_decode
+ * usage: zrtlog_decode [logfile], reads stdin if file is not specified
+ *
+ * Copyright (c) 2013, LiteStack, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "zrtlog_binary.h"
+
+#define MAX_CONVERSION_LEN 64
+
+struct LogSite{
+    int   line;
+    char* level;
+    char* file;
+    char* fmt;
+};
+
+static struct LogSite* s_sites;
+static int             s_sites_count;
+
+/*Read whole stream into memory*/
+static char* read_all(FILE* f, size_t* size){
+    size_t capacity = 0x10000, len = 0, res;
+    char* data = malloc(capacity);
+    while ( data != NULL && (res=fread(data+len, 1, capacity-len, f)) > 0 ){
+	len += res;
+	if ( len == capacity ) data = realloc(data, capacity *= 2);
+    }
+    *size = len;
+    return data;
+}
+
+/*Cursor over record args, all getters are returning 0 if args exhausted*/
+struct ArgsReader{
+    const char* data;
+    int         len;
+    int         pos;
+};
+
+static int get_int(struct ArgsReader* reader, uint64_t* value){
+    if ( reader->pos + (int)sizeof(*value) > reader->len ) return 0;
+    memcpy(value, reader->data+reader->pos, sizeof(*value));
+    reader->pos += sizeof(*value);
+    return 1;
+}
+
+/*@return allocated zero terminated string, NULL string is returned as "(null)"*/
+static int get_string(struct ArgsReader* reader, char** str){
+    uint16_t slen;
+    if ( reader->pos + (int)sizeof(slen) > reader->len ) return 0;
+    memcpy(&slen, reader->data+reader->pos, sizeof(slen));
+    reader->pos += sizeof(slen);
+    if ( slen == LOG_BINARY_NULL_STRING ){
+	*str = strdup("(null)");
+	return 1;
+    }
+    if ( reader->pos + slen > reader->len ) return 0;
+    *str = malloc(slen+1);
+    memcpy(*str, reader->data+reader->pos, slen);
+    (*str)[slen] = '\0';
+    reader->pos += slen;
+    return 1;
+}
+
+static void define_site(struct ArgsReader* reader){
+    uint64_t site, line;
+    struct LogSite def;
+    if ( !get_int(reader, &site) || !get_int(reader, &line) ||
+	 !get_string(reader, &def.level) || !get_string(reader, &def.file) ||
+	 !get_string(reader, &def.fmt) ){
+	fprintf(stderr, "bad site definition\n");
+	return;
+    }
+    def.line = (int)line;
+    if ( (int)site >= s_sites_count ){
+	s_sites = realloc(s_sites, (site+1)*sizeof(struct LogSite));
+	memset(s_sites+s_sites_count, '\0', (site+1-s_sites_count)*sizeof(struct LogSite));
+	s_sites_count = site+1;
+    }
+    s_sites[site] = def;
+}
+
+/*Format conversion spec with recorded args, length modifiers are
+ *replaced because integers are recorded as 64bit values*/
+static void print_conversion(FILE* out, const char* fmt, const struct LogFmtSpec* spec,
+			     struct ArgsReader* reader){
+    char conv[MAX_CONVERSION_LEN];
+    int len=0;
+    uint64_t value;
+    const char* p = fmt + spec->offset;
+    const char* end = p + spec->length;
+    if ( spec->type == ELogArgNone ){
+	if ( spec->conv == '%' ) fputc('%', out);
+	else fwrite(p, 1, spec->length, out);
+	return;
+    }
+    if ( spec->type == ELogArgCount ) return;
+    /*copy flags, width and precision, '*' args are substituted*/
+    for ( ; p < end && len < MAX_CONVERSION_LEN-24; p++ ){
+	if ( *p == '*' ){
+	    if ( !get_int(reader, &value) ){ fputs("<?>", out); return; }
+	    len += snprintf(conv+len, MAX_CONVERSION_LEN-len, "%d", (int)value);
+	}
+	else if ( strchr("hlqjztL", *p) != NULL || p == end-1 ) break;
+	else conv[len++] = *p;
+    }
+    switch ( spec->type ){
+    case ELogArgInt:
+    case ELogArgUint:
+	strcpy(conv+len, "ll");
+	len += 2;
+	conv[len++] = spec->conv;
+	conv[len] = '\0';
+	if ( !get_int(reader, &value) ){ fputs("<?>", out); return; }
+	if ( spec->type == ELogArgInt ) fprintf(out, conv, (long long)value);
+	else fprintf(out, conv, (unsigned long long)value);
+	break;
+    case ELogArgDouble:{
+	double d;
+	conv[len++] = spec->conv;
+	conv[len] = '\0';
+	if ( !get_int(reader, &value) ){ fputs("<?>", out); return; }
+	memcpy(&d, &value, sizeof(d));
+	fprintf(out, conv, d);
+	break;
+    }
+    case ELogArgChar:
+	conv[len++] = 'c';
+	conv[len] = '\0';
+	if ( !get_int(reader, &value) ){ fputs("<?>", out); return; }
+	fprintf(out, conv, (int)value);
+	break;
+    case ELogArgPtr:
+	if ( !get_int(reader, &value) ){ fputs("<?>", out); return; }
+	fprintf(out, "0x%llx", (unsigned long long)value);
+	break;
+    case ELogArgStr:{
+	char* str;
+	conv[len++] = 's';
+	conv[len] = '\0';
+	if ( !get_string(reader, &str) ){ fputs("<?>", out); return; }
+	fprintf(out, conv, str);
+	free(str);
+	break;
+    }
+    default:
+	break;
+    }
+}
+
+static void print_record(FILE* out, const struct LogBinaryRecord* record, const char* args){
+    struct ArgsReader reader = { args, record->length, 0 };
+    struct LogFmtSpec spec;
+    const struct LogSite* site;
+    int offset = 0;
+    if ( record->site == LOG_BINARY_SITE_DEFINITION ){
+	define_site(&reader);
+	return;
+    }
+    if ( (int)record->site >= s_sites_count || s_sites[record->site].fmt == NULL ){
+	fprintf(out, "unknown log site %u\n", record->site);
+	return;
+    }
+    site = &s_sites[record->site];
+    /*the same layout as text log has, ticks instead of syscalls stack*/
+    fprintf(out, "%s %s:%d; [%llu]- ", site->level, site->file, site->line,
+	    (unsigned long long)record->ticks);
+    while ( log_binary_next_spec(site->fmt, offset, &spec) ){
+	fwrite(site->fmt+offset, 1, spec.offset-offset, out);
+	print_conversion(out, site->fmt, &spec, &reader);
+	offset = spec.offset + spec.length;
+    }
+    fprintf(out, "%s\n", site->fmt+offset);
+}
+
+/*@return 1 if chunk is found at pos and printed*/
+static int print_chunk(FILE* out, const char* data, size_t size, size_t* pos){
+    struct LogBinaryChunkHeader header;
+    struct LogBinaryRecord record;
+    size_t p, end;
+    if ( *pos + sizeof(header) > size ) return 0;
+    memcpy(&header, data+*pos, sizeof(header));
+    if ( header.magic != LOG_BINARY_MAGIC ) return 0;
+    p = *pos + sizeof(header);
+    end = p + header.length;
+    if ( end > size ){
+	fprintf(stderr, "truncated chunk at offset %llu\n", (unsigned long long)*pos);
+	end = size;
+    }
+    while ( p + sizeof(record) <= end ){
+	memcpy(&record, data+p, sizeof(record));
+	p += sizeof(record);
+	if ( p + record.length > end ) break;
+	print_record(out, &record, data+p);
+	p += record.length;
+    }
+    *pos = end;
+    return 1;
+}
+
+int main(int argc, char** argv){
+    FILE* in = stdin;
+    size_t size, pos = 0;
+    char* data;
+    if ( argc > 1 && (in=fopen(argv[1], "rb")) == NULL ){
+	perror(argv[1]);
+	return 1;
+    }
+    data = read_all(in, &size);
+    if ( data == NULL ){
+	fprintf(stderr, "no memory\n");
+	return 1;
+    }
+    /*text is copied as is, binary chunks are decoded*/
+    while ( pos < size ){
+	if ( !print_chunk(stdout, data, size, &pos) )
+	    fputc(data[pos++], stdout);
+    }
+    free(data);
+    return 0;
+}